@@ -0,0 +1,154 @@
+#ifndef COSTMAP_2D_BUCKET_QUEUE_H_
+#define COSTMAP_2D_BUCKET_QUEUE_H_
+
+#include <algorithm>
+#include <vector>
+
+namespace costmap_2d
+{
+
+/**
+ * @class BucketQueue
+ * @brief Open list of a best-first search, holding element indices in buckets of equal priority width.
+ *
+ * Pushing is O(1). pop() moves to the lowest non-empty bucket and takes the element with the
+ * lowest priority in it, so elements always leave in priority order, and ties leave in the
+ * order they were pushed. Priorities beyond the last bucket share it. The entries of all
+ * buckets live in one pool, linked per bucket, and popped entries are reused, so once the pool
+ * holds as many entries as are queued at the same time the queue does not allocate any more.
+ */
+class BucketQueue
+{
+public:
+  BucketQueue() :
+      min_priority_(0.0), bucket_width_(1.0), current_(0), size_(0), free_(-1)
+  {
+  }
+
+  /**
+   * @brief  Empty the queue and set up its buckets
+   * @param  min_priority The lowest priority that will be pushed
+   * @param  bucket_width The priority range of one bucket
+   * @param  num_buckets The number of buckets
+   */
+  void reset(double min_priority, double bucket_width, unsigned int num_buckets)
+  {
+    buckets_.assign(std::max(num_buckets, 1u), Bucket());
+    entries_.clear();
+    free_ = -1;
+    min_priority_ = min_priority;
+    bucket_width_ = bucket_width;
+    current_ = 0;
+    size_ = 0;
+  }
+
+  /** @brief Make room for a number of elements queued at the same time. */
+  void reserve(unsigned int num_elements)
+  {
+    entries_.reserve(num_elements);
+  }
+
+  bool empty() const
+  {
+    return size_ == 0;
+  }
+
+  unsigned int size() const
+  {
+    return size_;
+  }
+
+  void push(unsigned int element, double priority)
+  {
+    double position = (priority - min_priority_) / bucket_width_;
+    unsigned int b = position <= 0.0 ? 0 : std::min((double)buckets_.size() - 1, position);
+    int e = free_;
+    if (e >= 0)
+    {
+      free_ = entries_[e].next;
+    }
+    else
+    {
+      e = entries_.size();
+      entries_.push_back(Entry());
+    }
+    entries_[e].element = element;
+    entries_[e].priority = priority;
+    entries_[e].next = -1;
+
+    Bucket& bucket = buckets_[b];
+    if (bucket.tail >= 0)
+      entries_[bucket.tail].next = e;
+    else
+      bucket.head = e;
+    bucket.tail = e;
+    current_ = std::min(current_, b);
+    ++size_;
+  }
+
+  /**
+   * @brief  Take the element with the lowest priority out of the queue
+   * @return False if the queue is empty
+   */
+  bool pop(unsigned int& element, double& priority)
+  {
+    if (size_ == 0)
+      return false;
+    while (buckets_[current_].head < 0)
+      ++current_;
+
+    // the entries of a bucket are linked in push order, so the first of equal priorities wins
+    Bucket& bucket = buckets_[current_];
+    int best = bucket.head, before_best = -1;
+    for (int before = bucket.head, e = entries_[before].next; e >= 0; before = e, e = entries_[e].next)
+    {
+      if (entries_[e].priority < entries_[best].priority)
+      {
+        best = e;
+        before_best = before;
+      }
+    }
+    element = entries_[best].element;
+    priority = entries_[best].priority;
+
+    if (before_best >= 0)
+      entries_[before_best].next = entries_[best].next;
+    else
+      bucket.head = entries_[best].next;
+    if (bucket.tail == best)
+      bucket.tail = before_best;
+    entries_[best].next = free_;
+    free_ = best;
+    --size_;
+    return true;
+  }
+
+private:
+  struct Entry
+  {
+    unsigned int element;
+    double priority;
+    int next;  ///< @brief The next entry of the bucket or of the free list, -1 at the end
+  };
+
+  struct Bucket
+  {
+    Bucket() :
+        head(-1), tail(-1)
+    {
+    }
+    int head, tail;
+  };
+
+  std::vector<Bucket> buckets_;
+  std::vector<Entry> entries_;
+  double min_priority_;
+  double bucket_width_;
+  unsigned int current_;
+  unsigned int size_;
+  int free_;  ///< @brief The first entry of the free list, -1 if it is empty
+};
+
+}  // namespace costmap_2d
+
+#endif  // COSTMAP_2D_BUCKET_QUEUE_H_
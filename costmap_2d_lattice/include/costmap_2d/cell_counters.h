@@ -0,0 +1,110 @@
+#ifndef COSTMAP_2D_CELL_COUNTERS_H_
+#define COSTMAP_2D_CELL_COUNTERS_H_
+
+#include <costmap_2d/costmap_2d.h>
+#include <vector>
+
+namespace costmap_2d
+{
+
+/**
+ * @class CellCounters
+ * @brief The number of FREE_SPACE and LETHAL_OBSTACLE cells in every row and every column of a costmap.
+ *
+ * The counters are kept up to date by removing the counts of a window before its cells are
+ * rewritten and adding them back afterwards, so an update only costs as much as the window.
+ * Queries for a single row or column are then O(1).
+ */
+class CellCounters
+{
+public:
+  CellCounters() :
+      valid_(false), size_x_(0), size_y_(0)
+  {
+  }
+
+  /** @brief Count all cells of a map. */
+  void rebuild(const Costmap2D& map);
+
+  /** @brief Mark the counters as stale, e.g. after the cells were changed behind their back. */
+  void invalidate()
+  {
+    valid_ = false;
+  }
+
+  /** @brief True if the counters match the map they were last built or updated for. */
+  bool isValid() const
+  {
+    return valid_;
+  }
+
+  /** @brief Remove the counts of the cells in [x0, xn) x [y0, yn), before they are rewritten. */
+  void remove(const Costmap2D& map, unsigned int x0, unsigned int y0, unsigned int xn, unsigned int yn)
+  {
+    count(map, x0, y0, xn, yn, -1);
+  }
+
+  /** @brief Add the counts of the cells in [x0, xn) x [y0, yn), after they were rewritten. */
+  void add(const Costmap2D& map, unsigned int x0, unsigned int y0, unsigned int xn, unsigned int yn)
+  {
+    count(map, x0, y0, xn, yn, 1);
+  }
+
+  /**
+   * @brief  Move the counters along with the cells, before the origin of the map is moved
+   *
+   * Cell (mx, my) will hold the cell (mx + dx, my + dy) of the map as it is now, and cells that
+   * come in from outside get the default value of the map, as in Costmap2D::updateOrigin().
+   * Only the rows and columns that drop out of the map are read.
+   * @param  map The map before its origin is moved
+   * @param  dx The shift of the origin [cells]
+   * @param  dy The shift of the origin [cells]
+   */
+  void shift(const Costmap2D& map, int dx, int dy);
+
+  unsigned int getSizeInCellsX() const
+  {
+    return size_x_;
+  }
+
+  unsigned int getSizeInCellsY() const
+  {
+    return size_y_;
+  }
+
+  /** @brief The number of FREE_SPACE cells in column mx. */
+  unsigned int getFreeInColumn(unsigned int mx) const
+  {
+    return column_free_[mx];
+  }
+
+  /** @brief The number of LETHAL_OBSTACLE cells in column mx. */
+  unsigned int getLethalInColumn(unsigned int mx) const
+  {
+    return column_lethal_[mx];
+  }
+
+  /** @brief The number of FREE_SPACE cells in row my. */
+  unsigned int getFreeInRow(unsigned int my) const
+  {
+    return row_free_[my];
+  }
+
+  /** @brief The number of LETHAL_OBSTACLE cells in row my. */
+  unsigned int getLethalInRow(unsigned int my) const
+  {
+    return row_lethal_[my];
+  }
+
+private:
+  void count(const Costmap2D& map, unsigned int x0, unsigned int y0, unsigned int xn, unsigned int yn, int sign);
+
+  bool valid_;
+  unsigned int size_x_, size_y_;
+  std::vector<int> row_free_, row_lethal_;
+  std::vector<int> column_free_, column_lethal_;
+};
+
+}  // namespace costmap_2d
+
+#endif  // COSTMAP_2D_CELL_COUNTERS_H_
@@ -40,6 +40,11 @@
 
 #include <vector>
 #include <queue>
+#include <string>
+#include <cstdlib>
+#include <cstring>
+#include <climits>
+#include <cmath>
 #include <geometry_msgs/Point.h>
 #include <boost/thread.hpp>
 #include<algorithm>
@@ -103,6 +108,16 @@ public:
    */
   Costmap2D();
 
+  /**
+   * @brief  Map a file written by saveBinaryMap() into memory instead of reading it
+   *
+   * The cells are read from the file as they are first touched, so a map of any size is
+   * ready at once. The file is never written to, a cell that is set gets a private copy of
+   * its page. If the file cannot be mapped, the map is left empty, see isMapped().
+   * @param file_name The name of the file to map
+   */
+  explicit Costmap2D(const std::string& file_name);
+
   /**
    * @brief  Destructor
    */
@@ -239,7 +254,7 @@ public:
     default_value_ = c;
   }
 
-  unsigned char getDefaultValue()
+  unsigned char getDefaultValue() const
   {
     return default_value_;
   }
@@ -279,6 +294,26 @@ public:
    */
   bool saveMap(std::string file_name);
 
+  /**
+   * @brief  Save the costmap to a binary file, a page of header with the size, resolution and
+   * origin, then the cells as they are in memory
+   * @param file_name The name of the file to save
+   */
+  bool saveBinaryMap(std::string file_name);
+
+  /**
+   * @brief  Resize the costmap to a file written by saveBinaryMap() and read its cells
+   * @param file_name The name of the file to load
+   * @return False if the file cannot be read or is no binary costmap, the map is unchanged then
+   */
+  bool loadBinaryMap(std::string file_name);
+
+  /** @brief True if the cells are those of a file mapped into memory by the file constructor. */
+  bool isMapped() const
+  {
+    return mapped_file_ != NULL;
+  }
+
   void resizeMap(unsigned int size_x, unsigned int size_y, double resolution, double origin_x,
                  double origin_y);
 
@@ -331,6 +366,44 @@ protected:
       }
     }
 
+  /**
+   * @brief  Move the contents of a map in place by whole cells, the cell (x, y) gets the old cell
+   *         (x + cell_ox, y + cell_oy) and the cells that come in from outside get a fill value
+   * @param  map The map, size_x_ by size_y_ cells
+   * @param  cell_ox The shift of the window along x [cells]
+   * @param  cell_oy The shift of the window along y [cells]
+   * @param  fill_value The value of the cells that were outside the old window
+   */
+  template<typename data_type>
+    void shiftMapRegion(data_type* map, int cell_ox, int cell_oy, data_type fill_value)
+    {
+      int size_x = size_x_, size_y = size_y_;
+      if (abs(cell_ox) >= size_x || abs(cell_oy) >= size_y)
+      {
+        std::fill(map, map + size_x * size_y, fill_value);
+        return;
+      }
+
+      // the rows are moved in an order that reads every source row before it is overwritten,
+      // memmove() takes care of the overlap within a row
+      int row_size = size_x - abs(cell_ox);
+      int dest_x = std::max(-cell_ox, 0), source_x = std::max(cell_ox, 0);
+      int first = cell_oy >= 0 ? 0 : size_y - 1, last = cell_oy >= 0 ? size_y : -1, step = cell_oy >= 0 ? 1 : -1;
+      for (int y = first; y != last; y += step)
+      {
+        data_type* row = map + y * size_x;
+        int source_y = y + cell_oy;
+        if (source_y < 0 || source_y >= size_y)
+        {
+          std::fill(row, row + size_x, fill_value);
+          continue;
+        }
+        memmove(row + dest_x, map + source_y * size_x + source_x, row_size * sizeof(data_type));
+        std::fill(row, row + dest_x, fill_value);
+        std::fill(row + dest_x + row_size, row + size_x, fill_value);
+      }
+    }
+
   /**
    * @brief  Deletes the costmap, static_map, and markers data structures
    */
@@ -350,6 +423,10 @@ protected:
 
   /**
    * @brief  Raytrace a line and apply some action at each step
+   *
+   * The action is told the number of steps of the line with start(num_steps) and then applied
+   * to num_steps + 1 cells with operator()(offset), the last cell twice, so an action can ramp
+   * a value along the line in integer steps, see MarkCell.
    * @param  at The action to take... a functor
    * @param  x0 The starting x coordinate
    * @param  y0 The starting y coordinate
@@ -372,23 +449,42 @@ protected:
 
       unsigned int offset = y0 * size_x_ + x0;
 
-      // we need to chose how much to scale our dominant dimension, based on the maximum length of the line
-      double dist = hypot(dx, dy);
-      double scale = (dist == 0.0) ? 1.0 : std::min(1.0, max_length / dist);
+      // we need to chose how much to scale our dominant dimension, based on the maximum length of the line,
+      // whether it is longer than that is decided on the squared lengths, so most lines take no square root
+      unsigned long long dist_sq = (unsigned long long)abs_dx * abs_dx + (unsigned long long)abs_dy * abs_dy;
+      bool clipped = (unsigned long long)max_length * max_length < dist_sq;
+      double scale = clipped ? max_length / sqrt((double)dist_sq) : 1.0;
 
       // if x is dominant
       if (abs_dx >= abs_dy)
       {
         int error_y = abs_dx / 2;
-        bresenham2D(at, abs_dx, abs_dy, error_y, offset_dx, offset_dy, offset, (unsigned int)(scale * abs_dx));
+        bresenham2D(at, abs_dx, abs_dy, error_y, offset_dx, offset_dy, offset,
+                    clipped ? (unsigned int)(scale * abs_dx) : abs_dx);
         return;
       }
 
       // otherwise y is dominant
       int error_x = abs_dy / 2;
-      bresenham2D(at, abs_dy, abs_dx, error_x, offset_dy, offset_dx, offset, (unsigned int)(scale * abs_dy));
+      bresenham2D(at, abs_dy, abs_dx, error_x, offset_dy, offset_dx, offset,
+                  clipped ? (unsigned int)(scale * abs_dy) : abs_dy);
     }
 
+  /**
+   * @brief  Raytrace a line with the ramp of MarkCell up to a value
+   *
+   * The ramp only ever raises cells, so a ramp to 0, the FREE_SPACE clear of the obstacle layer,
+   * leaves every cell as it is and is not traced at all.
+   */
+  inline void markLine(unsigned char value, unsigned int x0, unsigned int y0, unsigned int x1, unsigned int y1,
+                       unsigned int max_length = UINT_MAX)
+  {
+    if (value == 0)
+      return;
+    MarkCell marker(costmap_, value);
+    raytraceLine(marker, x0, y0, x1, y1, max_length);
+  }
+
 private:
   /**
    * @brief  A 2D implementation of Bresenham's raytracing algorithm... applies an action at each step
@@ -398,11 +494,10 @@ private:
                             int offset_b, unsigned int offset, unsigned int max_length)
     {
       unsigned int end = std::min(max_length, abs_da);
-      double value_scale=0.0;
+      at.start(end);
       for (unsigned int i = 0; i < end; ++i)
       {
-        value_scale=(i)/(end*1.0);
-        at(offset,value_scale);
+        at(offset);
         offset += offset_a;
         error_b += abs_db;
         if ((unsigned int)error_b >= abs_da)
@@ -411,7 +506,7 @@ private:
           error_b -= abs_da;
         }
       }
-      at(offset,value_scale);
+      at(offset);
     }
 
   inline int sign(int x)
@@ -419,7 +514,12 @@ private:
     return x > 0 ? 1.0 : -1.0;
   }
 
+  /** @brief Free the cost array, or unmap it if it belongs to a mapped file. */
+  void releaseCostArray();
+
   mutex_t* access_;
+  void* mapped_file_;  ///< @brief The mapping that holds the cost array, NULL if it is allocated
+  size_t mapped_length_;
 protected:
   unsigned int size_x_;
   unsigned int size_y_;
@@ -429,24 +529,51 @@ protected:
   unsigned char* costmap_;
   unsigned char default_value_;
 
+  /**
+   * @brief Raises the cells of a line to a value that grows from 0 at its start towards value_ at its end.
+   *
+   * Step i of a line of n steps gets value_ * i / n rounded down, kept as a whole part and an
+   * error term like the minor axis of the line itself, so a cell costs no division and no float
+   * conversion. The last cell repeats the value of the step before it.
+   */
   class MarkCell
   {
   public:
     MarkCell(unsigned char* costmap, unsigned char value) :
-        costmap_(costmap), value_(value)
+        costmap_(costmap), value_(value), current_(0), whole_(0), remainder_(0), error_(0), num_steps_(0),
+        remaining_(0)
     {
     }
-    inline void operator()(unsigned int offset, double value_scale)//DLSH added
+    inline void start(unsigned int num_steps)
     {
-      if(costmap_[offset]>0){
-      costmap_[offset] = std::max(costmap_[offset],(unsigned char)(value_scale*value_));}
-      else{
-        costmap_[offset]=value_scale*value_;
+      num_steps_ = num_steps;
+      whole_ = num_steps > 0 ? value_ / num_steps : 0;
+      remainder_ = num_steps > 0 ? value_ % num_steps : 0;
+      current_ = 0;
+      error_ = 0;
+      remaining_ = num_steps;
+    }
+    inline void operator()(unsigned int offset)//DLSH added
+    {
+      costmap_[offset] = std::max(costmap_[offset], current_);
+      if (remaining_ > 1)
+      {
+        --remaining_;
+        current_ += whole_;
+        error_ += remainder_;
+        if (error_ >= num_steps_)
+        {
+          ++current_;
+          error_ -= num_steps_;
+        }
       }
     }
   private:
     unsigned char* costmap_;
     unsigned char value_;
+    unsigned char current_;
+    unsigned char whole_;
+    unsigned int remainder_, error_, num_steps_, remaining_;
   };
 
   class PolygonOutlineCells
@@ -457,8 +584,12 @@ protected:
     {
     }
 
+    inline void start(unsigned int)
+    {
+    }
+
     // just push the relevant cells back onto the list
-    inline void operator()(unsigned int offset, double value_scale)//No need, just for compile
+    inline void operator()(unsigned int offset)
     {
       MapLocation loc;
       costmap_.indexToCells(offset, loc.x, loc.y);
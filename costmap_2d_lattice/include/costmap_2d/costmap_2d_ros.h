@@ -49,6 +49,7 @@
 #include <dynamic_reconfigure/server.h>
 #include <pluginlib/class_loader.hpp>
 #include <tf2/LinearMath/Transform.h>
+#include <boost/noncopyable.hpp>
 #include "std_msgs/Float32MultiArray.h"
 #include "std_msgs/Int8.h"
 class SuperValue : public XmlRpc::XmlRpcValue
@@ -107,6 +108,15 @@ public:
 
   void updateMap();
 
+  /**
+   * @brief  Block until the master costmap was updated after a given update
+   * @param  epoch The number of the last update the caller has seen, set to the number of the new update
+   * @param  stamp Will be set to the time the new update started, no sensor data newer than that is in the map
+   * @param  timeout The longest time to wait [s]
+   * @return False if no new update finished before the timeout
+   */
+  bool waitForUpdate(unsigned long& epoch, ros::Time& stamp, double timeout);
+
   /**
    * @brief Reset each individual layer
    */
@@ -196,9 +206,18 @@ public:
    * on the "footprint" topic. */
   std::vector<geometry_msgs::Point> getRobotFootprint() const
   {
+    boost::mutex::scoped_lock lock(footprint_mutex_);
     return padded_footprint_;
   }
 
+  /**
+   * @brief  Copy the padded footprint into a vector kept by the caller if it changed since the caller's copy
+   * @param  footprint The caller's copy of the footprint
+   * @param  version The version of the caller's copy, 0 for none, set to the version of the footprint
+   * @return True if the footprint was copied
+   */
+  bool updateRobotFootprint(std::vector<geometry_msgs::Point>& footprint, unsigned long& version) const;
+
   /** @brief Return the current unpadded footprint of the robot as a vector of points.
    *
    * This is the raw version of the footprint without padding.
@@ -278,12 +297,19 @@ private:
 
   boost::recursive_mutex configuration_mutex_;
 
+  boost::mutex update_mutex_;  ///< @brief Guards update_epoch_ and update_stamp_
+  boost::condition_variable update_cond_;  ///< @brief Notified after every finished map update
+  unsigned long update_epoch_;  ///< @brief The number of finished map updates
+  ros::Time update_stamp_;  ///< @brief The start time of the last finished map update
+
   ros::Subscriber footprint_sub_;
   ros::Subscriber carPose_sub_;
   ros::Subscriber mapSwitch_sub_;
   ros::Publisher footprint_pub_;
   std::vector<geometry_msgs::Point> unpadded_footprint_;
   std::vector<geometry_msgs::Point> padded_footprint_;
+  mutable boost::mutex footprint_mutex_;  ///< @brief Guards padded_footprint_ and footprint_version_
+  unsigned long footprint_version_;  ///< @brief The number of changes of the footprint
   float footprint_padding_;
   costmap_2d::Costmap2DConfig old_config_;
 
@@ -291,6 +317,39 @@ private:
   int map_switch;
 };
 // class Costmap2DROS
+
+/**
+ * @class Costmap2DReadView
+ * @brief Scoped, read-only view of the master costmap of a Costmap2DROS.
+ *
+ * The view holds the master costmap's mutex for its whole lifetime, so the map update
+ * thread cannot modify, resize or move the map while it is alive. All reads made through
+ * one view therefore see the same consistent map, without copying the cost array.
+ * Keep the view short-lived: the costmap is not updated while it exists.
+ */
+class Costmap2DReadView : private boost::noncopyable
+{
+public:
+  explicit Costmap2DReadView(const Costmap2DROS& costmap_ros) :
+      costmap_(costmap_ros.getCostmap()),
+      lock_(*(costmap_->getMutex()))
+  {
+  }
+
+  const Costmap2D& operator*() const
+  {
+    return *costmap_;
+  }
+
+  const Costmap2D* operator->() const
+  {
+    return costmap_;
+  }
+
+private:
+  Costmap2D* costmap_;
+  boost::unique_lock<Costmap2D::mutex_t> lock_;
+};
 }  // namespace costmap_2d
 
 #endif  // COSTMAP_2D_COSTMAP_2D_ROS_H
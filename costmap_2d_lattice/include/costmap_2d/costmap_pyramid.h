@@ -0,0 +1,133 @@
+#ifndef COSTMAP_2D_COSTMAP_PYRAMID_H_
+#define COSTMAP_2D_COSTMAP_PYRAMID_H_
+
+#include <costmap_2d/costmap_2d.h>
+#include <vector>
+
+namespace costmap_2d
+{
+
+/**
+ * @class CostmapPyramid
+ * @brief Max-pooled levels of a costmap, level l holds the highest cost of every block of 2^l x 2^l cells.
+ *
+ * Level 0 is the costmap itself and is not stored. Every level is pooled from the one below, so
+ * an update of a window of cells only recomputes the blocks above that window. A query for the
+ * highest cost in a window then takes a few blocks of a coarse level instead of every cell.
+ * NO_INFORMATION is the highest cost and is pooled like any other.
+ *
+ * The blocks stay on the cells they were pooled from when a rolling window moves the map, so
+ * every level moves in place by the whole blocks it crossed and only the blocks at the edges
+ * are pooled anew. The rest of the move is kept as the phase: block 0 of level l starts
+ * getPhaseX() % 2^l cells before cell 0, and likewise along y.
+ */
+class CostmapPyramid
+{
+public:
+  CostmapPyramid() :
+      valid_(false), num_levels_(0), size_x_(0), size_y_(0), phase_x_(0), phase_y_(0)
+  {
+  }
+
+  /** @brief Set the number of pooled levels above the costmap, the pyramid is stale until rebuilt. */
+  void setNumLevels(unsigned int num_levels);
+
+  unsigned int getNumLevels() const
+  {
+    return num_levels_;
+  }
+
+  /** @brief Pool all levels from a map, with a phase of 0. */
+  void rebuild(const Costmap2D& map);
+
+  /** @brief Mark the pyramid as stale, e.g. after the cells were changed or moved behind its back. */
+  void invalidate()
+  {
+    valid_ = false;
+  }
+
+  /** @brief True if the pyramid matches the map it was last built or updated for. */
+  bool isValid() const
+  {
+    return valid_;
+  }
+
+  /** @brief Pool the blocks above the cells in [x0, xn) x [y0, yn) anew, after they were rewritten. */
+  void update(const Costmap2D& map, unsigned int x0, unsigned int y0, unsigned int xn, unsigned int yn);
+
+  /**
+   * @brief  Follow the cells after Costmap2D::updateOrigin() moved them, cell (x, y) holding the old
+   *         cell (x + dx, y + dy), and pool the blocks over the edges anew
+   * @param  map The map after the move
+   */
+  void shift(const Costmap2D& map, int dx, int dy);
+
+  /** @brief The size of the costmap the pyramid was built for [cells]. */
+  unsigned int getSizeInCellsX() const
+  {
+    return size_x_;
+  }
+
+  unsigned int getSizeInCellsY() const
+  {
+    return size_y_;
+  }
+
+  /** @brief The number of cells block 0 of the top level starts before cell 0. */
+  unsigned int getPhaseX() const
+  {
+    return phase_x_;
+  }
+
+  unsigned int getPhaseY() const
+  {
+    return phase_y_;
+  }
+
+  /** @brief The number of blocks of a level from 1 to getNumLevels() along x. */
+  unsigned int getSizeInBlocksX(unsigned int level) const
+  {
+    return level_size_x_[level - 1];
+  }
+
+  unsigned int getSizeInBlocksY(unsigned int level) const
+  {
+    return level_size_y_[level - 1];
+  }
+
+  /** @brief The highest cost of the cells of block (bx, by) of a level from 1 to getNumLevels(). */
+  unsigned char getCost(unsigned int level, unsigned int bx, unsigned int by) const
+  {
+    return levels_[level - 1][by * level_stride_x_[level - 1] + bx];
+  }
+
+  /**
+   * @brief  An upper bound of the highest cost of the cells in [x0, xn) x [y0, yn)
+   *
+   * The window is clipped to the map and covered by at most 3 x 3 blocks of the coarsest
+   * level whose blocks are not larger than the window, so the bound may include cells around
+   * the window. It is exact if the window is made of whole blocks of that level.
+   * @return 0 for a window outside the map, the highest cost if there are no levels
+   */
+  unsigned char getMaxCost(int x0, int y0, int xn, int yn) const;
+
+private:
+  /** @brief Pool the blocks [bx0, bxn) x [by0, byn) of a level from the level below, or from the map for level 1. */
+  void pool(const Costmap2D& map, unsigned int level, unsigned int bx0, unsigned int by0, unsigned int bxn,
+            unsigned int byn);
+
+  /** @brief Set the number of blocks of every level from the size and the phase. */
+  void updateLevelSizes();
+
+  bool valid_;
+  unsigned int num_levels_;
+  unsigned int size_x_, size_y_;
+  unsigned int phase_x_, phase_y_;  ///< @brief Below 2^num_levels_
+  std::vector<std::vector<unsigned char> > levels_;  ///< @brief Level l at l - 1, rows of level_stride_x_ blocks
+  std::vector<unsigned int> level_size_x_, level_size_y_;
+  std::vector<unsigned int> level_stride_x_, level_stride_y_;  ///< @brief Room for the blocks of any phase
+};
+
+}  // namespace costmap_2d
+
+#endif  // COSTMAP_2D_COSTMAP_PYRAMID_H_
@@ -0,0 +1,77 @@
+#ifndef COSTMAP_2D_COSTMAP_SNAPSHOT_H_
+#define COSTMAP_2D_COSTMAP_SNAPSHOT_H_
+
+#include <costmap_2d/cell_counters.h>
+#include <costmap_2d/costmap_2d.h>
+#include <costmap_2d/costmap_pyramid.h>
+
+namespace costmap_2d
+{
+
+class LayeredCostmap;
+
+/**
+ * @class CostmapSnapshot
+ * @brief A copy of the master costmap as it was at the end of one update, published by LayeredCostmap.
+ *
+ * A snapshot does not change while anyone holds a pointer to it, so it is read without the
+ * costmap's mutex, and a reader neither waits for the update loop nor holds it up. Besides the
+ * cells it carries the row and column counters, the pyramid and the world bounds changed by the last
+ * updates, numbered by epoch, so a reader can tell what changed since the snapshot it read before.
+ */
+class CostmapSnapshot
+{
+public:
+  /** @brief The number of updates whose changed bounds a snapshot keeps. */
+  static const unsigned int HISTORY = 16;
+
+  CostmapSnapshot();
+
+  const Costmap2D& getCostmap() const
+  {
+    return costmap_;
+  }
+
+  /** @brief The row and column counters of the cells, NULL if the master costmap does not track them. */
+  const CellCounters* getCellCounters() const
+  {
+    return counters_.isValid() ? &counters_ : NULL;
+  }
+
+  /** @brief The max-pooled pyramid of the cells, NULL if the master costmap has none or it is stale. */
+  const CostmapPyramid* getPyramid() const
+  {
+    return pyramid_.getNumLevels() > 0 && pyramid_.isValid() ? &pyramid_ : NULL;
+  }
+
+  /** @brief The number of the update this snapshot was taken after, counted from 1. */
+  unsigned long getEpoch() const
+  {
+    return epoch_;
+  }
+
+  /**
+   * @brief  Get the world area changed by the updates after an earlier snapshot up to this one
+   *
+   * The same area as LayeredCostmap::takeChangedBounds() would collect between the two snapshots,
+   * but without taking it from the master costmap, so any number of readers may ask.
+   * @param  epoch The epoch of the earlier snapshot, 0 for none
+   * @return False if the whole map has to be considered changed, e.g. after a resize or if the
+   * earlier snapshot is more than HISTORY updates old
+   */
+  bool getChangedBoundsSince(unsigned long epoch, double& minx, double& miny, double& maxx, double& maxy) const;
+
+private:
+  friend class LayeredCostmap;
+
+  Costmap2D costmap_;
+  CellCounters counters_;
+  CostmapPyramid pyramid_;
+  unsigned long epoch_;
+  unsigned long full_change_epoch_;  ///< @brief The last epoch that changed the whole map
+  double changed_[HISTORY][4];       ///< @brief The bounds changed by epoch e at e % HISTORY, minx, miny, maxx, maxy
+};
+
+}  // namespace costmap_2d
+
+#endif  // COSTMAP_2D_COSTMAP_SNAPSHOT_H_
@@ -0,0 +1,105 @@
+#ifndef COSTMAP_2D_FOOTPRINT_CHECKER_H_
+#define COSTMAP_2D_FOOTPRINT_CHECKER_H_
+
+#include <costmap_2d/costmap_2d.h>
+#include <geometry_msgs/Point.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace costmap_2d
+{
+
+/**
+ * @class FootprintChecker
+ * @brief Looks up the costs under the oriented robot footprint with precomputed cell stamps.
+ *
+ * setFootprint() rasterizes the footprint once for every heading bin and every sub-cell
+ * position of the reference point, using the outline plus fill rule of
+ * Costmap2D::setConvexPolygonCost(). A lookup then only visits the stored cell offsets around
+ * the cell of the pose, and stops at the first LETHAL_OBSTACLE.
+ */
+class FootprintChecker
+{
+public:
+  FootprintChecker();
+
+  /**
+   * @brief  Precompute the stamps of a footprint, does nothing if the footprint and resolution did not change
+   * @param  footprint The footprint polygon in the robot frame
+   * @param  resolution The resolution of the costmaps that will be checked [m/cell]
+   * @param  num_headings The number of heading bins over a full turn
+   * @param  num_phases The number of sub-cell positions per axis
+   */
+  void setFootprint(const std::vector<geometry_msgs::Point>& footprint, double resolution,
+                    unsigned int num_headings = 72, unsigned int num_phases = 4);
+
+  bool isConfigured() const
+  {
+    return !stamp_begin_.empty();
+  }
+
+  double getResolution() const
+  {
+    return resolution_;
+  }
+
+  /**
+   * @brief  Get the highest cost under the footprint at a pose
+   * @param  map The costmap to check, must have the resolution the stamps were built for
+   * @return The highest cost of the cells inside the map, LETHAL_OBSTACLE as soon as one is found
+   */
+  unsigned char footprintCost(const Costmap2D& map, double x, double y, double theta) const;
+
+  /**
+   * @brief  Get the highest cost under the footprint swept from one pose to the next
+   *
+   * The poses in between are interpolated so that consecutive checks are at most half a cell
+   * and one heading bin apart. The start pose itself is not checked.
+   * @return The highest cost found, LETHAL_OBSTACLE as soon as one is found
+   */
+  unsigned char sweptCost(const Costmap2D& map, double x0, double y0, double theta0, double x1, double y1,
+                          double theta1) const;
+
+  /**
+   * @brief  Get the cell and the stamp of a pose, poses with the same cell and stamp cover the same cells
+   * @param  mx, my The cell of the reference point, may lie outside the map
+   */
+  void getStamp(const Costmap2D& map, double x, double y, double theta, int& mx, int& my,
+                unsigned int& stamp) const;
+
+  /** @brief The highest cost under a stamp placed at a cell, LETHAL_OBSTACLE as soon as one is found. */
+  unsigned char stampCost(const Costmap2D& map, int mx, int my, unsigned int stamp) const;
+
+  /** @brief The furthest any stamp reaches from the cell of its pose along x or y [cells]. */
+  int getMaxOffset() const
+  {
+    return max_offset_;
+  }
+
+  /** @brief The number of poses sweptCost() checks between two poses a distance [m] and a turn [rad] apart. */
+  unsigned int getNumSweptChecks(double distance, double d_theta) const
+  {
+    unsigned int num_checks = std::max((unsigned int)ceil(distance / (0.5 * resolution_)),
+                                       (unsigned int)ceil(fabs(d_theta) * num_headings_ / (2 * M_PI)));
+    return std::max(num_checks, 1u);
+  }
+
+private:
+  /** @brief Rasterize the footprint rotated by an angle with the reference point at a position inside its cell. */
+  void rasterize(double angle, double phase_x, double phase_y);
+
+  std::vector<geometry_msgs::Point> footprint_;
+  double resolution_;
+  unsigned int num_headings_;
+  unsigned int num_phases_;
+
+  // stamp s covers offsets_[stamp_begin_[s]] ... offsets_[stamp_begin_[s + 1] - 1], as (dx, dy) pairs
+  std::vector<unsigned int> stamp_begin_;
+  std::vector<int> offsets_;
+  int max_offset_;
+};
+
+}  // namespace costmap_2d
+
+#endif  // COSTMAP_2D_FOOTPRINT_CHECKER_H_
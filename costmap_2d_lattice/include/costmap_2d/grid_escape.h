@@ -0,0 +1,104 @@
+#ifndef COSTMAP_2D_GRID_ESCAPE_H_
+#define COSTMAP_2D_GRID_ESCAPE_H_
+
+#include <costmap_2d/bucket_queue.h>
+#include <costmap_2d/cost_values.h>
+#include <costmap_2d/costmap_2d.h>
+#include <vector>
+
+namespace costmap_2d
+{
+
+/**
+ * @class GridEscape
+ * @brief Grid A* on the costmap, the fallback of the lattice planner when every primitive is blocked.
+ *
+ * The search runs 8-connected over the cells of the map, so it never leaves the rolling window.
+ * A cell at or above the blocked cost is not entered, except to walk down the inflation from a
+ * start inside it. A step costs its length, raised by the cost of the cell entered, and the
+ * heuristic is the octile distance to the goal, which may lie outside the map. The search stops
+ * at the goal cell, after a number of expansions or at a time limit, and then returns the path to
+ * the expanded cell closest to the goal, so it always has an escape from the start.
+ *
+ * The cost, parent and generation of every cell are kept between searches and a cell counts as
+ * unvisited unless its generation is the current one, so a search does not clear them, and
+ * nothing is allocated unless the size of the map changes.
+ */
+class GridEscape
+{
+public:
+  GridEscape();
+
+  /**
+   * @brief  Set the limits of a search
+   * @param  node_budget The maximum number of expansions
+   * @param  time_budget The maximum duration of a search [s], 0 for no limit
+   * @param  blocked_cost The lowest cell cost that is not entered
+   * @param  cost_weight The step cost factor added per unit of cell cost / 100
+   */
+  void configure(unsigned int node_budget, double time_budget, unsigned char blocked_cost, double cost_weight);
+
+  /** @brief Size the cells of a search for a map, search() does so on its own, but may then allocate. */
+  void resize(unsigned int size_x, unsigned int size_y);
+
+  /**
+   * @brief  Search a path from a start to a goal in world coordinates
+   * @return False if the start is outside the map or no cell closer to the goal than the start was reached
+   */
+  bool search(const Costmap2D& map, double start_x, double start_y, double goal_x, double goal_y);
+
+  /** @brief The cell centers of the path of the last search, from the start on [m]. */
+  const std::vector<double>& getPathX() const
+  {
+    return path_x_;
+  }
+
+  const std::vector<double>& getPathY() const
+  {
+    return path_y_;
+  }
+
+  /** @brief True if the last search reached the goal cell. */
+  bool reachedGoal() const
+  {
+    return reached_goal_;
+  }
+
+  unsigned int getNumExpanded() const
+  {
+    return num_expanded_;
+  }
+
+  /**
+   * @brief  The point of the path at a distance along it from the start, the end of the path if it is shorter
+   * @return False if the last search found no path
+   */
+  bool getLookahead(double distance, double& x, double& y) const;
+
+private:
+  /** @brief True if a search may step from a cell of cost from into a cell of cost to. */
+  bool canEnter(unsigned char from, unsigned char to) const
+  {
+    return to < blocked_cost_ || (to != LETHAL_OBSTACLE && from >= blocked_cost_ && to <= from);
+  }
+
+  unsigned int node_budget_;
+  double time_budget_;
+  unsigned char blocked_cost_;
+  double cost_weight_;
+
+  std::vector<double> g_;
+  std::vector<int> parent_;
+  std::vector<unsigned int> generation_;  ///< @brief A cell is unvisited unless it equals generation_now_
+  std::vector<unsigned int> closed_;      ///< @brief A cell is expanded if it equals generation_now_
+  unsigned int generation_now_;
+  BucketQueue open_;
+
+  std::vector<double> path_x_, path_y_;
+  bool reached_goal_;
+  unsigned int num_expanded_;
+};
+
+}  // namespace costmap_2d
+
+#endif  // COSTMAP_2D_GRID_ESCAPE_H_
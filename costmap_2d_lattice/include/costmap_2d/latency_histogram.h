@@ -0,0 +1,65 @@
+#ifndef COSTMAP_2D_LATENCY_HISTOGRAM_H_
+#define COSTMAP_2D_LATENCY_HISTOGRAM_H_
+
+#include <boost/atomic.hpp>
+#include <boost/noncopyable.hpp>
+
+namespace costmap_2d
+{
+
+/** @brief The counts of a LatencyHistogram over one period, taken out of the histogram at once. */
+struct LatencySnapshot
+{
+  static const unsigned int NUM_BUCKETS = 85;
+
+  LatencySnapshot();
+
+  /** @brief The upper edge of the bucket that holds the q-th quantile, q in [0, 1] [s], 0 if nothing was recorded. */
+  double percentile(double q) const;
+
+  double mean() const
+  {
+    return count > 0 ? sum / count : 0.0;
+  }
+
+  unsigned int counts[NUM_BUCKETS];
+  unsigned int count;
+  double sum;  ///< @brief [s]
+  double max;  ///< @brief [s]
+};
+
+/**
+ * @class LatencyHistogram
+ * @brief A histogram of durations that any thread can record into without taking a lock.
+ *
+ * The buckets are spaced four per octave from 1 us to about 2 s, so a percentile read from
+ * the histogram is at most 25% above the true value. Recording is a few relaxed atomic
+ * increments, and take() moves the counts into a snapshot and starts over from zero, so
+ * a reader sees the durations of its own period only.
+ */
+class LatencyHistogram : private boost::noncopyable
+{
+public:
+  LatencyHistogram();
+
+  /** @brief Count a duration [s]. */
+  void record(double seconds);
+
+  /** @brief Move the counts recorded since the last take() into a snapshot. */
+  void take(LatencySnapshot& snapshot);
+
+  /** @brief The bucket a duration is counted in. */
+  static unsigned int getBucket(double seconds);
+
+  /** @brief The upper edge of a bucket [s]. */
+  static double getBucketLimit(unsigned int bucket);
+
+private:
+  boost::atomic<unsigned int> counts_[LatencySnapshot::NUM_BUCKETS];
+  boost::atomic<unsigned long long> sum_;  ///< @brief [ns]
+  boost::atomic<unsigned long long> max_;  ///< @brief [ns]
+};
+
+}  // namespace costmap_2d
+
+#endif  // COSTMAP_2D_LATENCY_HISTOGRAM_H_
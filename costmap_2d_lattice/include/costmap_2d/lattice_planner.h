@@ -0,0 +1,381 @@
+#ifndef COSTMAP_2D_LATTICE_PLANNER_H_
+#define COSTMAP_2D_LATTICE_PLANNER_H_
+
+#include <costmap_2d/cell_counters.h>
+#include <costmap_2d/costmap_pyramid.h>
+#include <costmap_2d/costmap_2d.h>
+#include <costmap_2d/footprint_checker.h>
+#include <costmap_2d/grid_escape.h>
+#include <costmap_2d/lattice_search.h>
+#include <costmap_2d/motion_primitives.h>
+#include <costmap_2d/primitive_cache.h>
+#include <costmap_2d/reference_path.h>
+#include <costmap_2d/worker_pool.h>
+#include <geometry_msgs/Point.h>
+#include <ros/time.h>
+#include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include <vector>
+
+namespace costmap_2d
+{
+
+/**
+ * @brief The parameters of the lattice planner, read from the parameter server by the node
+ * and stored in the header of a planner log, so a replay plans with the same settings.
+ */
+struct LatticePlannerConfig
+{
+  LatticePlannerConfig() :
+      time_step(0.1), horizon(2.5), use_footprint_check(true), use_primitive_cache(false), cache_max_speed(10.0),
+      cache_speed_resolution(0.5), cache_steering_resolution(0.5 * 3.141592653589793238463 / 180),
+      goal_lookahead(10.0), use_warm_start(true), warm_start_replan_period(0.5), warm_start_max_deviation(0.5),
+      warm_start_hysteresis(0.5), search_depth(1), search_stage_time(1.0), search_node_budget(500),
+      search_path_weight(1.0), use_longitudinal_product(false), cof_break(0.1), target_speed(4.5),
+      weight_speed(1.0), weight_effort(0.5), num_threads(0), use_branch_and_bound(false), plan_deadline(0.0),
+      anytime_coarse_stride(3), use_escape_search(true), escape_node_budget(20000), escape_time_budget(0.01),
+      escape_lookahead(3.0), pose_sigma_xy(0.0), pose_sigma_theta(0.0), hypothesis_worst_weight(0.5)
+  {
+  }
+
+  std::vector<double> steering_targets;  ///< @brief The steering targets of the primitives [rad]
+  double time_step;                      ///< @brief Integration step of the rollouts [s]
+  double horizon;                        ///< @brief Length of the rollouts [s]
+  bool use_footprint_check;              ///< @brief Check the swept footprint instead of the cell under each sample
+  bool use_primitive_cache;              ///< @brief Look the rollouts up in a body-frame cache
+  double cache_max_speed;                ///< @brief Highest cached start speed [m/s]
+  double cache_speed_resolution;         ///< @brief Spacing of the cached start speeds [m/s]
+  double cache_steering_resolution;      ///< @brief Spacing of the cached current steering angles [rad]
+  double goal_lookahead;                 ///< @brief Distance of the global goal along the reference path [m]
+  bool use_warm_start;                   ///< @brief Follow the last plan on between full replans
+  double warm_start_replan_period;       ///< @brief Longest time between two full replans [s]
+  double warm_start_max_deviation;       ///< @brief Distance the car may drift off the last plan [m]
+  double warm_start_hysteresis;          ///< @brief Score margin another primitive needs to replace the last one
+  int search_depth;                      ///< @brief Stages of the lattice search, 1 keeps the single-stage selection
+  double search_stage_time;              ///< @brief Length of one search stage [s]
+  int search_node_budget;                ///< @brief Expansions of the lattice search per tick
+  double search_path_weight;             ///< @brief Weight of the distance to the reference path [1/s]
+  bool use_longitudinal_product;         ///< @brief Evaluate every steering target with every engine x brake level
+  double cof_break;                      ///< @brief Deceleration per brake level unit [m/s^2]
+  double target_speed;                   ///< @brief Speed the longitudinal cost pulls towards [m/s]
+  double weight_speed;                   ///< @brief Weight of the rms deviation from the target speed [s/m]
+  double weight_effort;                  ///< @brief Weight of the engine and brake acceleration [s^2/m]
+  int num_threads;                       ///< @brief Scoring threads besides the caller of plan()
+  bool use_branch_and_bound;             ///< @brief Score best-first and skip primitives that cannot win
+  double plan_deadline;                  ///< @brief Time after the start of a tick to stop refining [s], 0 disables
+  int anytime_coarse_stride;             ///< @brief Steering and acceleration stride of the coarse pass
+  bool use_escape_search;                ///< @brief Steer along a grid path if every primitive is blocked
+  int escape_node_budget;                ///< @brief Expansions of the grid search per tick
+  double escape_time_budget;             ///< @brief Longest duration of the grid search [s], 0 for no limit
+  double escape_lookahead;               ///< @brief Distance along the grid path the primitives steer to [m]
+  double pose_sigma_xy;                  ///< @brief Standard deviation of the start position, 0 for none [m]
+  double pose_sigma_theta;               ///< @brief Standard deviation of the start heading, 0 for none [rad]
+  double hypothesis_worst_weight;        ///< @brief Weight of the worst start hypothesis against the mean, in [0, 1]
+};
+
+/** @brief Time spent in the stages of one planner tick, measured on the steady clock [s]. */
+struct LatticePlanTimings
+{
+  LatticePlanTimings() :
+      rollout(0.0), scoring(0.0), selection(0.0), switch_map(0.0), total(0.0)
+  {
+  }
+
+  double rollout;     ///< @brief Inputs, rollout or cache lookup and the global goal
+  double scoring;     ///< @brief Scoring of all primitives, in parallel with the map switch check
+  double selection;   ///< @brief Selection of the primitive, including the lattice search
+  double switch_map;  ///< @brief The map switch check on its own
+  double total;
+};
+
+/** @brief The decision of one planner tick. */
+struct LatticePlan
+{
+  LatticePlan() :
+      primitive(0), steering(0.0), fast(0), switch_map(0), warm_started(false), goal_x(0.0), goal_y(0.0),
+      num_scored(0), num_skipped(0), escaped(false)
+  {
+  }
+
+  unsigned int primitive;    ///< @brief The selected primitive
+  double steering;           ///< @brief The steering command [rad]
+  int fast;                  ///< @brief 1 to use the fast speed pair, 0 for the slow one
+  int switch_map;            ///< @brief 1 if the map should be switched
+  bool warm_started;         ///< @brief True if the last plan was followed on instead of replanning
+  double goal_x, goal_y;     ///< @brief The global goal of the tick, of the plan followed on if warm started
+  unsigned int num_scored;   ///< @brief Primitives checked against the costmap
+  unsigned int num_skipped;  ///< @brief Primitives left unscored at the deadline, 0 if the refinement finished
+  bool escaped;              ///< @brief Every primitive was blocked and the steering follows the grid path
+  LatticePlanTimings timings;
+};
+
+/**
+ * @class LatticePlanner
+ * @brief The planner core of the lattice planner node, without any ROS communication.
+ *
+ * plan() takes the current state and a costmap and returns the steering and speed decision
+ * of one tick: it rolls out the primitives, scores them against the costmap and the global
+ * goal on the reference path, selects one and checks whether the map should be switched.
+ * The steering command and the last plan are kept between ticks, so the node and the
+ * offline replay tool only have to feed in the inputs in order and publish the result.
+ */
+class LatticePlanner : private boost::noncopyable
+{
+public:
+  LatticePlanner();
+
+  /** @brief Set up the primitives, the cache, the search and the worker threads. */
+  void configure(const LatticePlannerConfig& config);
+
+  const LatticePlannerConfig& getConfig() const
+  {
+    return config_;
+  }
+
+  ReferencePath& getReferencePath()
+  {
+    return reference_path_;
+  }
+
+  /** @brief Set the footprint the primitives are checked with, ignored unless use_footprint_check is set. */
+  void setFootprint(const std::vector<geometry_msgs::Point>& footprint, double resolution);
+
+  double getSteering() const
+  {
+    return steering_current_;
+  }
+
+  /** @brief Override the steering angle the next rollout starts from [rad]. */
+  void setSteering(double steering)
+  {
+    steering_current_ = steering;
+  }
+
+  /**
+   * @brief  Plan one tick
+   * @param  map The costmap, read only and not copied
+   * @param  state The current state as {x, y, theta, v}
+   * @param  now The time of the tick, only differences are used [s]
+   * @param  changed_bounds The world area updated since the last tick as {min_x, min_y, max_x, max_y},
+   *         NULL if it is unknown, the last plan is not followed on then
+   * @param  margin The distance around the changed area that affects the plan [m]
+   * @param  plan Will be set to the decision of the tick
+   * @param  counters The row and column counters of the map, the rows and columns are counted if NULL
+   * @param  pyramid The max-pooled pyramid of the map, a step of a primitive over free blocks only is
+   *         not checked cell by cell, NULL to check every step
+   */
+  void plan(const Costmap2D& map, const double* state, double now, const double* changed_bounds, double margin,
+            LatticePlan& plan, const CellCounters* counters = NULL, const CostmapPyramid* pyramid = NULL);
+
+  const MotionPrimitiveSet& getPrimitives() const
+  {
+    return primitives_;
+  }
+
+  /**
+   * @brief The scores of the primitives in the last replan, DBL_MAX if blocked. With branch and
+   * bound, a pruned primitive holds the lower bound of its score instead. With start hypotheses,
+   * the obstacle cost is the mix of their mean and worst by hypothesis_worst_weight.
+   */
+  const std::vector<double>& getScores() const
+  {
+    return scores_;
+  }
+
+  /**
+   * @brief The scores of the primitives in the last replan with the mean obstacle cost over the start
+   * hypotheses. Without hypotheses, and for primitives that were not checked, they equal getScores().
+   */
+  const std::vector<double>& getExpectedScores() const
+  {
+    return expected_scores_;
+  }
+
+  /** @brief The scores of the primitives in the last replan with the obstacle cost of the worst start hypothesis. */
+  const std::vector<double>& getWorstScores() const
+  {
+    return worst_scores_;
+  }
+
+  /**
+   * @brief  Check every primitive from a set of start poses instead of the sigma points of the configuration
+   * @param  offsets The start poses as (dx, dy, dtheta) triples added to the state passed to plan(), at most
+   *         MAX_START_HYPOTHESES of them, empty to use the configuration again
+   */
+  void setStartHypotheses(const std::vector<double>& offsets);
+
+  /** @brief The number of start poses the last replan checked the primitives from, 0 for the state alone. */
+  unsigned int getNumHypotheses() const
+  {
+    return hypotheses_.size();
+  }
+
+  static const unsigned int MAX_START_HYPOTHESES = 16;
+
+  /** @brief True if branch and bound skipped the costmap check of a primitive in the last replan. */
+  bool isPruned(unsigned int p) const
+  {
+    return pruned_[p] != 0;
+  }
+
+  unsigned int getNumPruned() const
+  {
+    return num_pruned_;
+  }
+
+  /** @brief True if a primitive got its score in the last replan, only the anytime mode leaves some out. */
+  bool isScored(unsigned int p) const
+  {
+    return scored_[p] != 0;
+  }
+
+  /** @brief The primitives the anytime mode always scores before refining. */
+  const std::vector<unsigned int>& getCoarsePrimitives() const
+  {
+    return coarse_;
+  }
+
+  /** @brief The grid search of the last tick on which every primitive was blocked. */
+  const GridEscape& getEscape() const
+  {
+    return escape_;
+  }
+
+  /** @brief The engine level of a primitive of the longitudinal product, as a unit of the engine input. */
+  double getEngineLevel(unsigned int p) const;
+
+  /** @brief The brake level of a primitive of the longitudinal product, as a unit of the brake input. */
+  double getBrakeLevel(unsigned int p) const;
+
+  /**
+   * @brief  Check whether the free space ahead is large enough to switch the map
+   * @param  theta The heading of the car [rad]
+   * @param  counters The row and column counters of the map, the rows and columns are counted if NULL
+   * @return 1 to switch the map, 0 otherwise
+   */
+  static int switchMap(const Costmap2D& map, double theta, const CellCounters* counters = NULL);
+
+private:
+  struct WarmPlan
+  {
+    bool valid;
+    double stamp;  ///< @brief Start time of the trajectory [s]
+    double start_x, start_y;
+    unsigned int primitive;
+    int fast;
+    double goal_x, goal_y;  ///< @brief The global goal of the replan, reported by the ticks that follow it on
+    std::vector<double> x, y, theta, u;
+  };
+
+  /** @brief The inputs of the tasks of a tick, set by plan() before it runs them. */
+  struct TaskInputs
+  {
+    const Costmap2D* map;
+    const CellCounters* counters;
+    const CostmapPyramid* pyramid;  ///< @brief NULL unless it matches the map and the footprint is checked
+    double goal_x, goal_y, theta;
+    int* switch_result;
+    double* switch_time;
+  };
+
+  /** @brief Score primitive task or check the map switch if task is past the last primitive. */
+  void plannerTask(unsigned int task);
+
+  /** @brief The number of FREE_SPACE cells in a column or a row. */
+  static int countFree(const Costmap2D& map, const CellCounters* counters, int index, bool column);
+
+  /** @brief The score of primitive p, also sets its expected and worst score. */
+  double scoreTrajectory(const Costmap2D& map, unsigned int p, double goal_x, double goal_y);
+
+  /** @brief The sum of the obstacle costs of primitive p from the state, DBL_MAX if it is blocked. */
+  double obstacleCost(const Costmap2D& map, unsigned int p) const;
+
+  /**
+   * @brief  The mean and the highest sum of the obstacle costs of primitive p over the start hypotheses,
+   *         with every costmap lookup shared by the hypotheses that land on the same cell or stamp
+   * @return False if the primitive is blocked from any of them
+   */
+  bool obstacleCostBatch(const Costmap2D& map, unsigned int p, double& mean, double& worst) const;
+
+  /** @brief Set up the rigid transforms of the start hypotheses around a state. */
+  void setupHypotheses(const double* state);
+  double scoreGlobal(unsigned int p, double goal_x, double goal_y) const;
+  double scoreLongitudinal(unsigned int p) const;
+
+  /** @brief Sort the primitives by the lower bounds of their scores, which leave out the obstacle cost. */
+  void computeBounds(double goal_x, double goal_y);
+
+  /** @brief Score primitive p unless its lower bound is above the best score so far. */
+  void scoreBranchAndBound(const Costmap2D& map, unsigned int p, double goal_x, double goal_y);
+
+  /** @brief Score pruned primitives until the speed pair and the selection do not depend on them. */
+  void resolvePruned(const Costmap2D& map, double goal_x, double goal_y);
+
+  /** @brief Score a primitive of the coarse pass, or the unclaimed one closest to the best so far. */
+  void scoreAnytime(const Costmap2D& map, unsigned int task, double goal_x, double goal_y);
+
+  /** @brief The unclaimed primitive closest to the best one in steering and acceleration index. */
+  unsigned int nextRefinement() const;
+
+  /** @brief Maps a sample of the primitives rolled out from the state onto the same sample from a start hypothesis. */
+  struct HypothesisTransform
+  {
+    double cos_theta, sin_theta, dx, dy, dtheta;
+  };
+
+  struct BoundOrder
+  {
+    explicit BoundOrder(const std::vector<double>& bounds) :
+        bounds(bounds)
+    {
+    }
+    bool operator()(unsigned int a, unsigned int b) const
+    {
+      return bounds[a] < bounds[b] || (bounds[a] == bounds[b] && a < b);
+    }
+    const std::vector<double>& bounds;
+  };
+
+  /** @brief The step of the last plan the car is at now, or -1 if a full replan is due. */
+  int warmPlanStep(const Costmap2D& map, const double* state, double now, const double* changed_bounds,
+                   double margin) const;
+  void storeWarmPlan(unsigned int p, int fast, const double* state, double now, double goal_x, double goal_y);
+
+  LatticePlannerConfig config_;
+  MotionPrimitiveSet primitives_;
+  PrimitiveCache primitive_cache_;
+  FootprintChecker footprint_checker_;
+  LatticeSearch lattice_search_;
+  GridEscape escape_;
+  ReferencePath reference_path_;
+  boost::scoped_ptr<WorkerPool> pool_;
+  TaskInputs task_inputs_;
+  boost::function<void(unsigned int)> planner_task_;  ///< @brief Bound once, so a tick does not allocate a functor
+
+  std::vector<double> u_engine_list_, u_break_list_;
+  std::vector<double> scores_;
+  std::vector<double> expected_scores_, worst_scores_;
+  std::vector<double> custom_hypotheses_;       ///< @brief Set by setStartHypotheses(), replaces the sigma points
+  std::vector<HypothesisTransform> hypotheses_;  ///< @brief Of the last replan, empty to check from the state alone
+  std::vector<double> bounds_;          ///< @brief Lower bounds of the scores for branch and bound
+  std::vector<unsigned int> order_;     ///< @brief The primitives by increasing bound, ties by index
+  std::vector<unsigned char> pruned_;
+  unsigned int num_pruned_;
+  unsigned int pinned_;                 ///< @brief Scored in any case, the warm start compares against its score
+  double best_score_;
+  boost::mutex best_mutex_;
+  std::vector<unsigned int> coarse_;    ///< @brief The first pass of the anytime mode
+  std::vector<unsigned char> claimed_;  ///< @brief Taken by a scoring task of the anytime mode
+  std::vector<unsigned char> scored_;   ///< @brief Holds a score of the last replan
+  unsigned int best_primitive_;         ///< @brief The refinement continues around it
+  ros::SteadyTime deadline_;
+  double steering_current_;
+  bool flag_slide_;
+  WarmPlan warm_plan_;
+};
+
+}  // namespace costmap_2d
+
+#endif  // COSTMAP_2D_LATTICE_PLANNER_H_
@@ -0,0 +1,144 @@
+#ifndef COSTMAP_2D_LATTICE_SEARCH_H_
+#define COSTMAP_2D_LATTICE_SEARCH_H_
+
+#include <costmap_2d/bucket_queue.h>
+#include <costmap_2d/costmap_2d.h>
+#include <costmap_2d/footprint_checker.h>
+#include <costmap_2d/motion_primitives.h>
+#include <costmap_2d/reference_path.h>
+#include <vector>
+
+namespace costmap_2d
+{
+
+/**
+ * @class LatticeSearch
+ * @brief Best-first search over chains of motion primitives, a few stages deep.
+ *
+ * Every node is the end state of one primitive, and expanding it rolls out all primitives of
+ * the stage set from there. The cost of a stage is the obstacle cost of its samples, scaled
+ * like the single-stage score, plus the distance of the samples to the reference path. A
+ * chain of full depth pays its distance to the global goal on top. The heuristic is that
+ * distance minus the farthest the remaining stages can drive, so it never overestimates and
+ * the first full-depth chain taken from the open list is the cheapest one.
+ *
+ * Nodes in the same (depth, cell, heading bin) are merged, keeping the cheapest. The search
+ * stops after a fixed number of expansions and then returns the most promising partial chain.
+ * All memory of a search is sized from the budget in configure(), so a search does not allocate.
+ */
+class LatticeSearch
+{
+public:
+  LatticeSearch();
+
+  /**
+   * @brief  Set up the stage set and the limits of the search
+   * @param  steering_targets The steering targets of the primitives of every stage [rad]
+   * @param  time_step The integration step of the rollouts [s]
+   * @param  stage_time The length of one stage [s]
+   * @param  depth The number of stages of a full chain
+   * @param  node_budget The maximum number of expansions per search
+   * @param  path_weight The weight of the distance to the reference path [1/s]
+   */
+  void configure(const std::vector<double>& steering_targets, double time_step, double stage_time,
+                 unsigned int depth, unsigned int node_budget, double path_weight,
+                 const VehicleModel& model = VehicleModel());
+
+  unsigned int getDepth() const
+  {
+    return depth_;
+  }
+
+  /**
+   * @brief  Search for the cheapest chain from a start state
+   * @param  map The costmap to check the stages against
+   * @param  checker The footprint stamps, the single cell under each sample is checked if it is not configured
+   * @param  path The reference path
+   * @param  start_state The start state as {x, y, theta, v}
+   * @param  steering_current The steering angle currently applied [rad]
+   * @param  u_engine The constant engine input [m/s^2]
+   * @param  preferred A primitive of the stage set whose first stage is favoured, -1 for none
+   * @param  preferred_bonus The cost taken off the first stage of the preferred primitive
+   * @return False if every first stage is blocked
+   */
+  bool search(const Costmap2D& map, const FootprintChecker& checker, const ReferencePath& path,
+              const double* start_state, double steering_current, double u_engine, double goal_x, double goal_y,
+              int preferred = -1, double preferred_bonus = 0.0);
+
+  /** @brief The primitives of the chain found by the last search, from the start on. */
+  const std::vector<unsigned int>& getChain() const
+  {
+    return chain_;
+  }
+
+  /** @brief True if the last search found a chain of full depth within the budget. */
+  bool isComplete() const
+  {
+    return complete_;
+  }
+
+  unsigned int getNumExpanded() const
+  {
+    return num_expanded_;
+  }
+
+  /** @brief Roll the chain of the last search out again and collect its samples. */
+  void getChainPath(std::vector<double>& x, std::vector<double>& y);
+
+private:
+  struct Node
+  {
+    double x, y, theta, v, steering;
+    double g;
+    double s;  ///< @brief The arc length of the reference path closest to the state
+    int parent;
+    unsigned int primitive;
+    unsigned int depth;
+  };
+
+  /**
+   * @brief  The cost of primitive p of the stage set, LETHAL stages return a negative cost
+   * @param  s_end Will be set to the arc length of the reference path closest to the end of the stage
+   */
+  double stageCost(const Costmap2D& map, const FootprintChecker& checker, const ReferencePath& path,
+                   const Node& from, unsigned int p, double& s_end) const;
+
+  /** @brief Lower bound of the cost left from a node. */
+  double heuristic(const Node& node, double goal_x, double goal_y) const;
+
+  /** @brief The best cost found so far for a lattice cell, open addressed and stamped with the search. */
+  struct CostSlot
+  {
+    unsigned long long key;
+    double g;
+    unsigned int stamp;  ///< @brief The slot is empty unless it equals best_g_stamp_
+  };
+
+  /** @brief The key of the lattice cell of a node. */
+  unsigned long long getKey(const Node& node, double resolution) const;
+
+  /** @brief The best cost of a lattice cell, DBL_MAX if no node reached it in this search yet. */
+  double& bestG(unsigned long long key);
+
+  MotionPrimitiveSet set_;
+  unsigned int depth_;
+  unsigned int node_budget_;
+  double path_weight_;
+  double u_engine_;
+
+  std::vector<Node> nodes_;
+  BucketQueue open_;
+  std::vector<CostSlot> best_g_;  ///< @brief A power of two above twice the node budget, emptied by a new stamp
+  unsigned int best_g_stamp_;
+  std::vector<double> u_engine_list_, u_break_list_;
+
+  std::vector<unsigned int> chain_;
+  bool complete_;
+  unsigned int num_expanded_;
+  double start_state_[4];
+  double start_steering_;
+};
+
+}  // namespace costmap_2d
+
+#endif  // COSTMAP_2D_LATTICE_SEARCH_H_
@@ -38,9 +38,13 @@
 #ifndef COSTMAP_2D_LAYERED_COSTMAP_H_
 #define COSTMAP_2D_LAYERED_COSTMAP_H_
 
+#include <costmap_2d/cell_counters.h>
 #include <costmap_2d/cost_values.h>
 #include <costmap_2d/layer.h>
 #include <costmap_2d/costmap_2d.h>
+#include <costmap_2d/costmap_pyramid.h>
+#include <costmap_2d/costmap_snapshot.h>
+#include <boost/shared_ptr.hpp>
 #include <vector>
 #include <string>
 
@@ -87,8 +91,77 @@ public:
     maxy = maxy_;
   }
 
+  /**
+   * @brief  Get the world area updated since the last call and start collecting anew
+   *
+   * Unlike getUpdatedBounds(), which only covers the last update, the area grows over all
+   * updates between two calls, so a consumer slower than the update loop misses nothing.
+   * @return False if the whole map has to be considered changed, e.g. after a resize
+   */
+  bool takeChangedBounds(double& minx, double& miny, double& maxx, double& maxy);
+
   bool isCurrent();
 
+  /** @brief Keep per-row and per-column FREE_SPACE and LETHAL_OBSTACLE counts of the costmap up to date. */
+  void setTrackCellCounts(bool track)
+  {
+    track_cell_counts_ = track;
+    if (!track)
+      cell_counters_.invalidate();
+  }
+
+  /**
+   * @brief  Get the row and column counters, hold the costmap's mutex while reading them
+   * @return NULL if the counters are not tracked or stale, e.g. until the first update after a reset
+   */
+  const CellCounters* getCellCounters() const
+  {
+    return track_cell_counts_ && cell_counters_.isValid() ? &cell_counters_ : NULL;
+  }
+
+  /** @brief Mark the counters and the pyramid stale after the costmap was written to outside of updateMap(). */
+  void invalidateCellCounters()
+  {
+    cell_counters_.invalidate();
+    pyramid_.invalidate();
+  }
+
+  /**
+   * @brief  Keep a max-pooled pyramid of the costmap up to date, pooled anew within the bounds of every
+   * update and at the edges when a rolling window moves
+   * @param  num_levels The number of levels above the costmap, 0 for none
+   */
+  void setPyramidLevels(unsigned int num_levels)
+  {
+    pyramid_.setNumLevels(num_levels);
+  }
+
+  /**
+   * @brief  Get the pyramid, hold the costmap's mutex while reading it
+   * @return NULL if there is none or it is stale, e.g. until the first update after a reset
+   */
+  const CostmapPyramid* getPyramid() const
+  {
+    return pyramid_.getNumLevels() > 0 && pyramid_.isValid() ? &pyramid_ : NULL;
+  }
+
+  /**
+   * @brief  Publish a CostmapSnapshot at the end of every updateMap()
+   *
+   * Every update then copies the master costmap and its counters once, into a snapshot that no
+   * reader holds any more, so only as many snapshots are allocated as are read at the same time.
+   */
+  void setPublishSnapshots(bool publish);
+
+  /**
+   * @brief  Get the snapshot of the last update, without taking the costmap's mutex
+   * @return NULL until the first update after setPublishSnapshots(true)
+   */
+  boost::shared_ptr<const CostmapSnapshot> getSnapshot() const
+  {
+    return boost::atomic_load(&snapshot_);
+  }
+
   Costmap2D* getCostmap()
   {
     return &costmap_;
@@ -155,6 +228,12 @@ public:
   double getInscribedRadius() { return inscribed_radius_; }
 
 private:
+  /** @brief The body of updateMap(), with the costmap's mutex held. */
+  void updateLayers(double robot_x, double robot_y, double robot_yaw);
+
+  /** @brief Copy the master costmap into a free snapshot and make it the one getSnapshot() returns. */
+  void publishSnapshot();
+
   Costmap2D costmap_;
   std::string global_frame_;
 
@@ -163,6 +242,21 @@ private:
   bool current_;
   double minx_, miny_, maxx_, maxy_;
   unsigned int bx0_, bxn_, by0_, byn_;
+  double changed_minx_, changed_miny_, changed_maxx_, changed_maxy_;  ///< @brief Area updated since takeChangedBounds()
+  bool changed_all_;
+
+  bool track_cell_counts_;
+  CellCounters cell_counters_;  ///< @brief Updated within the bounds of every updateMap()
+  CostmapPyramid pyramid_;      ///< @brief Pooled within the bounds of every updateMap() if it has levels
+
+  bool publish_snapshots_;
+  unsigned long update_epoch_;  ///< @brief The number of updateMap() calls since snapshots are published
+  bool full_change_pending_;    ///< @brief The whole map changed since the last snapshot
+  unsigned long full_change_epoch_;
+  double update_changed_[4];    ///< @brief The bounds changed by the current update, minx, miny, maxx, maxy
+  double changed_history_[CostmapSnapshot::HISTORY][4];  ///< @brief The bounds changed by epoch e at e % HISTORY
+  std::vector<boost::shared_ptr<CostmapSnapshot> > snapshot_pool_;  ///< @brief Every snapshot ever published
+  boost::shared_ptr<CostmapSnapshot> snapshot_;  ///< @brief Only accessed with boost::atomic_load/store
 
   std::vector<boost::shared_ptr<Layer> > plugins_;
 
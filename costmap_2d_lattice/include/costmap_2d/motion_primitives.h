@@ -0,0 +1,240 @@
+#ifndef COSTMAP_2D_MOTION_PRIMITIVES_H_
+#define COSTMAP_2D_MOTION_PRIMITIVES_H_
+
+#include <vector>
+
+namespace costmap_2d
+{
+
+/**
+ * @brief Parameters of the kinematic bicycle model with aerodynamic drag that is used to
+ * roll out the motion primitives of the lattice planner.
+ */
+struct VehicleModel
+{
+  VehicleModel() :
+      wheel_base(1.516), max_steering_rate(5 * 3.141592653589793238463 / 180), front_area(0.8575),
+      drag_coefficient(1.0), air_density(1.15), mass(130.0)
+  {
+  }
+
+  double wheel_base;         ///< @brief Distance between the axles [m]
+  double max_steering_rate;  ///< @brief Maximum steering angle rate [rad/s]
+  double front_area;         ///< @brief Frontal area used for the drag force [m^2]
+  double drag_coefficient;   ///< @brief Aerodynamic drag coefficient
+  double air_density;        ///< @brief Air density [kg/m^3]
+  double mass;               ///< @brief Vehicle mass used for the drag deceleration [kg]
+};
+
+/**
+ * @class MotionPrimitiveSet
+ * @brief A set of N constant-target steering rollouts, one per configured steering target.
+ *
+ * All rollouts of the set live in one contiguous structure-of-arrays buffer per state
+ * variable (x, y, theta, v and the applied steering angle u). The buffers are laid out
+ * step-major, so the states of all primitives at one time step are adjacent in memory.
+ * The buffers are sized once by configure() and reused by every rollout().
+ *
+ * rollout() integrates all primitives together, one SIMD lane per primitive: tan(u) and
+ * the longitudinal acceleration are precomputed per step, and the heading is advanced by
+ * rotating its cosine and sine instead of calling cos() and sin() in the inner loop.
+ *
+ * A set can also be the product of the steering targets with a list of constant longitudinal
+ * accelerations, primitive p then steers towards target getSteeringIndex(p) and adds
+ * acceleration getAccelerationIndex(p) on top of the common engine and brake input.
+ */
+class MotionPrimitiveSet
+{
+  friend class PrimitiveCache;  // writes transformed rollouts straight into the state buffers
+public:
+  MotionPrimitiveSet();
+
+  /**
+   * @brief  Set the steering targets and the time discretization of the set
+   * @param  steering_targets The steering angle each primitive converges to [rad]
+   * @param  time_step The integration step of the rollouts [s]
+   * @param  horizon The length of the rollouts [s]
+   * @param  model The vehicle model used to integrate the rollouts
+   */
+  void configure(const std::vector<double>& steering_targets, double time_step, double horizon,
+                 const VehicleModel& model = VehicleModel());
+
+  /**
+   * @brief  Set up the product of steering targets and longitudinal accelerations
+   * @param  steering_targets The steering angle each primitive converges to [rad]
+   * @param  accelerations The constant longitudinal accelerations, negative ones brake [m/s^2]
+   * @param  time_step The integration step of the rollouts [s]
+   * @param  horizon The length of the rollouts [s]
+   * @param  model The vehicle model used to integrate the rollouts
+   */
+  void configure(const std::vector<double>& steering_targets, const std::vector<double>& accelerations,
+                 double time_step, double horizon, const VehicleModel& model = VehicleModel());
+
+  /**
+   * @brief  Roll out every primitive of the set from the same start state
+   * @param  start_state The start state as {x, y, theta, v}
+   * @param  steering_current The steering angle currently applied [rad]
+   * @param  u_engine The engine acceleration for every time step, getNumSteps() values
+   * @param  u_break The brake acceleration for every time step, getNumSteps() values
+   */
+  void rollout(const double* start_state, double steering_current, const double* u_engine, const double* u_break);
+
+  /**
+   * @brief  Fill the steering angle profile that moves from the current steering angle towards a target
+   * @param  steering_current The steering angle currently applied [rad]
+   * @param  steering_goal The target steering angle [rad]
+   * @param  profile Will be filled with getNumSteps() steering angles
+   * @param  stride The distance between two consecutive steps in profile
+   */
+  void fillSteeringProfile(double steering_current, double steering_goal, double* profile,
+                           unsigned int stride = 1) const;
+
+  /** @brief The number of primitives in the set. */
+  unsigned int size() const
+  {
+    return num_primitives_;
+  }
+
+  unsigned int getNumSteeringTargets() const
+  {
+    return steering_targets_.size();
+  }
+
+  unsigned int getNumAccelerations() const
+  {
+    return accelerations_.size();
+  }
+
+  /** @brief The number of time steps of every rollout. */
+  unsigned int getNumSteps() const
+  {
+    return num_steps_;
+  }
+
+  double getTimeStep() const
+  {
+    return time_step_;
+  }
+
+  double getSteeringTarget(unsigned int p) const
+  {
+    return steering_targets_[getSteeringIndex(p)];
+  }
+
+  /** @brief The acceleration primitive p adds to the common input [m/s^2]. */
+  double getAcceleration(unsigned int p) const
+  {
+    return accelerations_[getAccelerationIndex(p)];
+  }
+
+  unsigned int getSteeringIndex(unsigned int p) const
+  {
+    return p % steering_targets_.size();
+  }
+
+  unsigned int getAccelerationIndex(unsigned int p) const
+  {
+    return p / steering_targets_.size();
+  }
+
+  /** @brief The primitive of a steering target and acceleration. */
+  unsigned int getPrimitive(unsigned int steering_index, unsigned int acceleration_index) const
+  {
+    return acceleration_index * steering_targets_.size() + steering_index;
+  }
+
+  const std::vector<double>& getSteeringTargets() const
+  {
+    return steering_targets_;
+  }
+
+  const std::vector<double>& getAccelerations() const
+  {
+    return accelerations_;
+  }
+
+  /** @brief The primitive whose steering target is closest to straight ahead, with the first acceleration. */
+  unsigned int getStraightPrimitive() const
+  {
+    return straight_primitive_;
+  }
+
+  const VehicleModel& getVehicleModel() const
+  {
+    return model_;
+  }
+
+  /**
+   * @brief  Given a primitive and a time step... compute the associated index into the state buffers
+   * @param p The primitive
+   * @param i The time step
+   * @return The associated index
+   */
+  inline unsigned int getIndex(unsigned int p, unsigned int i) const
+  {
+    return i * num_primitives_ + p;
+  }
+
+  inline double x(unsigned int p, unsigned int i) const
+  {
+    return x_[getIndex(p, i)];
+  }
+
+  inline double y(unsigned int p, unsigned int i) const
+  {
+    return y_[getIndex(p, i)];
+  }
+
+  inline double theta(unsigned int p, unsigned int i) const
+  {
+    return theta_[getIndex(p, i)];
+  }
+
+  inline double v(unsigned int p, unsigned int i) const
+  {
+    return v_[getIndex(p, i)];
+  }
+
+  inline double u(unsigned int p, unsigned int i) const
+  {
+    return u_[getIndex(p, i)];
+  }
+
+private:
+  /**
+   * @brief  Integrate all primitives step by step from the lane states, writing every step into the state buffers
+   *
+   * Expects u_, tan_u_ and accel_ to be filled for all steps and the lane states to hold the start state.
+   */
+  void integrateLanes();
+
+  VehicleModel model_;
+  std::vector<double> steering_targets_;
+  std::vector<double> accelerations_;
+  unsigned int num_primitives_;
+  unsigned int num_steps_;
+  unsigned int straight_primitive_;
+  double time_step_;
+
+  std::vector<double> x_;
+  std::vector<double> y_;
+  std::vector<double> theta_;
+  std::vector<double> v_;
+  std::vector<double> u_;
+
+  // per step inputs of the batched kernel, step-major like the state buffers
+  std::vector<double> tan_u_;
+  std::vector<double> accel_;
+
+  // per primitive state of the batched kernel while it steps through time
+  std::vector<double> lane_x_;
+  std::vector<double> lane_y_;
+  std::vector<double> lane_theta_;
+  std::vector<double> lane_v_;
+  std::vector<double> lane_cos_;
+  std::vector<double> lane_sin_;
+};
+
+}  // namespace costmap_2d
+
+#endif  // COSTMAP_2D_MOTION_PRIMITIVES_H_
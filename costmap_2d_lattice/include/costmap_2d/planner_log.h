@@ -0,0 +1,90 @@
+#ifndef COSTMAP_2D_PLANNER_LOG_H_
+#define COSTMAP_2D_PLANNER_LOG_H_
+
+#include <costmap_2d/costmap_2d.h>
+#include <costmap_2d/lattice_planner.h>
+#include <costmap_2d/reference_path.h>
+#include <geometry_msgs/Point.h>
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace costmap_2d
+{
+
+/** @brief The inputs and the decision of one planner tick, as stored in a planner log. */
+struct PlannerLogRecord
+{
+  PlannerLogRecord() :
+      stamp(0.0), steering(0.0), changes_known(false), margin(0.0), size_x(0), size_y(0), resolution(0.0),
+      origin_x(0.0), origin_y(0.0)
+  {
+    std::fill(state, state + 4, 0.0);
+    std::fill(changed_bounds, changed_bounds + 4, 0.0);
+  }
+
+  /** @brief Copy the cells and the geometry of a costmap into the record. */
+  void setMap(const Costmap2D& map);
+
+  /** @brief Resize a costmap to the recorded geometry and fill it with the recorded cells. */
+  void getMap(Costmap2D& map) const;
+
+  double stamp;               ///< @brief Time of the tick [s]
+  double state[4];            ///< @brief The state as {x, y, theta, v}
+  double steering;            ///< @brief The steering angle the tick started from [rad]
+  bool changes_known;         ///< @brief False if the changed bounds are unknown, after a resize
+  double changed_bounds[4];   ///< @brief The area updated since the last tick as {min_x, min_y, max_x, max_y}
+  double margin;              ///< @brief The circumscribed radius of the footprint [m]
+  std::vector<geometry_msgs::Point> footprint;
+  unsigned int size_x, size_y;
+  double resolution, origin_x, origin_y;
+  std::vector<unsigned char> costs;
+  LatticePlan plan;           ///< @brief The decision taken in the recorded run
+};
+
+/**
+ * @class PlannerLogWriter
+ * @brief Records planner ticks to a binary log that the lattice_replay tool plays back offline.
+ *
+ * The log starts with the planner configuration and the reference path, followed by one
+ * record per tick holding the state, the full costmap and the decision. Values are written
+ * in the byte order of the recording machine.
+ */
+class PlannerLogWriter
+{
+public:
+  /** @brief Create the log and write its header, returns false if the file could not be opened. */
+  bool open(const std::string& filename, const LatticePlannerConfig& config, const ReferencePath& path);
+
+  bool isOpen() const
+  {
+    return file_.is_open();
+  }
+
+  void write(const PlannerLogRecord& record);
+
+private:
+  std::ofstream file_;
+};
+
+/**
+ * @class PlannerLogReader
+ * @brief Reads back a log written by PlannerLogWriter.
+ */
+class PlannerLogReader
+{
+public:
+  /** @brief Open a log and read its header, returns false if it is no planner log. */
+  bool open(const std::string& filename, LatticePlannerConfig& config, ReferencePath& path);
+
+  /** @brief Read the next record, returns false at the end of the log or on a truncated record. */
+  bool read(PlannerLogRecord& record);
+
+private:
+  std::ifstream file_;
+};
+
+}  // namespace costmap_2d
+
+#endif  // COSTMAP_2D_PLANNER_LOG_H_
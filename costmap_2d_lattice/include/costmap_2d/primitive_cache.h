@@ -0,0 +1,84 @@
+#ifndef COSTMAP_2D_PRIMITIVE_CACHE_H_
+#define COSTMAP_2D_PRIMITIVE_CACHE_H_
+
+#include <costmap_2d/motion_primitives.h>
+#include <cstddef>
+#include <vector>
+
+namespace costmap_2d
+{
+
+/**
+ * @class PrimitiveCache
+ * @brief Precomputed body-frame rollouts of a MotionPrimitiveSet.
+ *
+ * The shape of a rollout only depends on the start speed, the steering angle applied at the
+ * start, the engine input and the steering target, not on the start pose. The cache rolls
+ * out every primitive once per (engine level, speed bucket, current steering bucket) from the
+ * origin, so a planner tick only has to gather the matching rollouts and move them into the
+ * world frame with one 2D transform per point.
+ *
+ * Positions and headings are interpolated bilinearly between the neighbouring speed and
+ * steering buckets and kept in single precision. Speeds and steering profiles are recomputed
+ * exactly for every lookup, so the steering command taken from the set is not quantized.
+ */
+class PrimitiveCache
+{
+public:
+  /** @brief The most values a position buffer may hold, 64 MiB per buffer. */
+  static const size_t MAX_CACHE_SIZE = 1 << 24;
+
+  PrimitiveCache();
+
+  /**
+   * @brief  Roll out all primitives of a set for every bucket
+   * @param  set The configured primitive set to cache, its state buffers are left untouched
+   * @param  engine_levels The constant engine inputs the planner uses [m/s^2]
+   * @param  max_speed The highest cached start speed [m/s]
+   * @param  speed_resolution The spacing of the speed buckets [m/s]
+   * @param  steering_resolution The spacing of the current steering buckets [rad]
+   * @return False if the parameters are invalid or the buckets would exceed MAX_CACHE_SIZE, the cache
+   *         stays empty then
+   */
+  bool build(const MotionPrimitiveSet& set, const std::vector<double>& engine_levels, double max_speed,
+             double speed_resolution, double steering_resolution);
+
+  bool isBuilt() const
+  {
+    return !x_.empty();
+  }
+
+  /**
+   * @brief  Fill a primitive set with the cached rollouts moved to a start state
+   * @param  start_state The start state as {x, y, theta, v}
+   * @param  steering_current The steering angle currently applied [rad]
+   * @param  u_engine The constant engine input over the horizon [m/s^2]
+   * @param  set The set to fill, must be configured like the set the cache was built from
+   * @return False if the start state or input lies outside the cache, the set is untouched then
+   */
+  bool transform(const double* start_state, double steering_current, double u_engine, MotionPrimitiveSet& set) const;
+
+private:
+  /** @brief Offset of the first value of a bucket in the position buffers. */
+  inline unsigned int getBucketOffset(unsigned int engine, unsigned int speed, unsigned int steering) const
+  {
+    return ((engine * num_speed_buckets_ + speed) * num_steering_buckets_ + steering) * bucket_size_;
+  }
+
+  std::vector<double> engine_levels_;
+  unsigned int num_speed_buckets_;
+  unsigned int num_steering_buckets_;
+  unsigned int bucket_size_;
+  double speed_resolution_;
+  double steering_resolution_;
+  double min_steering_;
+
+  // body-frame rollouts, one step-major block of primitives x steps per bucket
+  std::vector<float> x_;
+  std::vector<float> y_;
+  std::vector<float> theta_;
+};
+
+}  // namespace costmap_2d
+
+#endif  // COSTMAP_2D_PRIMITIVE_CACHE_H_
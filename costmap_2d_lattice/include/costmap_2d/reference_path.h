@@ -0,0 +1,115 @@
+#ifndef COSTMAP_2D_REFERENCE_PATH_H_
+#define COSTMAP_2D_REFERENCE_PATH_H_
+
+#include <string>
+#include <vector>
+
+namespace costmap_2d
+{
+
+/**
+ * @class ReferencePath
+ * @brief The offline optimized race line with an arc length table and a uniform grid over its segments.
+ *
+ * project() finds the closest point of the polyline through the grid, visiting only the cells
+ * around the query, and pointAt() finds the point at an arc length by binary search in the
+ * table. A path whose ends meet is treated as a loop, arc lengths then wrap around so
+ * lookahead queries stay valid lap after lap.
+ */
+class ReferencePath
+{
+public:
+  ReferencePath();
+
+  /**
+   * @brief  Read the path from a file with one "x,y" point per line
+   * @param  filename The csv file to read
+   * @param  closing_distance The path is a loop if its last point is at most this far from its first [m]
+   * @return False if the file could not be read or holds less than two points
+   */
+  bool load(const std::string& filename, double closing_distance);
+
+  /**
+   * @brief  Set the points of the path and build the arc length table and the grid
+   * @param  closed If true, the last point connects back to the first one
+   */
+  void setPoints(const std::vector<double>& x, const std::vector<double>& y, bool closed);
+
+  unsigned int size() const
+  {
+    return x_.size();
+  }
+
+  bool isClosed() const
+  {
+    return closed_;
+  }
+
+  const std::vector<double>& getX() const
+  {
+    return x_;
+  }
+
+  const std::vector<double>& getY() const
+  {
+    return y_;
+  }
+
+  /** @brief The arc length of the whole path, including the closing segment of a loop [m]. */
+  double getLength() const
+  {
+    return length_;
+  }
+
+  /**
+   * @brief  Find the point of the path closest to a position
+   * @param  s Will be set to the arc length of the closest point [m]
+   * @param  distance Will be set to the distance to the closest point [m]
+   * @return False if the path is empty
+   */
+  bool project(double x, double y, double& s, double& distance) const;
+
+  /**
+   * @brief  Find the point of the path closest to a position near a known arc length, e.g. of the
+   *         previous sample of a trajectory, by walking the segments from there while they come closer
+   * @param  s_start The arc length to start from [m]
+   * @param  s Will be set to the arc length of the closest point found [m]
+   * @param  distance Will be set to the distance to that point [m]
+   * @return False if the path has less than two points
+   */
+  bool projectFrom(double s_start, double x, double y, double& s, double& distance) const;
+
+  /**
+   * @brief  Get the point at an arc length, which wraps around on a loop and is clamped to the ends otherwise
+   * @return False if the path is empty
+   */
+  bool pointAt(double s, double& x, double& y) const;
+
+private:
+  unsigned int numSegments() const
+  {
+    return closed_ ? x_.size() : x_.size() - 1;
+  }
+
+  /** @brief The segment at an arc length of a path of two points or more, wraps or clamps the arc length. */
+  unsigned int segmentAt(double& s) const;
+
+  /** @brief Closest point of one segment, returns the squared distance and sets the arc length. */
+  double projectOnSegment(unsigned int segment, double x, double y, double& s) const;
+
+  std::vector<double> x_;
+  std::vector<double> y_;
+  std::vector<double> s_;  ///< @brief Arc length at every point
+  double length_;
+  bool closed_;
+
+  // the segments passing through every grid cell, cell c holds cell_segments_[cell_begin_[c] ... cell_begin_[c + 1] - 1]
+  double grid_origin_x_, grid_origin_y_, grid_resolution_;
+  int grid_size_x_, grid_size_y_;
+  std::vector<unsigned int> cell_begin_;
+  std::vector<unsigned int> cell_segments_;
+};
+
+}  // namespace costmap_2d
+
+#endif  // COSTMAP_2D_REFERENCE_PATH_H_
@@ -0,0 +1,83 @@
+#ifndef COSTMAP_2D_TRAJECTORY_VISUALIZER_H_
+#define COSTMAP_2D_TRAJECTORY_VISUALIZER_H_
+
+#include <costmap_2d/motion_primitives.h>
+#include <ros/ros.h>
+#include <visualization_msgs/MarkerArray.h>
+#include <boost/noncopyable.hpp>
+#include <boost/thread.hpp>
+#include <string>
+#include <vector>
+
+namespace costmap_2d
+{
+
+/**
+ * @class TrajectoryVisualizer
+ * @brief Publishes the primitives of the planner as markers from a low priority thread of its own.
+ *
+ * push() is called by the planner and only copies the rollouts into a free slot of a small
+ * ring of preallocated frames, it never waits for the publisher thread. Frames are skipped
+ * if nobody subscribes, if the last one was taken less than a period ago, or if the ring is
+ * full. The publisher thread turns each frame into a MarkerArray whose point buffers are
+ * reused from frame to frame. The trail of the selected trajectories cycles through a fixed
+ * number of marker ids, so RViz never holds more than that many.
+ */
+class TrajectoryVisualizer : private boost::noncopyable
+{
+public:
+  /**
+   * @brief  Advertise the markers and start the publisher thread
+   * @param  nh The node handle to advertise on
+   * @param  topic The MarkerArray topic
+   * @param  frame_id The frame of the trajectories
+   * @param  rate The highest rate frames are taken at, 0 disables the visualization [Hz]
+   * @param  queue_size The number of frames waiting for the publisher thread at most
+   * @param  history_size The number of selected trajectories kept in the trail
+   */
+  TrajectoryVisualizer(ros::NodeHandle& nh, const std::string& topic, const std::string& frame_id, double rate,
+                       unsigned int queue_size, unsigned int history_size);
+  ~TrajectoryVisualizer();
+
+  /**
+   * @brief  Hand the rollouts of a tick over to the publisher thread
+   * @param  set The rolled out primitives
+   * @param  selected The selected primitive
+   * @return False if the frame was skipped
+   */
+  bool push(const MotionPrimitiveSet& set, unsigned int selected, double goal_x, double goal_y);
+
+private:
+  struct Frame
+  {
+    ros::Time stamp;
+    unsigned int num_primitives, num_steps, selected;
+    std::vector<double> x, y;  ///< @brief Step-major like the primitive set
+    double goal_x, goal_y;
+  };
+
+  void publishLoop();
+
+  /** @brief Fill the preallocated markers from a frame. */
+  void fillMarkers(const Frame& frame);
+
+  ros::Publisher publisher_;
+  ros::Duration period_;
+  ros::Time last_push_;
+  unsigned int history_size_;
+  unsigned int history_index_;
+  visualization_msgs::MarkerArray markers_;
+
+  boost::mutex mutex_;
+  boost::condition_variable frame_cond_;
+  std::vector<Frame> frames_;
+  unsigned int first_frame_;  ///< @brief The oldest frame waiting for the publisher thread
+  unsigned int num_frames_;
+  unsigned int num_dropped_;
+  bool shutdown_;
+  boost::thread* thread_;
+};
+
+}  // namespace costmap_2d
+
+#endif  // COSTMAP_2D_TRAJECTORY_VISUALIZER_H_
@@ -0,0 +1,65 @@
+#ifndef COSTMAP_2D_WORKER_POOL_H_
+#define COSTMAP_2D_WORKER_POOL_H_
+
+#include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/thread.hpp>
+#include <vector>
+
+namespace costmap_2d
+{
+
+/**
+ * @class WorkerPool
+ * @brief A fixed set of threads that stay alive between planner ticks and run batches of indexed tasks.
+ *
+ * run() hands out the task indices of one batch to the workers and the calling thread and
+ * returns once every task has finished. Tasks are expected to write their result to a slot
+ * selected by their index, so any reduction done after run() does not depend on which thread
+ * ran which task.
+ */
+class WorkerPool : private boost::noncopyable
+{
+public:
+  /**
+   * @brief  Start the worker threads
+   * @param  num_threads The number of threads besides the caller of run(), 0 runs every batch on the caller
+   */
+  explicit WorkerPool(unsigned int num_threads);
+  ~WorkerPool();
+
+  /**
+   * @brief  Run task(0) ... task(num_tasks - 1) and wait for all of them
+   * @param  num_tasks The number of tasks in the batch
+   * @param  task The task, called once per index, possibly from several threads at the same time
+   */
+  void run(unsigned int num_tasks, const boost::function<void(unsigned int)>& task);
+
+  /** @brief The number of threads besides the caller of run(). */
+  unsigned int getNumThreads() const
+  {
+    return threads_.size();
+  }
+
+private:
+  void workerLoop();
+
+  /** @brief Claim and run tasks of the current batch until none is left. */
+  void runPendingTasks();
+
+  boost::mutex mutex_;
+  boost::condition_variable work_cond_;  ///< @brief Signals a new batch or the shutdown to the workers
+  boost::condition_variable done_cond_;  ///< @brief Signals the end of the batch to run()
+  std::vector<boost::thread*> threads_;
+
+  const boost::function<void(unsigned int)>* task_;
+  unsigned int num_tasks_;
+  unsigned int next_task_;
+  unsigned int unfinished_tasks_;
+  unsigned long batch_;
+  bool shutdown_;
+};
+
+}  // namespace costmap_2d
+
+#endif  // COSTMAP_2D_WORKER_POOL_H_
@@ -583,9 +583,8 @@ void ObstacleLayer::raytraceFreespace(const Observation& clearing_observation, d
 
     unsigned int cell_raytrace_range = cellDistance(clearing_observation.raytrace_range_);
     //MarkCell marker(costmap_, INSCRIBED_INFLATED_OBSTACLE);//changed for Probability map
-    MarkCell marker(costmap_, FREE_SPACE);
     // and finally... we can execute our trace to clear obstacles along that line
-    raytraceLine(marker, x0, y0, x1, y1, cell_raytrace_range);
+    markLine(FREE_SPACE, x0, y0, x1, y1, cell_raytrace_range);
 
     updateRaytraceBounds(ox, oy, wx, wy, clearing_observation.raytrace_range_, min_x, min_y, max_x, max_y);
   }
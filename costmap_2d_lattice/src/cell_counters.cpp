@@ -0,0 +1,122 @@
+#include <costmap_2d/cell_counters.h>
+#include <costmap_2d/cost_values.h>
+#include <algorithm>
+#include <cstdlib>
+
+namespace costmap_2d
+{
+
+namespace
+{
+// entry i gets the old entry i + d plus the cells gained, the entries from outside get the incoming count
+void shiftCounts(std::vector<int>& counts, int d, int gained, int incoming)
+{
+  std::vector<int>::iterator kept_begin = counts.begin(), kept_end = counts.end();
+  if (d > 0)
+  {
+    kept_end = std::copy(counts.begin() + d, counts.end(), counts.begin());
+    std::fill(kept_end, counts.end(), incoming);
+  }
+  else if (d < 0)
+  {
+    kept_begin = std::copy_backward(counts.begin(), counts.end() + d, counts.end());
+    std::fill(counts.begin(), kept_begin, incoming);
+  }
+  for (std::vector<int>::iterator count = kept_begin; count != kept_end; ++count)
+    *count += gained;
+}
+}
+
+void CellCounters::rebuild(const Costmap2D& map)
+{
+  size_x_ = map.getSizeInCellsX();
+  size_y_ = map.getSizeInCellsY();
+  row_free_.assign(size_y_, 0);
+  row_lethal_.assign(size_y_, 0);
+  column_free_.assign(size_x_, 0);
+  column_lethal_.assign(size_x_, 0);
+  valid_ = true;
+  count(map, 0, 0, size_x_, size_y_, 1);
+}
+
+void CellCounters::shift(const Costmap2D& map, int dx, int dy)
+{
+  int size_x = size_x_, size_y = size_y_;
+  if (!valid_ || map.getSizeInCellsX() != size_x_ || map.getSizeInCellsY() != size_y_ || abs(dx) >= size_x
+      || abs(dy) >= size_y)
+  {
+    valid_ = false;
+    return;
+  }
+  if (dx == 0 && dy == 0)
+    return;
+
+  unsigned char default_value = map.getDefaultValue();
+  int default_free = default_value == FREE_SPACE;
+  int default_lethal = default_value == LETHAL_OBSTACLE;
+
+  // subtract the cells that drop out from the rows and columns that stay: the old columns
+  // outside [dx, dx + size_x) and the old rows outside [dy, dy + size_y)
+  const unsigned char* costs = map.getCharMap();
+  int keep_x0 = std::max(dx, 0), keep_xn = std::min(dx + size_x, size_x);
+  int keep_y0 = std::max(dy, 0), keep_yn = std::min(dy + size_y, size_y);
+  for (int my = keep_y0; my < keep_yn; ++my)
+  {
+    for (int mx = 0; mx < size_x; ++mx)
+    {
+      if (mx >= keep_x0 && mx < keep_xn)
+        continue;
+      row_free_[my] -= costs[my * size_x + mx] == FREE_SPACE;
+      row_lethal_[my] -= costs[my * size_x + mx] == LETHAL_OBSTACLE;
+    }
+  }
+  for (int my = 0; my < size_y; ++my)
+  {
+    if (my >= keep_y0 && my < keep_yn)
+      continue;
+    for (int mx = keep_x0; mx < keep_xn; ++mx)
+    {
+      column_free_[mx] -= costs[my * size_x + mx] == FREE_SPACE;
+      column_lethal_[mx] -= costs[my * size_x + mx] == LETHAL_OBSTACLE;
+    }
+  }
+
+  // move the counters in place, the rows and columns coming in hold default cells only, and the ones
+  // that stay gain as many default cells as they lost
+  int new_x = abs(dx), new_y = abs(dy);
+  shiftCounts(row_free_, dy, new_x * default_free, size_x * default_free);
+  shiftCounts(row_lethal_, dy, new_x * default_lethal, size_x * default_lethal);
+  shiftCounts(column_free_, dx, new_y * default_free, size_y * default_free);
+  shiftCounts(column_lethal_, dx, new_y * default_lethal, size_y * default_lethal);
+}
+
+void CellCounters::count(const Costmap2D& map, unsigned int x0, unsigned int y0, unsigned int xn, unsigned int yn,
+                         int sign)
+{
+  if (!valid_ || map.getSizeInCellsX() != size_x_ || map.getSizeInCellsY() != size_y_)
+  {
+    valid_ = false;
+    return;
+  }
+
+  const unsigned char* costs = map.getCharMap();
+  for (unsigned int my = y0; my < yn; ++my)
+  {
+    const unsigned char* row = costs + my * size_x_;
+    int row_free = 0, row_lethal = 0;
+    for (unsigned int mx = x0; mx < xn; ++mx)
+    {
+      // branch free, the comparisons are 0 or 1
+      int is_free = row[mx] == FREE_SPACE;
+      int is_lethal = row[mx] == LETHAL_OBSTACLE;
+      row_free += is_free;
+      row_lethal += is_lethal;
+      column_free_[mx] += sign * is_free;
+      column_lethal_[mx] += sign * is_lethal;
+    }
+    row_free_[my] += sign * row_free;
+    row_lethal_[my] += sign * row_lethal;
+  }
+}
+
+}  // namespace costmap_2d
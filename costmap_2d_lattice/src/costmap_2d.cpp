@@ -37,14 +37,55 @@
  *********************************************************************/
 #include <costmap_2d/costmap_2d.h>
 #include <cstdio>
+#include <fcntl.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 using namespace std;
 
 namespace costmap_2d
 {
+
+namespace
+{
+
+/**
+ * The first page of a binary costmap file, the cells follow at data_offset, row after row from
+ * the origin on. The fields are in the byte order of the machine that wrote the file.
+ */
+struct BinaryMapHeader
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t data_offset;
+  uint32_t size_x;
+  uint32_t size_y;
+  double resolution;
+  double origin_x;
+  double origin_y;
+  uint8_t default_value;
+};
+
+const char BINARY_MAP_MAGIC[8] = {'C', 'O', 'S', 'T', 'M', 'A', 'P', '\0'};
+const uint32_t BINARY_MAP_VERSION = 1;
+// the cells start on a page of their own, so they can be mapped as they are
+const uint32_t BINARY_MAP_DATA_OFFSET = 4096;
+
+// true if the header is one of ours and the file holds all of its cells
+bool checkHeader(const BinaryMapHeader& header, size_t file_size)
+{
+  return memcmp(header.magic, BINARY_MAP_MAGIC, sizeof(BINARY_MAP_MAGIC)) == 0
+      && header.version == BINARY_MAP_VERSION && header.data_offset >= sizeof(BinaryMapHeader)
+      && file_size >= header.data_offset + (size_t)header.size_x * header.size_y;
+}
+
+}  // namespace
+
 Costmap2D::Costmap2D(unsigned int cells_size_x, unsigned int cells_size_y, double resolution,
                      double origin_x, double origin_y, unsigned char default_value) :
-    size_x_(cells_size_x), size_y_(cells_size_y), resolution_(resolution), origin_x_(origin_x),
+    mapped_file_(NULL), mapped_length_(0), size_x_(cells_size_x), size_y_(cells_size_y), resolution_(resolution), origin_x_(origin_x),
     origin_y_(origin_y), costmap_(NULL), default_value_(default_value)
 {
   access_ = new mutex_t();
@@ -54,18 +95,32 @@ Costmap2D::Costmap2D(unsigned int cells_size_x, unsigned int cells_size_y, doubl
   resetMaps();
 }
 
+void Costmap2D::releaseCostArray()
+{
+  if (mapped_file_ != NULL)
+  {
+    munmap(mapped_file_, mapped_length_);
+    mapped_file_ = NULL;
+    mapped_length_ = 0;
+  }
+  else
+  {
+    delete[] costmap_;
+  }
+  costmap_ = NULL;
+}
+
 void Costmap2D::deleteMaps()
 {
   // clean up data
   boost::unique_lock<mutex_t> lock(*access_);
-  delete[] costmap_;
-  costmap_ = NULL;
+  releaseCostArray();
 }
 
 void Costmap2D::initMaps(unsigned int size_x, unsigned int size_y)
 {
   boost::unique_lock<mutex_t> lock(*access_);
-  delete[] costmap_;
+  releaseCostArray();
   costmap_ = new unsigned char[size_x * size_y];
 }
 
@@ -140,8 +195,10 @@ Costmap2D& Costmap2D::operator=(const Costmap2D& map)
   if (this == &map)
     return *this;
 
-  // clean up old data
-  deleteMaps();
+  // keep the cost array if it has the size already, e.g. when a copy is refreshed every update
+  bool same_size = costmap_ != NULL && size_x_ == map.size_x_ && size_y_ == map.size_y_;
+  if (!same_size)
+    deleteMaps();
 
   size_x_ = map.size_x_;
   size_y_ = map.size_y_;
@@ -150,7 +207,8 @@ Costmap2D& Costmap2D::operator=(const Costmap2D& map)
   origin_y_ = map.origin_y_;
 
   // initialize our various maps
-  initMaps(size_x_, size_y_);
+  if (!same_size)
+    initMaps(size_x_, size_y_);
 
   // copy the cost map
   memcpy(costmap_, map.costmap_, size_x_ * size_y_ * sizeof(unsigned char));
@@ -159,7 +217,7 @@ Costmap2D& Costmap2D::operator=(const Costmap2D& map)
 }
 
 Costmap2D::Costmap2D(const Costmap2D& map) :
-    costmap_(NULL)
+    mapped_file_(NULL), mapped_length_(0), costmap_(NULL)
 {
   access_ = new mutex_t();
   *this = map;
@@ -167,11 +225,47 @@ Costmap2D::Costmap2D(const Costmap2D& map) :
 
 // just initialize everything to NULL by default
 Costmap2D::Costmap2D() :
-    size_x_(0), size_y_(0), resolution_(0.0), origin_x_(0.0), origin_y_(0.0), costmap_(NULL)
+    mapped_file_(NULL), mapped_length_(0), size_x_(0), size_y_(0), resolution_(0.0), origin_x_(0.0),
+    origin_y_(0.0), costmap_(NULL)
 {
   access_ = new mutex_t();
 }
 
+Costmap2D::Costmap2D(const std::string& file_name) :
+    mapped_file_(NULL), mapped_length_(0), size_x_(0), size_y_(0), resolution_(0.0), origin_x_(0.0),
+    origin_y_(0.0), costmap_(NULL), default_value_(0)
+{
+  access_ = new mutex_t();
+
+  int fd = open(file_name.c_str(), O_RDONLY);
+  if (fd < 0)
+    return;
+  struct stat file_stat;
+  BinaryMapHeader header;
+  if (fstat(fd, &file_stat) != 0 || pread(fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header)
+      || !checkHeader(header, file_stat.st_size))
+  {
+    close(fd);
+    return;
+  }
+  // a private mapping never writes back to the file, the mapping stays valid after the file is closed
+  size_t length = header.data_offset + (size_t)header.size_x * header.size_y;
+  void* mapped = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (mapped == MAP_FAILED)
+    return;
+
+  mapped_file_ = mapped;
+  mapped_length_ = length;
+  costmap_ = static_cast<unsigned char*>(mapped) + header.data_offset;
+  size_x_ = header.size_x;
+  size_y_ = header.size_y;
+  resolution_ = header.resolution;
+  origin_x_ = header.origin_x;
+  origin_y_ = header.origin_y;
+  default_value_ = header.default_value;
+}
+
 Costmap2D::~Costmap2D()
 {
   deleteMaps();
@@ -274,42 +368,16 @@ void Costmap2D::updateOrigin(double new_origin_x, double new_origin_y)
   new_grid_ox = origin_x_ + cell_ox * resolution_;
   new_grid_oy = origin_y_ + cell_oy * resolution_;
 
-  // To save casting from unsigned int to int a bunch of times
-  int size_x = size_x_;
-  int size_y = size_y_;
-
-  // we need to compute the overlap of the new and existing windows
-  int lower_left_x, lower_left_y, upper_right_x, upper_right_y;
-  lower_left_x = min(max(cell_ox, 0), size_x);
-  lower_left_y = min(max(cell_oy, 0), size_y);
-  upper_right_x = min(max(cell_ox + size_x, 0), size_x);
-  upper_right_y = min(max(cell_oy + size_y, 0), size_y);
-
-  unsigned int cell_size_x = upper_right_x - lower_left_x;
-  unsigned int cell_size_y = upper_right_y - lower_left_y;
-
-  // we need a map to store the obstacles in the window temporarily
-  unsigned char* local_map = new unsigned char[cell_size_x * cell_size_y];
-
-  // copy the local window in the costmap to the local map
-  copyMapRegion(costmap_, lower_left_x, lower_left_y, size_x_, local_map, 0, 0, cell_size_x, cell_size_x, cell_size_y);
-
-  // now we'll set the costmap to be completely unknown if we track unknown space
-  resetMaps();
+  // move the overlap of the old and new window in place and set the cells that come in from
+  // outside to the default value, without a temporary copy and without resetting the whole map
+  {
+    boost::unique_lock<mutex_t> lock(*access_);
+    shiftMapRegion(costmap_, cell_ox, cell_oy, default_value_);
+  }
 
   // update the origin with the appropriate world coordinates
   origin_x_ = new_grid_ox;
   origin_y_ = new_grid_oy;
-
-  // compute the starting cell location for copying data back in
-  int start_x = lower_left_x - cell_ox;
-  int start_y = lower_left_y - cell_oy;
-
-  // now we want to copy the overlapping information back into the map, but in its new location
-  copyMapRegion(local_map, 0, 0, cell_size_x, costmap_, start_x, start_y, size_x_, cell_size_x, cell_size_y);
-
-  // make sure to clean up
-  delete[] local_map;
 }
 
 bool Costmap2D::setConvexPolygonCost(const std::vector<geometry_msgs::Point>& polygon, unsigned char cost_value)
@@ -472,17 +540,77 @@ bool Costmap2D::saveMap(std::string file_name)
   }
 
   fprintf(fp, "P2\n%u\n%u\n%u\n", size_x_, size_y_, 0xff);
+  // one write per row, the digits of the costs are put together by hand instead of printed one by one
+  std::vector<char> row(4 * size_x_ + 1);
   for (unsigned int iy = 0; iy < size_y_; iy++)
   {
+    char* out = &row[0];
+    const unsigned char* costs = costmap_ + getIndex(0, iy);
     for (unsigned int ix = 0; ix < size_x_; ix++)
     {
-      unsigned char cost = getCost(ix, iy);
-      fprintf(fp, "%d ", cost);
+      unsigned char cost = costs[ix];
+      if (cost >= 100)
+        *out++ = '0' + cost / 100;
+      if (cost >= 10)
+        *out++ = '0' + cost / 10 % 10;
+      *out++ = '0' + cost % 10;
+      *out++ = ' ';
     }
-    fprintf(fp, "\n");
+    *out++ = '\n';
+    fwrite(&row[0], 1, out - &row[0], fp);
   }
   fclose(fp);
   return true;
 }
 
+bool Costmap2D::saveBinaryMap(std::string file_name)
+{
+  FILE *fp = fopen(file_name.c_str(), "wb");
+  if (!fp)
+    return false;
+
+  // the header is padded with zeros up to the first cell
+  std::vector<char> header_page(BINARY_MAP_DATA_OFFSET, 0);
+  BinaryMapHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, BINARY_MAP_MAGIC, sizeof(BINARY_MAP_MAGIC));
+  header.version = BINARY_MAP_VERSION;
+  header.data_offset = BINARY_MAP_DATA_OFFSET;
+  header.size_x = size_x_;
+  header.size_y = size_y_;
+  header.resolution = resolution_;
+  header.origin_x = origin_x_;
+  header.origin_y = origin_y_;
+  header.default_value = default_value_;
+  memcpy(&header_page[0], &header, sizeof(header));
+
+  size_t num_cells = (size_t)size_x_ * size_y_;
+  bool ok = fwrite(&header_page[0], 1, header_page.size(), fp) == header_page.size()
+      && fwrite(costmap_, 1, num_cells, fp) == num_cells;
+  return fclose(fp) == 0 && ok;
+}
+
+bool Costmap2D::loadBinaryMap(std::string file_name)
+{
+  FILE *fp = fopen(file_name.c_str(), "rb");
+  if (!fp)
+    return false;
+
+  BinaryMapHeader header;
+  bool ok = fseek(fp, 0, SEEK_END) == 0;
+  long file_size = ftell(fp);
+  ok = ok && file_size >= 0 && fseek(fp, 0, SEEK_SET) == 0 && fread(&header, sizeof(header), 1, fp) == 1
+      && checkHeader(header, file_size) && fseek(fp, header.data_offset, SEEK_SET) == 0;
+  if (ok)
+  {
+    boost::unique_lock<mutex_t> lock(*access_);
+    default_value_ = header.default_value;
+    resizeMap(header.size_x, header.size_y, header.resolution, header.origin_x, header.origin_y);
+    size_t num_cells = (size_t)size_x_ * size_y_;
+    ok = fread(costmap_, 1, num_cells, fp) == num_cells;
+  }
+  fclose(fp);
+  return ok;
+}
+
 }  // namespace costmap_2d
@@ -76,6 +76,8 @@ Costmap2DROS::Costmap2DROS(const std::string& name, tf2_ros::Buffer& tf) :
     plugin_loader_("costmap_2d", "costmap_2d::Layer"),
     publisher_(NULL),
     dsrv_(NULL),
+    update_epoch_(0),
+    footprint_version_(0),
     footprint_padding_(0.0),
     car_dist(0.0),
     car_dist_switch(0.0),
@@ -403,12 +405,27 @@ void Costmap2DROS::readFootprintFromConfig(const costmap_2d::Costmap2DConfig &ne
 void Costmap2DROS::setUnpaddedRobotFootprint(const std::vector<geometry_msgs::Point>& points)
 {
   unpadded_footprint_ = points;
-  padded_footprint_ = points;
-  padFootprint(padded_footprint_, footprint_padding_);
+  std::vector<geometry_msgs::Point> padded = points;
+  padFootprint(padded, footprint_padding_);
+  {
+    boost::mutex::scoped_lock lock(footprint_mutex_);
+    padded_footprint_.swap(padded);
+    ++footprint_version_;
+  }
 
   layered_costmap_->setFootprint(padded_footprint_);
 }
 
+bool Costmap2DROS::updateRobotFootprint(std::vector<geometry_msgs::Point>& footprint, unsigned long& version) const
+{
+  boost::mutex::scoped_lock lock(footprint_mutex_);
+  if (version == footprint_version_)
+    return false;
+  footprint = padded_footprint_;
+  version = footprint_version_;
+  return true;
+}
+
 void Costmap2DROS::movementCB(const ros::TimerEvent &event)
 {
   // don't allow configuration to happen while this check occurs
@@ -491,6 +508,7 @@ void Costmap2DROS::updateMap()
   if (!stop_updates_)
   {
     // get global pose
+    ros::Time update_start = ros::Time::now();
     geometry_msgs::PoseStamped pose;
     if (getRobotPose (pose))
     {
@@ -507,10 +525,31 @@ void Costmap2DROS::updateMap()
       footprint_pub_.publish(footprint);
 
       initialized_ = true;
+
+      {
+        boost::unique_lock<boost::mutex> lock(update_mutex_);
+        ++update_epoch_;
+        update_stamp_ = update_start;
+      }
+      update_cond_.notify_all();
     }
   }
 }
 
+bool Costmap2DROS::waitForUpdate(unsigned long& epoch, ros::Time& stamp, double timeout)
+{
+  boost::unique_lock<boost::mutex> lock(update_mutex_);
+  boost::system_time deadline = boost::get_system_time() + boost::posix_time::microseconds((long)(timeout * 1e6));
+  while (update_epoch_ == epoch)
+  {
+    if (!update_cond_.timed_wait(lock, deadline))
+      return false;
+  }
+  epoch = update_epoch_;
+  stamp = update_stamp_;
+  return true;
+}
+
 void Costmap2DROS::start()
 {
   std::vector < boost::shared_ptr<Layer> > *plugins = layered_costmap_->getPlugins();
@@ -568,6 +607,7 @@ void Costmap2DROS::resetLayers()
 {
   Costmap2D* top = layered_costmap_->getCostmap();
   top->resetMap(0, 0, top->getSizeInCellsX(), top->getSizeInCellsY());
+  layered_costmap_->invalidateCellCounters();
   std::vector < boost::shared_ptr<Layer> > *plugins = layered_costmap_->getPlugins();
   for (vector<boost::shared_ptr<Layer> >::iterator plugin = plugins->begin(); plugin != plugins->end();
       ++plugin)
@@ -681,7 +721,7 @@ void Costmap2DROS::mapSizeCarPoseCallback(const std_msgs::Float32MultiArray::Con
   map_update_thread_ = new boost::thread(boost::bind(&Costmap2DROS::mapUpdateLoop, this, map_update_frequency));
 }
 void Costmap2DROS::mapSwitchCallback(const std_msgs::Int8::ConstPtr &msg){
-    ROS_INFO("MAP_SWITCH:###############  IS %d",map_switch);
+    ROS_DEBUG("MAP_SWITCH:###############  IS %d",map_switch);
     map_switch=msg->data;
 }
 /*
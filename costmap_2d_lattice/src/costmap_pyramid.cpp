@@ -0,0 +1,225 @@
+#include <costmap_2d/costmap_pyramid.h>
+#include <costmap_2d/cost_values.h>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+namespace costmap_2d
+{
+
+namespace
+{
+// moves the blocks of a level in place like Costmap2D::updateOrigin() moves the cells, block (x, y)
+// gets the old block (x + dx, y + dy), the blocks from outside are pooled anew by the caller
+void shiftBlocks(unsigned char* blocks, int size_x, int size_y, int dx, int dy)
+{
+  if (abs(dx) >= size_x || abs(dy) >= size_y)
+  {
+    std::fill(blocks, blocks + size_x * size_y, 0);
+    return;
+  }
+  int row_size = size_x - abs(dx);
+  int dest_x = std::max(-dx, 0), source_x = std::max(dx, 0);
+  int first = dy >= 0 ? 0 : size_y - 1, last = dy >= 0 ? size_y : -1, step = dy >= 0 ? 1 : -1;
+  for (int y = first; y != last; y += step)
+  {
+    unsigned char* row = blocks + y * size_x;
+    int source_y = y + dy;
+    if (source_y < 0 || source_y >= size_y)
+    {
+      std::fill(row, row + size_x, 0);
+      continue;
+    }
+    memmove(row + dest_x, blocks + source_y * size_x + source_x, row_size);
+    std::fill(row, row + dest_x, 0);
+    std::fill(row + dest_x + row_size, row + size_x, 0);
+  }
+}
+
+// the largest integer not above a / b for b > 0
+int floorDiv(int a, int b)
+{
+  return a >= 0 ? a / b : -((-a + b - 1) / b);
+}
+}
+
+void CostmapPyramid::setNumLevels(unsigned int num_levels)
+{
+  if (num_levels == num_levels_)
+    return;
+  num_levels_ = num_levels;
+  levels_.resize(num_levels_);
+  level_size_x_.resize(num_levels_);
+  level_size_y_.resize(num_levels_);
+  level_stride_x_.resize(num_levels_);
+  level_stride_y_.resize(num_levels_);
+  valid_ = false;
+}
+
+void CostmapPyramid::rebuild(const Costmap2D& map)
+{
+  size_x_ = map.getSizeInCellsX();
+  size_y_ = map.getSizeInCellsY();
+  phase_x_ = phase_y_ = 0;
+  for (unsigned int level = 1; level <= num_levels_; ++level)
+  {
+    // room for the blocks of any phase, n cells touch at most ((n + 2^l - 2) >> l) + 1 blocks
+    unsigned int block = 1u << level;
+    level_stride_x_[level - 1] = size_x_ > 0 ? ((size_x_ + block - 2) >> level) + 1 : 0;
+    level_stride_y_[level - 1] = size_y_ > 0 ? ((size_y_ + block - 2) >> level) + 1 : 0;
+    levels_[level - 1].resize(level_stride_x_[level - 1] * level_stride_y_[level - 1]);
+  }
+  updateLevelSizes();
+  for (unsigned int level = 1; level <= num_levels_; ++level)
+  {
+    if (!levels_[level - 1].empty())
+      pool(map, level, 0, 0, level_size_x_[level - 1], level_size_y_[level - 1]);
+  }
+  valid_ = true;
+}
+
+void CostmapPyramid::updateLevelSizes()
+{
+  // a block at either edge only covers the cells inside the map
+  for (unsigned int level = 1; level <= num_levels_; ++level)
+  {
+    unsigned int mask = (1u << level) - 1;
+    level_size_x_[level - 1] = size_x_ > 0 ? (((phase_x_ & mask) + size_x_ - 1) >> level) + 1 : 0;
+    level_size_y_[level - 1] = size_y_ > 0 ? (((phase_y_ & mask) + size_y_ - 1) >> level) + 1 : 0;
+  }
+}
+
+void CostmapPyramid::update(const Costmap2D& map, unsigned int x0, unsigned int y0, unsigned int xn,
+                            unsigned int yn)
+{
+  if (!valid_ || map.getSizeInCellsX() != size_x_ || map.getSizeInCellsY() != size_y_)
+  {
+    rebuild(map);
+    return;
+  }
+  if (xn <= x0 || yn <= y0)
+    return;
+  // the window in the units of the level below, halved on every level up
+  for (unsigned int level = 1; level <= num_levels_; ++level)
+  {
+    unsigned int bit_x = (phase_x_ >> (level - 1)) & 1, bit_y = (phase_y_ >> (level - 1)) & 1;
+    x0 = (x0 + bit_x) >> 1;
+    y0 = (y0 + bit_y) >> 1;
+    xn = ((xn - 1 + bit_x) >> 1) + 1;
+    yn = ((yn - 1 + bit_y) >> 1) + 1;
+    pool(map, level, x0, y0, xn, yn);
+  }
+}
+
+void CostmapPyramid::shift(const Costmap2D& map, int dx, int dy)
+{
+  if (!valid_ || num_levels_ == 0 || (dx == 0 && dy == 0))
+    return;
+  if (map.getSizeInCellsX() != size_x_ || map.getSizeInCellsY() != size_y_ || abs(dx) >= (int)size_x_
+      || abs(dy) >= (int)size_y_)
+  {
+    rebuild(map);
+    return;
+  }
+
+  // a level moves by the blocks of its grid that cell 0 crossed, the top level keeps the rest of the
+  // shift as the phase
+  for (unsigned int level = 1; level <= num_levels_; ++level)
+  {
+    int block = 1 << level;
+    shiftBlocks(&levels_[level - 1][0], level_stride_x_[level - 1], level_stride_y_[level - 1],
+                floorDiv(phase_x_ + dx, block) - (int)(phase_x_ >> level),
+                floorDiv(phase_y_ + dy, block) - (int)(phase_y_ >> level));
+  }
+  int top = 1 << num_levels_;
+  phase_x_ = phase_x_ + dx - floorDiv(phase_x_ + dx, top) * top;
+  phase_y_ = phase_y_ + dy - floorDiv(phase_y_ + dy, top) * top;
+  updateLevelSizes();
+
+  // only the blocks over the cells that came in, and those over the edge the cells left by, changed
+  if (dx > 0)
+  {
+    update(map, size_x_ - dx, 0, size_x_, size_y_);
+    update(map, 0, 0, 1, size_y_);
+  }
+  else if (dx < 0)
+  {
+    update(map, 0, 0, -dx, size_y_);
+    update(map, size_x_ - 1, 0, size_x_, size_y_);
+  }
+  if (dy > 0)
+  {
+    update(map, 0, size_y_ - dy, size_x_, size_y_);
+    update(map, 0, 0, size_x_, 1);
+  }
+  else if (dy < 0)
+  {
+    update(map, 0, 0, size_x_, -dy);
+    update(map, 0, size_y_ - 1, size_x_, size_y_);
+  }
+}
+
+void CostmapPyramid::pool(const Costmap2D& map, unsigned int level, unsigned int bx0, unsigned int by0,
+                          unsigned int bxn, unsigned int byn)
+{
+  // block b pools the blocks, or cells for level 1, 2b - bit and 2b + 1 - bit of the level below
+  const unsigned char* source = level == 1 ? map.getCharMap() : &levels_[level - 2][0];
+  int source_stride = level == 1 ? size_x_ : level_stride_x_[level - 2];
+  int source_x = level == 1 ? size_x_ : level_size_x_[level - 2];
+  int source_y = level == 1 ? size_y_ : level_size_y_[level - 2];
+  int bit_x = (phase_x_ >> (level - 1)) & 1, bit_y = (phase_y_ >> (level - 1)) & 1;
+  unsigned char* blocks = &levels_[level - 1][0];
+  unsigned int stride = level_stride_x_[level - 1];
+  for (unsigned int by = by0; by < byn; ++by)
+  {
+    // a block over the edge reads the one row or column inside twice instead of checking in the inner loop
+    int r_0 = 2 * (int)by - bit_y, r_1 = r_0 + 1;
+    if (r_0 < 0)
+      r_0 = r_1;
+    if (r_1 >= source_y)
+      r_1 = r_0;
+    const unsigned char* row_0 = source + r_0 * source_stride;
+    const unsigned char* row_1 = source + r_1 * source_stride;
+    for (unsigned int bx = bx0; bx < bxn; ++bx)
+    {
+      int c_0 = 2 * (int)bx - bit_x, c_1 = c_0 + 1;
+      if (c_0 < 0)
+        c_0 = c_1;
+      if (c_1 >= source_x)
+        c_1 = c_0;
+      blocks[by * stride + bx] = std::max(std::max(row_0[c_0], row_0[c_1]), std::max(row_1[c_0], row_1[c_1]));
+    }
+  }
+}
+
+unsigned char CostmapPyramid::getMaxCost(int x0, int y0, int xn, int yn) const
+{
+  x0 = std::max(x0, 0);
+  y0 = std::max(y0, 0);
+  xn = std::min(xn, (int)size_x_);
+  yn = std::min(yn, (int)size_y_);
+  if (xn <= x0 || yn <= y0)
+    return 0;
+  if (num_levels_ == 0)
+    return NO_INFORMATION;
+
+  // the coarsest level whose blocks fit into the longer side of the window, so it spans at most three
+  unsigned int extent = std::max(xn - x0, yn - y0);
+  unsigned int level = 1;
+  while (level < num_levels_ && (2u << level) <= extent)
+    ++level;
+  const std::vector<unsigned char>& blocks = levels_[level - 1];
+  unsigned int stride = level_stride_x_[level - 1];
+  unsigned int mask = (1u << level) - 1;
+  unsigned int phase_x = phase_x_ & mask, phase_y = phase_y_ & mask;
+  unsigned int bxn = ((xn - 1 + phase_x) >> level) + 1, byn = ((yn - 1 + phase_y) >> level) + 1;
+  unsigned char max_cost = 0;
+  for (unsigned int by = (y0 + phase_y) >> level; by < byn; ++by)
+  {
+    for (unsigned int bx = (x0 + phase_x) >> level; bx < bxn; ++bx)
+      max_cost = std::max(max_cost, blocks[by * stride + bx]);
+  }
+  return max_cost;
+}
+
+}  // namespace costmap_2d
@@ -0,0 +1,39 @@
+#include <costmap_2d/costmap_snapshot.h>
+#include <algorithm>
+
+namespace costmap_2d
+{
+
+const unsigned int CostmapSnapshot::HISTORY;
+
+CostmapSnapshot::CostmapSnapshot() :
+    epoch_(0), full_change_epoch_(0)
+{
+  for (unsigned int e = 0; e < HISTORY; ++e)
+  {
+    changed_[e][0] = changed_[e][1] = 1e30;
+    changed_[e][2] = changed_[e][3] = -1e30;
+  }
+}
+
+bool CostmapSnapshot::getChangedBoundsSince(unsigned long epoch, double& minx, double& miny, double& maxx,
+                                            double& maxy) const
+{
+  minx = miny = 1e30;
+  maxx = maxy = -1e30;
+  if (epoch >= epoch_)
+    return true;
+  if (full_change_epoch_ > epoch || epoch_ - epoch > HISTORY)
+    return false;
+  for (unsigned long e = epoch + 1; e <= epoch_; ++e)
+  {
+    const double* changed = changed_[e % HISTORY];
+    minx = std::min(minx, changed[0]);
+    miny = std::min(miny, changed[1]);
+    maxx = std::max(maxx, changed[2]);
+    maxy = std::max(maxy, changed[3]);
+  }
+  return true;
+}
+
+}  // namespace costmap_2d
@@ -0,0 +1,179 @@
+#include <costmap_2d/footprint_checker.h>
+#include <costmap_2d/cost_values.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+namespace costmap_2d
+{
+
+FootprintChecker::FootprintChecker() :
+    resolution_(0.0), num_headings_(0), num_phases_(0), max_offset_(0)
+{
+}
+
+void FootprintChecker::setFootprint(const std::vector<geometry_msgs::Point>& footprint, double resolution,
+                                    unsigned int num_headings, unsigned int num_phases)
+{
+  bool unchanged = isConfigured() && resolution == resolution_ && num_headings == num_headings_
+      && num_phases == num_phases_ && footprint.size() == footprint_.size();
+  for (unsigned int i = 0; unchanged && i < footprint.size(); ++i)
+    unchanged = footprint[i].x == footprint_[i].x && footprint[i].y == footprint_[i].y;
+  if (unchanged)
+    return;
+
+  footprint_ = footprint;
+  resolution_ = resolution;
+  num_headings_ = std::max(num_headings, 1u);
+  num_phases_ = std::max(num_phases, 1u);
+  stamp_begin_.clear();
+  offsets_.clear();
+  max_offset_ = 0;
+  if (footprint_.empty() || resolution_ <= 0.0)
+    return;
+
+  for (unsigned int h = 0; h < num_headings_; ++h)
+  {
+    double angle = 2 * M_PI * h / num_headings_;
+    for (unsigned int py = 0; py < num_phases_; ++py)
+    {
+      for (unsigned int px = 0; px < num_phases_; ++px)
+      {
+        stamp_begin_.push_back(offsets_.size());
+        rasterize(angle, (px + 0.5) / num_phases_, (py + 0.5) / num_phases_);
+      }
+    }
+  }
+  stamp_begin_.push_back(offsets_.size());
+  for (unsigned int o = 0; o < offsets_.size(); ++o)
+    max_offset_ = std::max(max_offset_, abs(offsets_[o]));
+}
+
+void FootprintChecker::rasterize(double angle, double phase_x, double phase_y)
+{
+  // the footprint in cell units, relative to the lower left corner of the cell of the reference point
+  double cos_a = cos(angle), sin_a = sin(angle);
+  std::vector<double> vx(footprint_.size()), vy(footprint_.size());
+  for (unsigned int i = 0; i < footprint_.size(); ++i)
+  {
+    vx[i] = phase_x + (cos_a * footprint_[i].x - sin_a * footprint_[i].y) / resolution_;
+    vy[i] = phase_y + (sin_a * footprint_[i].x + cos_a * footprint_[i].y) / resolution_;
+  }
+
+  int min_x = (int)floor(std::min(0.0, *std::min_element(vx.begin(), vx.end())));
+  int min_y = (int)floor(std::min(0.0, *std::min_element(vy.begin(), vy.end())));
+  int max_x = (int)floor(std::max(0.0, *std::max_element(vx.begin(), vx.end())));
+  int max_y = (int)floor(std::max(0.0, *std::max_element(vy.begin(), vy.end())));
+  int width = max_x - min_x + 1;
+  std::vector<bool> covered(width * (max_y - min_y + 1), false);
+
+  // the cell of the reference point is always part of the stamp, so tiny footprints degrade to a point check
+  covered[(0 - min_y) * width + (0 - min_x)] = true;
+
+  // outline: every cell an edge passes through
+  for (unsigned int i = 0; i < vx.size(); ++i)
+  {
+    unsigned int j = (i + 1) % vx.size();
+    double length = hypot(vx[j] - vx[i], vy[j] - vy[i]);
+    unsigned int num_samples = (unsigned int)ceil(length * 4) + 1;
+    for (unsigned int k = 0; k <= num_samples; ++k)
+    {
+      double t = (double)k / num_samples;
+      int cx = (int)floor(vx[i] + t * (vx[j] - vx[i]));
+      int cy = (int)floor(vy[i] + t * (vy[j] - vy[i]));
+      covered[(cy - min_y) * width + (cx - min_x)] = true;
+    }
+  }
+
+  // fill: every cell whose center lies inside the polygon
+  for (int cy = min_y; cy <= max_y; ++cy)
+  {
+    for (int cx = min_x; cx <= max_x; ++cx)
+    {
+      double px = cx + 0.5, py = cy + 0.5;
+      bool inside = false;
+      for (unsigned int i = 0, j = vx.size() - 1; i < vx.size(); j = i++)
+      {
+        if ((vy[i] > py) != (vy[j] > py) && px < vx[j] + (py - vy[j]) * (vx[i] - vx[j]) / (vy[i] - vy[j]))
+          inside = !inside;
+      }
+      if (inside)
+        covered[(cy - min_y) * width + (cx - min_x)] = true;
+    }
+  }
+
+  for (int cy = min_y; cy <= max_y; ++cy)
+  {
+    for (int cx = min_x; cx <= max_x; ++cx)
+    {
+      if (covered[(cy - min_y) * width + (cx - min_x)])
+      {
+        offsets_.push_back(cx);
+        offsets_.push_back(cy);
+      }
+    }
+  }
+}
+
+unsigned char FootprintChecker::footprintCost(const Costmap2D& map, double x, double y, double theta) const
+{
+  if (!isConfigured())
+    return 0;
+  int mx, my;
+  unsigned int stamp;
+  getStamp(map, x, y, theta, mx, my, stamp);
+  return stampCost(map, mx, my, stamp);
+}
+
+void FootprintChecker::getStamp(const Costmap2D& map, double x, double y, double theta, int& mx, int& my,
+                                unsigned int& stamp) const
+{
+  double cell_x = (x - map.getOriginX()) / resolution_;
+  double cell_y = (y - map.getOriginY()) / resolution_;
+  mx = (int)floor(cell_x);
+  my = (int)floor(cell_y);
+  unsigned int px = std::min((unsigned int)((cell_x - mx) * num_phases_), num_phases_ - 1);
+  unsigned int py = std::min((unsigned int)((cell_y - my) * num_phases_), num_phases_ - 1);
+  int h = (int)floor(theta * num_headings_ / (2 * M_PI) + 0.5) % (int)num_headings_;
+  if (h < 0)
+    h += num_headings_;
+  stamp = (h * num_phases_ + py) * num_phases_ + px;
+}
+
+unsigned char FootprintChecker::stampCost(const Costmap2D& map, int mx, int my, unsigned int stamp) const
+{
+  const unsigned char* costs = map.getCharMap();
+  int size_x = map.getSizeInCellsX(), size_y = map.getSizeInCellsY();
+  unsigned char max_cost = 0;
+  for (unsigned int o = stamp_begin_[stamp]; o < stamp_begin_[stamp + 1]; o += 2)
+  {
+    int cx = mx + offsets_[o], cy = my + offsets_[o + 1];
+    if (cx < 0 || cy < 0 || cx >= size_x || cy >= size_y)
+      continue;
+    unsigned char cost = costs[cy * size_x + cx];
+    if (cost == LETHAL_OBSTACLE)
+      return LETHAL_OBSTACLE;
+    max_cost = std::max(max_cost, cost);
+  }
+  return max_cost;
+}
+
+unsigned char FootprintChecker::sweptCost(const Costmap2D& map, double x0, double y0, double theta0, double x1,
+                                          double y1, double theta1) const
+{
+  double d_theta = atan2(sin(theta1 - theta0), cos(theta1 - theta0));
+  unsigned int num_checks = getNumSweptChecks(hypot(x1 - x0, y1 - y0), d_theta);
+
+  unsigned char max_cost = 0;
+  for (unsigned int k = 1; k <= num_checks; ++k)
+  {
+    double t = (double)k / num_checks;
+    unsigned char cost = footprintCost(map, x0 + t * (x1 - x0), y0 + t * (y1 - y0), theta0 + t * d_theta);
+    if (cost == LETHAL_OBSTACLE)
+      return LETHAL_OBSTACLE;
+    max_cost = std::max(max_cost, cost);
+  }
+  return max_cost;
+}
+
+}  // namespace costmap_2d
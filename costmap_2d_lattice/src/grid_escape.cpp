@@ -0,0 +1,188 @@
+#include <costmap_2d/grid_escape.h>
+#include <ros/time.h>
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace costmap_2d
+{
+
+namespace
+{
+
+// the time limit is checked every this many expansions
+const unsigned int TIME_CHECK_PERIOD = 64;
+
+double octileDistance(double dx, double dy)
+{
+  dx = fabs(dx);
+  dy = fabs(dy);
+  return std::max(dx, dy) + (M_SQRT2 - 1.0) * std::min(dx, dy);
+}
+
+}  // namespace
+
+GridEscape::GridEscape() :
+    node_budget_(20000), time_budget_(0.0), blocked_cost_(INSCRIBED_INFLATED_OBSTACLE), cost_weight_(1.0),
+    generation_now_(0), reached_goal_(false), num_expanded_(0)
+{
+}
+
+void GridEscape::configure(unsigned int node_budget, double time_budget, unsigned char blocked_cost,
+                           double cost_weight)
+{
+  node_budget_ = node_budget;
+  time_budget_ = time_budget;
+  blocked_cost_ = blocked_cost;
+  cost_weight_ = cost_weight;
+  // every expansion queues at most 8 cells, and the path holds at most every expanded cell
+  open_.reserve(8 * node_budget_ + 1);
+  path_x_.reserve(node_budget_ + 1);
+  path_y_.reserve(node_budget_ + 1);
+}
+
+void GridEscape::resize(unsigned int size_x, unsigned int size_y)
+{
+  unsigned int num_cells = size_x * size_y;
+  if (generation_.size() == num_cells)
+    return;
+  g_.assign(num_cells, DBL_MAX);
+  parent_.assign(num_cells, -1);
+  generation_.assign(num_cells, 0);
+  closed_.assign(num_cells, 0);
+  generation_now_ = 0;
+  open_.reset(0.0, 0.5, 4 * (size_x + size_y));
+}
+
+bool GridEscape::search(const Costmap2D& map, double start_x, double start_y, double goal_x, double goal_y)
+{
+  ros::SteadyTime start_time = ros::SteadyTime::now();
+  path_x_.clear();
+  path_y_.clear();
+  reached_goal_ = false;
+  num_expanded_ = 0;
+
+  unsigned int start_mx, start_my;
+  if (!map.worldToMap(start_x, start_y, start_mx, start_my))
+    return false;
+  int size_x = map.getSizeInCellsX(), size_y = map.getSizeInCellsY();
+  resize(size_x, size_y);
+  // a new generation forgets every cell in O(1), they are only wiped once the counter wraps
+  if (++generation_now_ == 0)
+  {
+    std::fill(generation_.begin(), generation_.end(), 0);
+    std::fill(closed_.begin(), closed_.end(), 0);
+    generation_now_ = 1;
+  }
+
+  // the goal in cells, it may lie outside the map
+  double resolution = map.getResolution();
+  double goal_cx = (goal_x - map.getOriginX()) / resolution - 0.5;
+  double goal_cy = (goal_y - map.getOriginY()) / resolution - 0.5;
+  int goal_index = -1;
+  unsigned int goal_mx, goal_my;
+  if (map.worldToMap(goal_x, goal_y, goal_mx, goal_my))
+    goal_index = map.getIndex(goal_mx, goal_my);
+
+  // priorities are in cells, a bucket holds half a cell
+  int start = map.getIndex(start_mx, start_my);
+  double h_start = octileDistance(goal_cx - start_mx, goal_cy - start_my);
+  open_.reset(h_start, 0.5, 4 * (size_x + size_y));
+  g_[start] = 0.0;
+  parent_[start] = -1;
+  generation_[start] = generation_now_;
+  open_.push(start, h_start);
+
+  const unsigned char* costs = map.getCharMap();
+  const int dx[8] = {1, -1, 0, 0, 1, 1, -1, -1};
+  const int dy[8] = {0, 0, 1, -1, 1, -1, 1, -1};
+  int best = start;
+  double best_h = h_start;
+  unsigned int index;
+  double f;
+  while (open_.pop(index, f))
+  {
+    if (closed_[index] == generation_now_)
+      continue;  // queued again with a lower cost and expanded already
+    int cx = index % size_x, cy = index / size_x;
+    double h = f - g_[index];
+    if (h < best_h)
+    {
+      best = index;
+      best_h = h;
+    }
+    if ((int)index == goal_index)
+    {
+      reached_goal_ = true;
+      break;
+    }
+    if (num_expanded_ >= node_budget_)
+      break;
+    if (time_budget_ > 0.0 && num_expanded_ % TIME_CHECK_PERIOD == 0 && num_expanded_ > 0
+        && (ros::SteadyTime::now() - start_time).toSec() > time_budget_)
+      break;
+    closed_[index] = generation_now_;
+    ++num_expanded_;
+
+    for (int k = 0; k < 8; ++k)
+    {
+      int nx = cx + dx[k], ny = cy + dy[k];
+      if (nx < 0 || ny < 0 || nx >= size_x || ny >= size_y)
+        continue;
+      int next = ny * size_x + nx;
+      if (!canEnter(costs[index], costs[next]) || closed_[next] == generation_now_)
+        continue;
+      // no corner cutting past a cell that cannot be entered
+      if (k >= 4 && (!canEnter(costs[index], costs[cy * size_x + nx])
+                     || !canEnter(costs[index], costs[ny * size_x + cx])))
+        continue;
+      double step = (k < 4 ? 1.0 : M_SQRT2) * (1.0 + cost_weight_ * costs[next] / 100.0);
+      double g = g_[index] + step;
+      if (generation_[next] == generation_now_ && g_[next] <= g)
+        continue;
+      g_[next] = g;
+      parent_[next] = index;
+      generation_[next] = generation_now_;
+      open_.push(next, g + octileDistance(goal_cx - nx, goal_cy - ny));
+    }
+  }
+
+  if (best == start && !reached_goal_)
+    return false;
+
+  // out of budget or without a way to the goal, the cell closest to it is the escape
+  for (int n = best; n >= 0; n = parent_[n])
+  {
+    double wx, wy;
+    map.mapToWorld(n % size_x, n / size_x, wx, wy);
+    path_x_.push_back(wx);
+    path_y_.push_back(wy);
+  }
+  std::reverse(path_x_.begin(), path_x_.end());
+  std::reverse(path_y_.begin(), path_y_.end());
+  return true;
+}
+
+bool GridEscape::getLookahead(double distance, double& x, double& y) const
+{
+  if (path_x_.empty())
+    return false;
+  x = path_x_.back();
+  y = path_y_.back();
+  double travelled = 0.0;
+  for (unsigned int k = 1; k < path_x_.size(); ++k)
+  {
+    double step = hypot(path_x_[k] - path_x_[k - 1], path_y_[k] - path_y_[k - 1]);
+    if (travelled + step >= distance)
+    {
+      double t = (distance - travelled) / step;
+      x = path_x_[k - 1] + t * (path_x_[k] - path_x_[k - 1]);
+      y = path_y_[k - 1] + t * (path_y_[k] - path_y_[k - 1]);
+      return true;
+    }
+    travelled += step;
+  }
+  return true;
+}
+
+}  // namespace costmap_2d
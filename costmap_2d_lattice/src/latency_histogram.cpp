@@ -0,0 +1,84 @@
+#include <costmap_2d/latency_histogram.h>
+#include <algorithm>
+#include <cmath>
+
+namespace costmap_2d
+{
+
+const unsigned int LatencySnapshot::NUM_BUCKETS;
+
+LatencySnapshot::LatencySnapshot() :
+    count(0), sum(0.0), max(0.0)
+{
+  std::fill(counts, counts + NUM_BUCKETS, 0u);
+}
+
+double LatencySnapshot::percentile(double q) const
+{
+  if (count == 0)
+    return 0.0;
+  // the rank of the quantile, counted from 1
+  unsigned int rank = std::max(1u, static_cast<unsigned int>(ceil(std::min(std::max(q, 0.0), 1.0) * count)));
+  unsigned int seen = 0;
+  for (unsigned int b = 0; b < NUM_BUCKETS; ++b)
+  {
+    seen += counts[b];
+    if (seen >= rank)
+      return std::min(LatencyHistogram::getBucketLimit(b), max);
+  }
+  return max;
+}
+
+LatencyHistogram::LatencyHistogram() :
+    sum_(0), max_(0)
+{
+  for (unsigned int b = 0; b < LatencySnapshot::NUM_BUCKETS; ++b)
+    counts_[b].store(0, boost::memory_order_relaxed);
+}
+
+unsigned int LatencyHistogram::getBucket(double seconds)
+{
+  // bucket 0 holds everything below 1 us, then four buckets per octave
+  double us = seconds * 1e6;
+  if (!(us >= 1.0))
+    return 0;
+  int exponent;
+  double mantissa = frexp(us, &exponent);  // us = mantissa * 2^exponent, mantissa in [0.5, 1)
+  unsigned int bucket = 1 + (exponent - 1) * 4 + static_cast<unsigned int>((2 * mantissa - 1) * 4);
+  return std::min(bucket, LatencySnapshot::NUM_BUCKETS - 1);
+}
+
+double LatencyHistogram::getBucketLimit(unsigned int bucket)
+{
+  if (bucket == 0)
+    return 1e-6;
+  unsigned int octave = (bucket - 1) / 4, quarter = (bucket - 1) % 4;
+  return ldexp(1.0 + (quarter + 1) * 0.25, octave) * 1e-6;
+}
+
+void LatencyHistogram::record(double seconds)
+{
+  unsigned long long ns = seconds > 0.0 ? static_cast<unsigned long long>(seconds * 1e9) : 0;
+  counts_[getBucket(seconds)].fetch_add(1, boost::memory_order_relaxed);
+  sum_.fetch_add(ns, boost::memory_order_relaxed);
+  unsigned long long max = max_.load(boost::memory_order_relaxed);
+  while (ns > max && !max_.compare_exchange_weak(max, ns, boost::memory_order_relaxed))
+  {
+  }
+}
+
+void LatencyHistogram::take(LatencySnapshot& snapshot)
+{
+  // a duration recorded while the counts are taken may end up in this snapshot or the next
+  // one, or split between them, which is fine for statistics over many ticks
+  snapshot.count = 0;
+  for (unsigned int b = 0; b < LatencySnapshot::NUM_BUCKETS; ++b)
+  {
+    snapshot.counts[b] = counts_[b].exchange(0, boost::memory_order_relaxed);
+    snapshot.count += snapshot.counts[b];
+  }
+  snapshot.sum = sum_.exchange(0, boost::memory_order_relaxed) * 1e-9;
+  snapshot.max = max_.exchange(0, boost::memory_order_relaxed) * 1e-9;
+}
+
+}  // namespace costmap_2d
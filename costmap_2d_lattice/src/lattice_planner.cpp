@@ -0,0 +1,927 @@
+#include <costmap_2d/lattice_planner.h>
+#include <costmap_2d/cost_values.h>
+#include <ros/console.h>
+#include <ros/time.h>
+#include <boost/bind.hpp>
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace costmap_2d
+{
+
+namespace
+{
+// engine input per engine level [m/s^2]
+const double COF_ENGINE = 0.27;
+// the engine is eased off above the first speed and closed above the second one [m/s]
+const double SPEED_SWITCH = 4.0, SPEED_TOOFAST = 5.0;
+// the levels of the longitudinal product, acceleration a is engine level a % 3 with brake level a / 3
+const double ENGINE_LEVELS[3] = {0, 1, 2};
+const double BRAKE_LEVELS[4] = {0, 5, 10, 15};
+// the step of a rollout whose steering is sent, ahead by the time the planning takes
+const int STEERING_STEP = 5;
+}
+
+const unsigned int LatticePlanner::MAX_START_HYPOTHESES;
+
+LatticePlanner::LatticePlanner() :
+    num_pruned_(0), pinned_(0), best_score_(DBL_MAX), best_primitive_(0), steering_current_(0.0),
+    flag_slide_(false)
+{
+  planner_task_ = boost::bind(&LatticePlanner::plannerTask, this, _1);
+  warm_plan_.valid = false;
+  warm_plan_.primitive = 0;
+  task_inputs_.pyramid = NULL;
+}
+
+void LatticePlanner::configure(const LatticePlannerConfig& config)
+{
+  config_ = config;
+  if (!(config_.time_step > 0.0))
+  {
+    ROS_WARN("lattice: a time step of %.2f s is not positive, using the default", config_.time_step);
+    config_.time_step = LatticePlannerConfig().time_step;
+  }
+  // the rollouts need a step past the one whose steering is sent
+  if ((int)(config_.horizon / config_.time_step) < STEERING_STEP + 1)
+  {
+    double horizon = (STEERING_STEP + 1.5) * config_.time_step;
+    ROS_WARN("lattice: a horizon of %.2f s is too short for steps of %.2f s, using %.2f s", config_.horizon,
+             config_.time_step, horizon);
+    config_.horizon = horizon;
+  }
+
+  std::vector<double> accelerations(1, 0.0);
+  if (config_.use_longitudinal_product)
+  {
+    accelerations.clear();
+    for (int b = 0; b < 4; ++b)
+    {
+      for (int e = 0; e < 3; ++e)
+        accelerations.push_back(ENGINE_LEVELS[e] * COF_ENGINE - BRAKE_LEVELS[b] * config_.cof_break);
+    }
+  }
+  primitives_.configure(config_.steering_targets, accelerations, config_.time_step, config_.horizon);
+  u_engine_list_.assign(primitives_.getNumSteps(), 0.0);
+  u_break_list_.assign(primitives_.getNumSteps(), 0.0);
+  scores_.assign(primitives_.size(), 0.0);
+  expected_scores_.assign(primitives_.size(), 0.0);
+  worst_scores_.assign(primitives_.size(), 0.0);
+  hypotheses_.reserve(MAX_START_HYPOTHESES);
+  bounds_.assign(primitives_.size(), 0.0);
+  order_.resize(primitives_.size());
+  pruned_.assign(primitives_.size(), 0);
+  num_pruned_ = 0;
+
+  // the coarse pass takes every anytime_coarse_stride-th steering target and acceleration, the
+  // outermost ones and the straight primitive
+  claimed_.assign(primitives_.size(), 0);
+  scored_.assign(primitives_.size(), 1);
+  coarse_.clear();
+  unsigned int stride = std::max(config_.anytime_coarse_stride, 1);
+  unsigned int num_steering = primitives_.getNumSteeringTargets();
+  unsigned int num_accelerations = primitives_.getNumAccelerations();
+  unsigned int straight = primitives_.getSteeringIndex(primitives_.getStraightPrimitive());
+  for (unsigned int a = 0; a < num_accelerations; ++a)
+  {
+    if (a % stride != 0 && a != num_accelerations - 1)
+      continue;
+    for (unsigned int t = 0; t < num_steering; ++t)
+    {
+      if (t % stride == 0 || t == num_steering - 1 || t == straight)
+        coarse_.push_back(primitives_.getPrimitive(t, a));
+    }
+  }
+
+  escape_.configure(std::max(config_.escape_node_budget, 1), config_.escape_time_budget,
+                    INSCRIBED_INFLATED_OBSTACLE, 1.0);
+
+  if (config_.search_depth > 1)
+    lattice_search_.configure(config_.steering_targets, config_.time_step, config_.search_stage_time,
+                              config_.search_depth, config_.search_node_budget, config_.search_path_weight);
+  else
+    lattice_search_ = LatticeSearch();
+
+  primitive_cache_ = PrimitiveCache();
+  if (config_.use_primitive_cache)
+  {
+    // the engine inputs plan() can choose
+    std::vector<double> engine_levels(1, 0.0);
+    if (!config_.use_longitudinal_product)
+    {
+      engine_levels.push_back(1 * COF_ENGINE);
+      engine_levels.push_back(2 * COF_ENGINE);
+    }
+    if (!primitive_cache_.build(primitives_, engine_levels, config_.cache_max_speed,
+                                config_.cache_speed_resolution, config_.cache_steering_resolution))
+      ROS_WARN("lattice: the primitive cache is invalid or too large for its resolutions, rolling out instead");
+  }
+
+  if (!config_.use_footprint_check)
+    footprint_checker_ = FootprintChecker();
+
+  pool_.reset(new WorkerPool(std::max(config_.num_threads, 0)));
+  warm_plan_.valid = false;
+}
+
+void LatticePlanner::setFootprint(const std::vector<geometry_msgs::Point>& footprint, double resolution)
+{
+  // the stamps are only rebuilt if the footprint or the resolution changed
+  if (config_.use_footprint_check)
+    footprint_checker_.setFootprint(footprint, resolution);
+}
+
+double LatticePlanner::getEngineLevel(unsigned int p) const
+{
+  return ENGINE_LEVELS[primitives_.getAccelerationIndex(p) % 3];
+}
+
+double LatticePlanner::getBrakeLevel(unsigned int p) const
+{
+  return BRAKE_LEVELS[primitives_.getAccelerationIndex(p) / 3 % 4];
+}
+
+void LatticePlanner::plan(const Costmap2D& map, const double* state, double now, const double* changed_bounds,
+                          double margin, LatticePlan& plan, const CellCounters* counters,
+                          const CostmapPyramid* pyramid)
+{
+  ros::SteadyTime start_time = ros::SteadyTime::now();
+  plan = LatticePlan();
+  double s_current[4];
+  std::copy(state, state + 4, s_current);
+
+  // calculate input
+  unsigned int len_t_list = primitives_.getNumSteps();
+  unsigned int num_traj = primitives_.size();
+  bool gear_change = s_current[3] > SPEED_SWITCH;
+  bool engin_close = s_current[3] > SPEED_TOOFAST;
+  for (unsigned int i = 0; i < len_t_list; ++i)
+  {
+    u_break_list_[i] = 0.0;
+    if (config_.use_longitudinal_product)
+    {
+      // every primitive carries its own engine and brake input
+      u_engine_list_[i] = 0.0;
+    }
+    else if (gear_change && !engin_close && !flag_slide_)
+    {
+      u_engine_list_[i] = 1 * COF_ENGINE;
+    }
+    else if (engin_close)
+    {
+      u_engine_list_[i] = 0.0;
+      flag_slide_ = true;
+    }
+    else
+    {
+      u_engine_list_[i] = 2 * COF_ENGINE;
+      flag_slide_ = false;
+    }
+  }
+  // warm start: follow the last plan on while the car tracks it and nothing new blocks its remainder,
+  // decided before anything is rolled out, so such a tick costs no more than the check of the remainder
+  if (config_.use_warm_start && changed_bounds)
+  {
+    int warm_step = warmPlanStep(map, s_current, now, changed_bounds, margin);
+    if (warm_step >= 0)
+    {
+      steering_current_ = warm_plan_.u[warm_step + STEERING_STEP];
+      ROS_DEBUG("lattice: following the last plan, step %d", warm_step);
+      plan.primitive = warm_plan_.primitive;
+      plan.steering = steering_current_;
+      plan.fast = warm_plan_.fast;
+      plan.warm_started = true;
+      plan.goal_x = warm_plan_.goal_x;
+      plan.goal_y = warm_plan_.goal_y;
+      ros::SteadyTime switch_start = ros::SteadyTime::now();
+      plan.switch_map = switchMap(map, s_current[2], counters);
+      plan.timings.switch_map = (ros::SteadyTime::now() - switch_start).toSec();
+      plan.timings.total = (ros::SteadyTime::now() - start_time).toSec();
+      return;
+    }
+  }
+
+  // one rollout per primitive, the engine input is constant over the horizon, so the cached
+  // rollouts can be used if the state is covered
+  if (!primitive_cache_.transform(s_current, steering_current_, u_engine_list_[0], primitives_))
+    primitives_.rollout(s_current, steering_current_, &u_engine_list_[0], &u_break_list_[0]);
+
+  // the global goal lies goal_lookahead along the race line from the point closest to the car
+  double s_car, dist_to_path;
+  reference_path_.project(s_current[0], s_current[1], s_car, dist_to_path);
+  reference_path_.pointAt(s_car + config_.goal_lookahead, plan.goal_x, plan.goal_y);
+  ros::SteadyTime rollout_done = ros::SteadyTime::now();
+  plan.timings.rollout = (rollout_done - start_time).toSec();
+
+  // sized on every replan, so the grid search does not allocate on the tick it is needed
+  if (config_.use_escape_search)
+    escape_.resize(map.getSizeInCellsX(), map.getSizeInCellsY());
+  setupHypotheses(s_current);
+
+  // one task per primitive plus one for the map switch, every task writes its own result slot
+  // so the selection below does not depend on the order the tasks finish in
+  task_inputs_.map = &map;
+  task_inputs_.counters = counters;
+  task_inputs_.pyramid = pyramid && pyramid->getNumLevels() > 0 && footprint_checker_.isConfigured()
+      && pyramid->getSizeInCellsX() == map.getSizeInCellsX() && pyramid->getSizeInCellsY() == map.getSizeInCellsY()
+      ? pyramid : NULL;
+  task_inputs_.goal_x = plan.goal_x;
+  task_inputs_.goal_y = plan.goal_y;
+  task_inputs_.theta = s_current[2];
+  task_inputs_.switch_result = &plan.switch_map;
+  task_inputs_.switch_time = &plan.timings.switch_map;
+  if (config_.use_branch_and_bound)
+    computeBounds(plan.goal_x, plan.goal_y);
+  bool anytime = config_.plan_deadline > 0.0;
+  if (anytime)
+  {
+    // primitives left unclaimed at the deadline keep DBL_MAX, so they are never selected and
+    // count as blocked for the speed pair
+    std::fill(scores_.begin(), scores_.end(), DBL_MAX);
+    std::fill(expected_scores_.begin(), expected_scores_.end(), DBL_MAX);
+    std::fill(worst_scores_.begin(), worst_scores_.end(), DBL_MAX);
+    std::fill(scored_.begin(), scored_.end(), 0);
+    best_score_ = DBL_MAX;
+    best_primitive_ = primitives_.getStraightPrimitive();
+    deadline_ = start_time + ros::WallDuration(config_.plan_deadline);
+    // the coarse primitives belong to their own tasks, a refinement task starting first must not take
+    // one of them and leave another primitive unscored
+    boost::mutex::scoped_lock lock(best_mutex_);
+    std::fill(claimed_.begin(), claimed_.end(), 0);
+    for (unsigned int c = 0; c < coarse_.size(); ++c)
+      claimed_[coarse_[c]] = 1;
+  }
+  else
+  {
+    std::fill(scored_.begin(), scored_.end(), 1);
+  }
+  pool_->run(num_traj + 1, planner_task_);
+  if (config_.use_branch_and_bound)
+    resolvePruned(map, plan.goal_x, plan.goal_y);
+  plan.num_skipped = anytime ? std::count(claimed_.begin(), claimed_.end(), 0) : 0;
+  plan.num_scored = num_traj - plan.num_skipped - (config_.use_branch_and_bound ? num_pruned_ : 0);
+  ros::SteadyTime scoring_done = ros::SteadyTime::now();
+  plan.timings.scoring = (scoring_done - rollout_done).toSec();
+
+  // ties are broken towards the lowest primitive index
+  unsigned int num_blocked = 0;
+  unsigned int p_min = 0;
+  for (unsigned int p = 0; p < num_traj; ++p)
+  {
+    if (scores_[p] == DBL_MAX)
+      ++num_blocked;
+    if (scores_[p] < scores_[p_min])
+      p_min = p;
+  }
+  double score_min = scores_[p_min];
+  unsigned int num_score_min = std::count(scores_.begin(), scores_.end(), score_min);
+
+  // fast:0 uses the pair of slow speed, fast:1 the pair of fast speed
+  plan.fast = num_blocked > num_traj / 2 ? 0 : 1;
+
+  unsigned int traj_select = p_min;
+  // a plan picked without a clear winner is not followed on in the next ticks
+  bool warm_startable = true;
+  if (score_min == 0.0 && num_score_min < num_traj)
+  {
+    ROS_DEBUG("more than 1 traj's score is 0");
+    // skip the traj scored 0 and take the best of the rest
+    bool found = false;
+    for (unsigned int p = 0; p < num_traj; ++p)
+    {
+      if (scores_[p] != 0.0 && (!found || scores_[p] < scores_[traj_select]))
+      {
+        traj_select = p;
+        found = true;
+      }
+    }
+  }
+  else if (num_score_min >= num_traj)
+  {
+    warm_startable = false;
+    if (score_min == DBL_MAX || score_min == 0.0)
+    {
+      // with every primitive blocked, steer towards a point on a grid path around the obstacles,
+      // or, without one, towards the global goal alone
+      double target_x = plan.goal_x, target_y = plan.goal_y;
+      if (score_min == DBL_MAX && config_.use_escape_search
+          && escape_.search(map, s_current[0], s_current[1], plan.goal_x, plan.goal_y)
+          && escape_.getLookahead(config_.escape_lookahead, target_x, target_y))
+      {
+        plan.escaped = true;
+        ROS_DEBUG("all traj is score DBL_MAX, steering along a grid path of %u cells after %u expansions",
+                  (unsigned int)escape_.getPathX().size(), escape_.getNumExpanded());
+      }
+      else
+      {
+        ROS_DEBUG("all traj is score DBL_MAX, the score will be recomputed only based on the global goal");
+      }
+      for (unsigned int p = 0; p < num_traj; ++p)
+        scores_[p] = scoreGlobal(p, target_x, target_y);
+      traj_select = std::min_element(scores_.begin(), scores_.end()) - scores_.begin();
+      plan.fast = 0;
+    }
+    else
+    {
+      ROS_DEBUG("all traj is score 0,skip this time,use 0 steering as selected traj");
+      traj_select = primitives_.getStraightPrimitive();
+    }
+  }
+  else
+  {
+    ROS_DEBUG("Min traj found");
+    // keep the primitive of the last plan unless another one is clearly better, so equal scores do not flicker
+    unsigned int p_last = warm_plan_.primitive;
+    if (config_.use_warm_start && warm_plan_.valid && p_last < num_traj && scores_[p_last] != DBL_MAX
+        && scores_[p_last] <= scores_[traj_select] + config_.warm_start_hysteresis)
+      traj_select = p_last;
+  }
+
+  // the multi-stage search picks the first primitive of the cheapest chain, the single-stage scores above
+  // still decide the speed pair and are the fallback if every chain is blocked or the deadline has passed.
+  // The first stage of the last plan gets warm_start_hysteresis off its cost, so the search keeps it
+  // unless another chain is clearly cheaper.
+  int p_last_steering = config_.use_warm_start && warm_plan_.valid && warm_plan_.primitive < num_traj
+      ? (int)primitives_.getSteeringIndex(warm_plan_.primitive) : -1;
+  if (lattice_search_.getDepth() > 1 && plan.num_skipped == 0
+      && lattice_search_.search(map, footprint_checker_, reference_path_, s_current, steering_current_,
+                                u_engine_list_[0], plan.goal_x, plan.goal_y, p_last_steering,
+                                config_.warm_start_hysteresis))
+  {
+    // the stages only steer, the longitudinal input of the single-stage selection is kept
+    traj_select = primitives_.getPrimitive(lattice_search_.getChain()[0],
+                                           primitives_.getAccelerationIndex(traj_select));
+    ROS_DEBUG("lattice: search chain of %u stages after %u expansions%s",
+              (unsigned int)lattice_search_.getChain().size(), lattice_search_.getNumExpanded(),
+              lattice_search_.isComplete() ? "" : ", out of budget");
+  }
+
+  // considering the computing time, the offset should be set
+  steering_current_ = primitives_.u(traj_select, STEERING_STEP);
+  // the search only checked the first stage of its pick, and a warm start checks nothing but the
+  // changed area, so a primitive blocked within the horizon is never followed on
+  if (warm_startable && scores_[traj_select] != DBL_MAX)
+    storeWarmPlan(traj_select, plan.fast, s_current, now, plan.goal_x, plan.goal_y);
+  else
+    warm_plan_.valid = false;
+
+  plan.primitive = traj_select;
+  plan.steering = steering_current_;
+  ros::SteadyTime selection_done = ros::SteadyTime::now();
+  plan.timings.selection = (selection_done - scoring_done).toSec();
+  plan.timings.total = (selection_done - start_time).toSec();
+}
+
+void LatticePlanner::plannerTask(unsigned int task)
+{
+  const TaskInputs& in = task_inputs_;
+  if (task < primitives_.size())
+  {
+    // with branch and bound the tasks are handed out in the order of the bounds
+    if (config_.plan_deadline > 0.0)
+      scoreAnytime(*in.map, task, in.goal_x, in.goal_y);
+    else if (config_.use_branch_and_bound)
+      scoreBranchAndBound(*in.map, order_[task], in.goal_x, in.goal_y);
+    else
+      scores_[task] = scoreTrajectory(*in.map, task, in.goal_x, in.goal_y);
+  }
+  else
+  {
+    ros::SteadyTime switch_start = ros::SteadyTime::now();
+    *in.switch_result = switchMap(*in.map, in.theta, in.counters);
+    *in.switch_time = (ros::SteadyTime::now() - switch_start).toSec();
+  }
+}
+
+double LatticePlanner::scoreTrajectory(const Costmap2D& map, unsigned int p, double goal_x, double goal_y)
+{
+  double score, mean, worst;
+  if (hypotheses_.empty())
+  {
+    score = mean = worst = obstacleCost(map, p);
+  }
+  else if (obstacleCostBatch(map, p, mean, worst))
+  {
+    score = (1.0 - config_.hypothesis_worst_weight) * mean + config_.hypothesis_worst_weight * worst;
+  }
+  else
+  {
+    score = mean = worst = DBL_MAX;
+  }
+  if (score != DBL_MAX)
+  {
+    // the same terms in the same order as the bound of computeBounds(), so the bound never exceeds the score
+    double cost_global = scoreGlobal(p, goal_x, goal_y);
+    score += cost_global;
+    mean += cost_global;
+    worst += cost_global;
+    if (config_.use_longitudinal_product)
+    {
+      double cost_longitudinal = scoreLongitudinal(p);
+      score += cost_longitudinal;
+      mean += cost_longitudinal;
+      worst += cost_longitudinal;
+    }
+  }
+  expected_scores_[p] = mean;
+  worst_scores_[p] = worst;
+  return score;
+}
+
+double LatticePlanner::obstacleCost(const Costmap2D& map, unsigned int p) const
+{
+  double score = 0.0;
+  unsigned int len_t_list = primitives_.getNumSteps();
+  const CostmapPyramid* pyramid = task_inputs_.pyramid;
+  int reach = footprint_checker_.getMaxOffset();
+  for (unsigned int i = 0; i < len_t_list; ++i)
+  {
+    double x = primitives_.x(p, i), y = primitives_.y(p, i);
+    unsigned int x_map, y_map;
+    if (pyramid)
+    {
+      // broad phase: every swept pose lies between the cells of the two samples, and no stamp reaches
+      // further than reach from its cell, so the step costs nothing if that box is free
+      double x_prev = primitives_.x(p, i > 0 ? i - 1 : 0), y_prev = primitives_.y(p, i > 0 ? i - 1 : 0);
+      int mx0 = (int)floor((x_prev - map.getOriginX()) / map.getResolution());
+      int my0 = (int)floor((y_prev - map.getOriginY()) / map.getResolution());
+      int mx1 = (int)floor((x - map.getOriginX()) / map.getResolution());
+      int my1 = (int)floor((y - map.getOriginY()) / map.getResolution());
+      if (pyramid->getMaxCost(std::min(mx0, mx1) - reach, std::min(my0, my1) - reach,
+                              std::max(mx0, mx1) + reach + 1, std::max(my0, my1) + reach + 1) == FREE_SPACE)
+        continue;
+    }
+    if (footprint_checker_.isConfigured())
+    {
+      // the footprint swept since the previous sample, so nothing slips through between two samples
+      unsigned char cost;
+      if (i == 0)
+        cost = footprint_checker_.footprintCost(map, x, y, primitives_.theta(p, i));
+      else
+        cost = footprint_checker_.sweptCost(map, primitives_.x(p, i - 1), primitives_.y(p, i - 1),
+                                            primitives_.theta(p, i - 1), x, y, primitives_.theta(p, i));
+      if (cost == LETHAL_OBSTACLE)
+        return DBL_MAX;
+      score += cost / 100.0;
+    }
+    else if (map.worldToMap(x, y, x_map, y_map))
+    {
+      double cost_obstacle = static_cast<double>(map.getCost(x_map, y_map));
+      if (cost_obstacle == 254.0)
+        return DBL_MAX;
+      score += cost_obstacle / 100.0;
+    }
+  }
+  ROS_DEBUG("cost_obstacle:#####  %f", score);
+  return score;
+}
+
+bool LatticePlanner::obstacleCostBatch(const Costmap2D& map, unsigned int p, double& mean, double& worst) const
+{
+  // a rigid transform of the start moves every sample and every pose swept between two samples the
+  // same way, so the samples of all hypotheses are the transformed samples of the state. The
+  // hypotheses lie a few cm apart and most of them land on the same cell or footprint stamp at a
+  // check, which is then looked up once for all of them.
+  unsigned int num_hypotheses = hypotheses_.size();
+  double sums[MAX_START_HYPOTHESES];
+  unsigned char sample_costs[MAX_START_HYPOTHESES];
+  int seen_x[MAX_START_HYPOTHESES], seen_y[MAX_START_HYPOTHESES];
+  unsigned int seen_stamp[MAX_START_HYPOTHESES];
+  unsigned char seen_costs[MAX_START_HYPOTHESES];
+  std::fill(sums, sums + num_hypotheses, 0.0);
+
+  const unsigned char* costs = map.getCharMap();
+  unsigned int size_x = map.getSizeInCellsX();
+  bool use_footprint = footprint_checker_.isConfigured();
+  unsigned int len_t_list = primitives_.getNumSteps();
+  for (unsigned int i = 0; i < len_t_list; ++i)
+  {
+    std::fill(sample_costs, sample_costs + num_hypotheses, 0);
+    double x1 = primitives_.x(p, i), y1 = primitives_.y(p, i), theta1 = primitives_.theta(p, i);
+    double x0 = x1, y0 = y1, theta0 = theta1, d_theta = 0.0;
+    unsigned int num_checks = 1;
+    if (use_footprint && i > 0)
+    {
+      // the checks of sweptCost() from the previous sample
+      x0 = primitives_.x(p, i - 1);
+      y0 = primitives_.y(p, i - 1);
+      theta0 = primitives_.theta(p, i - 1);
+      d_theta = atan2(sin(theta1 - theta0), cos(theta1 - theta0));
+      num_checks = footprint_checker_.getNumSweptChecks(hypot(x1 - x0, y1 - y0), d_theta);
+    }
+
+    for (unsigned int c = 1; c <= num_checks; ++c)
+    {
+      double t = (double)c / num_checks;
+      double x = i > 0 && use_footprint ? x0 + t * (x1 - x0) : x1;
+      double y = i > 0 && use_footprint ? y0 + t * (y1 - y0) : y1;
+      double theta = i > 0 && use_footprint ? theta0 + t * d_theta : theta1;
+      unsigned int num_seen = 0;
+      for (unsigned int k = 0; k < num_hypotheses; ++k)
+      {
+        const HypothesisTransform& h = hypotheses_[k];
+        double hx = h.cos_theta * x - h.sin_theta * y + h.dx;
+        double hy = h.sin_theta * x + h.cos_theta * y + h.dy;
+        int mx, my;
+        unsigned int stamp = 0;
+        if (use_footprint)
+        {
+          footprint_checker_.getStamp(map, hx, hy, theta + h.dtheta, mx, my, stamp);
+        }
+        else
+        {
+          unsigned int x_map, y_map;
+          if (!map.worldToMap(hx, hy, x_map, y_map))
+            continue;
+          mx = x_map;
+          my = y_map;
+        }
+
+        unsigned int s = 0;
+        while (s < num_seen && (seen_x[s] != mx || seen_y[s] != my || seen_stamp[s] != stamp))
+          ++s;
+        if (s == num_seen)
+        {
+          seen_x[s] = mx;
+          seen_y[s] = my;
+          seen_stamp[s] = stamp;
+          seen_costs[s] =
+              use_footprint ? footprint_checker_.stampCost(map, mx, my, stamp) : costs[my * size_x + mx];
+          ++num_seen;
+        }
+        // blocked from one hypothesis is blocked, the car may well be there
+        if (seen_costs[s] == LETHAL_OBSTACLE)
+          return false;
+        sample_costs[k] = std::max(sample_costs[k], seen_costs[s]);
+      }
+    }
+    for (unsigned int k = 0; k < num_hypotheses; ++k)
+      sums[k] += sample_costs[k] / 100.0;
+  }
+
+  mean = 0.0;
+  worst = 0.0;
+  for (unsigned int k = 0; k < num_hypotheses; ++k)
+  {
+    mean += sums[k];
+    worst = std::max(worst, sums[k]);
+  }
+  mean /= num_hypotheses;
+  return true;
+}
+
+void LatticePlanner::setStartHypotheses(const std::vector<double>& offsets)
+{
+  unsigned int num_hypotheses = std::min((unsigned int)offsets.size() / 3, MAX_START_HYPOTHESES);
+  custom_hypotheses_.assign(offsets.begin(), offsets.begin() + 3 * num_hypotheses);
+}
+
+void LatticePlanner::setupHypotheses(const double* state)
+{
+  hypotheses_.clear();
+  // the sigma points of the configuration: the state, one standard deviation ahead, behind, left and
+  // right of the car, and turned either way
+  double sigma_points[7 * 3] = {0.0};
+  const double* offsets = sigma_points;
+  unsigned int num_hypotheses = 1;
+  if (!custom_hypotheses_.empty())
+  {
+    offsets = &custom_hypotheses_[0];
+    num_hypotheses = custom_hypotheses_.size() / 3;
+  }
+  else if (config_.pose_sigma_xy > 0.0 || config_.pose_sigma_theta > 0.0)
+  {
+    double along_x = config_.pose_sigma_xy * cos(state[2]), along_y = config_.pose_sigma_xy * sin(state[2]);
+    double* point = sigma_points + 3;
+    if (config_.pose_sigma_xy > 0.0)
+    {
+      const double shifts[4][2] = {{along_x, along_y}, {-along_x, -along_y}, {-along_y, along_x},
+                                   {along_y, -along_x}};
+      for (int k = 0; k < 4; ++k, point += 3)
+      {
+        point[0] = shifts[k][0];
+        point[1] = shifts[k][1];
+      }
+    }
+    if (config_.pose_sigma_theta > 0.0)
+    {
+      point[2] = config_.pose_sigma_theta;
+      point[5] = -config_.pose_sigma_theta;
+      point += 6;
+    }
+    num_hypotheses = (point - sigma_points) / 3;
+  }
+  else
+  {
+    return;
+  }
+
+  for (unsigned int k = 0; k < num_hypotheses; ++k)
+  {
+    // rotate the samples by dtheta around the start and move them with the start
+    const double* offset = offsets + 3 * k;
+    HypothesisTransform h;
+    h.dtheta = offset[2];
+    h.cos_theta = cos(h.dtheta);
+    h.sin_theta = sin(h.dtheta);
+    h.dx = state[0] + offset[0] - (h.cos_theta * state[0] - h.sin_theta * state[1]);
+    h.dy = state[1] + offset[1] - (h.sin_theta * state[0] + h.cos_theta * state[1]);
+    hypotheses_.push_back(h);
+  }
+}
+
+void LatticePlanner::computeBounds(double goal_x, double goal_y)
+{
+  // the obstacle cost is never negative, so the score without it is an admissible bound
+  unsigned int num_traj = primitives_.size();
+  for (unsigned int p = 0; p < num_traj; ++p)
+  {
+    bounds_[p] = scoreGlobal(p, goal_x, goal_y);
+    if (config_.use_longitudinal_product)
+      bounds_[p] += scoreLongitudinal(p);
+    order_[p] = p;
+    pruned_[p] = 0;
+  }
+  std::sort(order_.begin(), order_.end(), BoundOrder(bounds_));
+
+  // the warm start compares the last primitive against the winner, so it needs its true score
+  pinned_ = config_.use_warm_start && warm_plan_.valid ? warm_plan_.primitive : num_traj;
+  best_score_ = DBL_MAX;
+}
+
+void LatticePlanner::scoreBranchAndBound(const Costmap2D& map, unsigned int p, double goal_x, double goal_y)
+{
+  {
+    // only a bound strictly above the best score is pruned, so not even a tie on a lower index is lost
+    boost::mutex::scoped_lock lock(best_mutex_);
+    if (p != pinned_ && bounds_[p] > best_score_)
+    {
+      scores_[p] = expected_scores_[p] = worst_scores_[p] = bounds_[p];
+      pruned_[p] = 1;
+      return;
+    }
+  }
+  double score = scoreTrajectory(map, p, goal_x, goal_y);
+  scores_[p] = score;
+  boost::mutex::scoped_lock lock(best_mutex_);
+  best_score_ = std::min(best_score_, score);
+}
+
+void LatticePlanner::scoreAnytime(const Costmap2D& map, unsigned int task, double goal_x, double goal_y)
+{
+  unsigned int p;
+  {
+    boost::mutex::scoped_lock lock(best_mutex_);
+    if (task < coarse_.size())
+    {
+      p = coarse_[task];
+    }
+    else
+    {
+      // the coarse pass always runs, the refinement stops at the deadline
+      if (ros::SteadyTime::now() > deadline_)
+        return;
+      p = nextRefinement();
+      if (p >= primitives_.size())
+        return;
+      claimed_[p] = 1;
+    }
+    if (config_.use_branch_and_bound && p != pinned_ && bounds_[p] > best_score_)
+    {
+      scores_[p] = expected_scores_[p] = worst_scores_[p] = bounds_[p];
+      pruned_[p] = 1;
+      scored_[p] = 1;
+      return;
+    }
+  }
+  double score = scoreTrajectory(map, p, goal_x, goal_y);
+  boost::mutex::scoped_lock lock(best_mutex_);
+  scores_[p] = score;
+  scored_[p] = 1;
+  if (score < best_score_ || (score == best_score_ && p < best_primitive_))
+  {
+    best_score_ = score;
+    best_primitive_ = p;
+  }
+}
+
+unsigned int LatticePlanner::nextRefinement() const
+{
+  unsigned int num_traj = primitives_.size();
+  unsigned int best_t = primitives_.getSteeringIndex(best_primitive_);
+  unsigned int best_a = primitives_.getAccelerationIndex(best_primitive_);
+  unsigned int next = num_traj, next_distance = 0;
+  for (unsigned int p = 0; p < num_traj; ++p)
+  {
+    if (claimed_[p])
+      continue;
+    unsigned int t = primitives_.getSteeringIndex(p), a = primitives_.getAccelerationIndex(p);
+    unsigned int distance = (t > best_t ? t - best_t : best_t - t) + (a > best_a ? a - best_a : best_a - a);
+    if (next == num_traj || distance < next_distance)
+    {
+      next = p;
+      next_distance = distance;
+    }
+  }
+  return next;
+}
+
+void LatticePlanner::resolvePruned(const Costmap2D& map, double goal_x, double goal_y)
+{
+  unsigned int num_traj = primitives_.size();
+  unsigned int num_blocked = 0;
+  num_pruned_ = 0;
+  double score_min = DBL_MAX;
+  for (unsigned int p = 0; p < num_traj; ++p)
+  {
+    if (pruned_[p])
+      ++num_pruned_;
+    else if (scores_[p] == DBL_MAX)
+      ++num_blocked;
+    else
+      score_min = std::min(score_min, scores_[p]);
+  }
+
+  // a pruned primitive cannot win, but it may be blocked and count towards the speed pair, and
+  // a best score of 0 is skipped for the best of the rest, so those are scored in bound order
+  // until the decision is the same as with every primitive scored
+  for (unsigned int k = 0; k < num_traj && num_pruned_ > 0; ++k)
+  {
+    bool fast_known = num_blocked > num_traj / 2 || num_blocked + num_pruned_ <= num_traj / 2;
+    if (fast_known && score_min != 0.0)
+      break;
+    // past the deadline the pruned primitives keep their bounds and count as not blocked
+    if (config_.plan_deadline > 0.0 && ros::SteadyTime::now() > deadline_)
+      break;
+    unsigned int p = order_[k];
+    if (!pruned_[p])
+      continue;
+    scores_[p] = scoreTrajectory(map, p, goal_x, goal_y);
+    pruned_[p] = 0;
+    --num_pruned_;
+    if (scores_[p] == DBL_MAX)
+      ++num_blocked;
+  }
+}
+
+double LatticePlanner::scoreGlobal(unsigned int p, double goal_x, double goal_y) const
+{
+  double cost_global = 0.0;
+  unsigned int len_t_list = primitives_.getNumSteps();
+  for (unsigned int i = 0; i < len_t_list; ++i)
+    cost_global += pow(primitives_.x(p, i) - goal_x, 2) + pow(primitives_.y(p, i) - goal_y, 2);
+  ROS_DEBUG("cost_global:#####  %f", sqrt(cost_global / len_t_list));
+  return sqrt(cost_global / len_t_list);
+}
+
+double LatticePlanner::scoreLongitudinal(unsigned int p) const
+{
+  // rms deviation from the target speed plus the engine and brake effort
+  double cost_speed = 0.0;
+  unsigned int len_t_list = primitives_.getNumSteps();
+  for (unsigned int i = 0; i < len_t_list; ++i)
+    cost_speed += pow(primitives_.v(p, i) - config_.target_speed, 2);
+  double effort = getEngineLevel(p) * COF_ENGINE + getBrakeLevel(p) * config_.cof_break;
+  return config_.weight_speed * sqrt(cost_speed / len_t_list) + config_.weight_effort * effort;
+}
+
+int LatticePlanner::warmPlanStep(const Costmap2D& map, const double* state, double now,
+                                 const double* changed_bounds, double margin) const
+{
+  if (!warm_plan_.valid)
+    return -1;
+  double elapsed = now - warm_plan_.stamp;
+  if (elapsed >= config_.warm_start_replan_period)
+    return -1;
+  int num_steps = warm_plan_.x.size();
+  int k = (int)(elapsed / primitives_.getTimeStep() + 0.5);
+  // at least half of the horizon has to be left ahead, and the steering offset used below
+  if (k > num_steps / 2 || k + STEERING_STEP >= num_steps)
+    return -1;
+  double x_expected = k == 0 ? warm_plan_.start_x : warm_plan_.x[k - 1];
+  double y_expected = k == 0 ? warm_plan_.start_y : warm_plan_.y[k - 1];
+  if (hypot(state[0] - x_expected, state[1] - y_expected) > config_.warm_start_max_deviation)
+    return -1;
+
+  // only a remainder that reaches into the area updated since the last tick is checked again
+  bool touched = false;
+  for (int i = k; i < num_steps && !touched; ++i)
+  {
+    touched = warm_plan_.x[i] >= changed_bounds[0] - margin && warm_plan_.x[i] <= changed_bounds[2] + margin
+        && warm_plan_.y[i] >= changed_bounds[1] - margin && warm_plan_.y[i] <= changed_bounds[3] + margin;
+  }
+  if (!touched)
+    return k;
+  for (int i = std::max(k, 1); i < num_steps; ++i)
+  {
+    unsigned char cost = 0;
+    unsigned int x_map, y_map;
+    if (footprint_checker_.isConfigured())
+      cost = footprint_checker_.sweptCost(map, warm_plan_.x[i - 1], warm_plan_.y[i - 1], warm_plan_.theta[i - 1],
+                                          warm_plan_.x[i], warm_plan_.y[i], warm_plan_.theta[i]);
+    else if (map.worldToMap(warm_plan_.x[i], warm_plan_.y[i], x_map, y_map))
+      cost = map.getCost(x_map, y_map);
+    if (cost == LETHAL_OBSTACLE)
+      return -1;
+  }
+  return k;
+}
+
+void LatticePlanner::storeWarmPlan(unsigned int p, int fast, const double* state, double now, double goal_x,
+                                   double goal_y)
+{
+  unsigned int num_steps = primitives_.getNumSteps();
+  warm_plan_.valid = true;
+  warm_plan_.stamp = now;
+  warm_plan_.start_x = state[0];
+  warm_plan_.start_y = state[1];
+  warm_plan_.primitive = p;
+  warm_plan_.fast = fast;
+  warm_plan_.goal_x = goal_x;
+  warm_plan_.goal_y = goal_y;
+  warm_plan_.x.resize(num_steps);
+  warm_plan_.y.resize(num_steps);
+  warm_plan_.theta.resize(num_steps);
+  warm_plan_.u.resize(num_steps);
+  for (unsigned int i = 0; i < num_steps; ++i)
+  {
+    warm_plan_.x[i] = primitives_.x(p, i);
+    warm_plan_.y[i] = primitives_.y(p, i);
+    warm_plan_.theta[i] = primitives_.theta(p, i);
+    warm_plan_.u[i] = primitives_.u(p, i);
+  }
+}
+
+int LatticePlanner::countFree(const Costmap2D& map, const CellCounters* counters, int index, bool column)
+{
+  if (counters && counters->getSizeInCellsX() == map.getSizeInCellsX()
+      && counters->getSizeInCellsY() == map.getSizeInCellsY())
+    return column ? counters->getFreeInColumn(index) : counters->getFreeInRow(index);
+
+  int num_free = 0;
+  const unsigned char* costs = map.getCharMap();
+  int size_x = map.getSizeInCellsX(), size_y = map.getSizeInCellsY();
+  if (column)
+  {
+    for (int my = 0; my < size_y; ++my)
+      num_free += costs[my * size_x + index] == FREE_SPACE;
+  }
+  else
+  {
+    for (int mx = 0; mx < size_x; ++mx)
+      num_free += costs[index * size_x + mx] == FREE_SPACE;
+  }
+  return num_free;
+}
+
+int LatticePlanner::switchMap(const Costmap2D& map, double theta, const CellCounters* counters)
+{
+  double map_height1 = 16.0;
+  double carpose_theta = theta;
+  int switch_map = 0;
+  int flag_ahead_rear = 0;  // 1: x,ahead 2:x,rear 3:y,ahead 4:y,rear
+  int num_free_1 = 0, num_free_2 = 0, num_threshold = 10;
+
+  // limit the theta into [-3.14 3.14)
+  while (carpose_theta < -3.14)
+    carpose_theta = carpose_theta + 6.28;
+  while (carpose_theta >= 3.14)
+    carpose_theta = carpose_theta - 6.28;
+
+  // check the map direction by car's orientation
+  if (carpose_theta >= -0.785 && carpose_theta <= 0.785)
+    flag_ahead_rear = 1;
+  else if ((carpose_theta <= -2.355) || (carpose_theta >= 2.355))
+    flag_ahead_rear = 2;
+  else if ((carpose_theta <= 2.355) && (carpose_theta >= 0.785))
+    flag_ahead_rear = 3;
+  else
+    flag_ahead_rear = 4;
+
+  int size_x = map.getSizeInCellsX(), size_y = map.getSizeInCellsY();
+  if (map.getSizeInMetersX() > map_height1)
+  {
+    // map size pattern1, check two columns ahead of or behind the car
+    int x1 = flag_ahead_rear == 1 ? size_x * 5 / 6 : size_x * 1 / 6;
+    int x2 = flag_ahead_rear == 1 ? x1 + 1 : x1 - 1;
+    num_free_1 = countFree(map, counters, x1, true);
+    num_free_2 = countFree(map, counters, x2, true);
+  }
+  else
+  {
+    // map size pattern2, check two rows ahead of or behind the car
+    int y1 = flag_ahead_rear == 3 ? size_y * 5 / 6 : size_y * 1 / 6;
+    int y2 = flag_ahead_rear == 3 ? y1 + 1 : y1 - 1;
+    num_free_1 = countFree(map, counters, y1, false);
+    num_free_2 = countFree(map, counters, y2, false);
+  }
+  if (num_free_1 > num_threshold && num_free_2 > num_threshold)
+    switch_map = 1;
+  ROS_DEBUG("if it is rear or head: #######%d", flag_ahead_rear);
+  ROS_DEBUG("how many free grids for ahead 5/6:###### %d", num_free_1);
+  ROS_DEBUG("how many free grids for rear 1/6-1:###### %d", num_free_2);
+  return switch_map;
+}
+
+}  // namespace costmap_2d
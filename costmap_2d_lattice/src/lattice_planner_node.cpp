@@ -4,12 +4,18 @@
 
 #include <ros/ros.h>
 #include <costmap_2d/costmap_2d_ros.h>
+#include <costmap_2d/costmap_snapshot.h>
+#include <costmap_2d/lattice_planner.h>
+#include <costmap_2d/latency_histogram.h>
+#include <costmap_2d/planner_log.h>
+#include <costmap_2d/trajectory_visualizer.h>
 #include <tf2_ros/transform_listener.h>
 #include "dynamo_msgs/TeensyRead.h"
 #include "auto_navi/motorMsg.h"
 #include "dynamo_msgs/SteeringStepper.h"
 #include "std_msgs/Int8.h"
-#include <visualization_msgs/Marker.h>
+#include "std_msgs/Float64.h"
+#include "diagnostic_msgs/DiagnosticArray.h"
 #include <algorithm>
 #include <vector>
 #include <map>
@@ -20,43 +26,48 @@
 #include <cstdio>
 
 using namespace std;
-double theta_car,x_car,y_car,speed_car;
-double steering_current;
 double s_current[4];//0:x,1:y,2:theta,3:v
 
 const double PI = 3.141592653589793238463;
 const double Ts = 0.1,T_final=2.5;
-const double L=1.516,max_deg_speed=20,max_rad_speed=5*PI/180,cof_engine=0.27;//cof_engine=0.27;
-const double speed_switch=4.0,speed_toofast=5.0;
-const double A_front=0.8575,Cd=1.0,rho_air=1.15,m_car=130,m_all=200;
 
-bool flag_slide=false;
-double u_angle_deg_use[13]={-15.0,-12.5,-10.0,-7.5,-5.0,-2.5,0.0,2.5,5.0,7.5,10.0,12.5,15.0};
-double u_angle_rad_use[13]={-0.261799,-0.218166,-0.17453,-0.130899,-0.087266,-0.043633,0.0,0.043633,0.087266,0.130899,0.17453,0.218166,0.261799};
-double u_engine_use[3]={0,1,2};
-double u_break_use[4]={0,5,10,15};
-int traj_history_id=10;
+//rollout, scoring, selection and the map switch, configured from the parameters in main()
+costmap_2d::LatticePlanner planner;
+//every tick is recorded to record_file for lattice_replay if it is set
+costmap_2d::PlannerLogWriter planner_log;
+//publishes the primitives from its own thread, created in main()
+costmap_2d::TrajectoryVisualizer* trajectory_visualizer=NULL;
+//time spent in the stages of every tick, published as diagnostics once a second
+enum LatencyStage{ROLLOUT,SCORING,SELECTION,SWITCH_MAP,PUBLISH,TICK,NUM_STAGES};
+const char* const latency_stage_names[NUM_STAGES]={"rollout","scoring","selection","switch_map","publish","tick"};
+costmap_2d::LatencyHistogram stage_latency[NUM_STAGES];
+//replans that ran into plan_deadline since the last diagnostics
+unsigned int deadline_cuts=0;
+//plan on the snapshots published after every costmap update instead of locking the costmap for the tick
+bool use_costmap_snapshots=true;
+unsigned long snapshot_epoch=0;
+//copied from the costmap only when it changes, so a tick does not copy the footprint
+vector<geometry_msgs::Point> footprint;
+unsigned long footprint_version=0;
+//kept from tick to tick, so the record and the longitudinal command reuse their buffers
+costmap_2d::PlannerLogRecord record;
+std_msgs::Float32MultiArray longitudinalmsg;
 
-const char* file="/home/dlsh/Ecocar_offline_path_optimization/result_analysis/mue=0.9/traj_opt.csv";
-vector<float> road_x,road_y;
-const double dis_find_global=10.0;//[m]
-double drive_dist=0.0;
-
-ros::Publisher pub_marker;
 ros::Publisher motoPub;
 ros::Publisher steerPub;
 ros::Publisher mapSwitch;
-void fill_steering_input_array(double* array,double len_t_list,double steering_goal);
-double** ode_model_predict(double* s0,double* t_list,int len_t_list,double* u_angle_list, double* u_engin_list,double* u_break_list);
-void traj_vis(double** s_15l,double** s_15r,double** s_12_5l,double** s_12_5r, double** s_10l,double** s_10r,double** s_7_5l,double** s_7_5r,double** s_5l,double** s_5r,double** s_2_5l,double** s_2_5r,double** s_0, double** s_min,int len_t_list, int index_global_goal);
-void delete_s_array(double** s_array,int len_t_list);
+ros::Publisher latencyPub;
+ros::Publisher longitudinalPub;
+ros::Publisher diagnosticsPub;
 void odomCallback(const std_msgs::Float32MultiArray::ConstPtr &msg_odom);
 void teensyCallback(const dynamo_msgs::TeensyReadPtr &msg);
-//double score_traj(costmap_2d::Costmap2D* map,double** s_array,int len_t_list);
-double score_traj(costmap_2d::Costmap2DROS& map,double** s_array,int len_t_list, int& index_global_goal);
-double score_traj_only_global(costmap_2d::Costmap2DROS& costmap_ros,double** s_array,int len_t_list, int& index_global_goal);
-void lattice_planner(costmap_2d::Costmap2DROS& costmap_ros);
-int switch_map(costmap_2d::Costmap2DROS& costmap_ros);
+void plan_on_map(const costmap_2d::Costmap2D& map,const double* state,double now,const double* changed_bounds,
+                 double margin,const costmap_2d::CellCounters* counters,const costmap_2d::CostmapPyramid* pyramid,
+                 const vector<geometry_msgs::Point>& footprint,costmap_2d::LatticePlan& plan);
+void lattice_planner(costmap_2d::Costmap2DROS& costmap_ros, const ros::Time& map_stamp);
+void publish_commands(const costmap_2d::LatticePlan& plan,const ros::Time& map_stamp);
+void publish_latency(const ros::WallTimerEvent& event);
+vector<double> load_steering_targets(ros::NodeHandle& private_nh);
 
 
 
@@ -69,624 +80,336 @@ void odomCallback(const std_msgs::Float32MultiArray::ConstPtr &msg_odom) {
     s_current[0] = msg_odom->data[0];
     s_current[1] = msg_odom->data[1];
     s_current[2] = msg_odom->data[3];
-    drive_dist = msg_odom->data[6];
-}
-void delete_s_array(double** s_array,int len_t_list){
-    for(int i = 0; i < len_t_list; i++)
-        delete[] s_array[i];//删除s_array每一行的子数组的指针，每个指针都指向容量为5的子数组
-    delete[] s_array;//删除大指针，指向第一个子数组，同时也是指向整个二维数组
-    s_array= nullptr;
-}
-void fill_steering_input_array(double* array,double len_t_list,double steering_goal){
-    //int len=abs(steering_goal-steering_current)/(max_deg_speed*Ts);
-    double sign_goal;
-    if((steering_goal-steering_current)>0)
-        sign_goal=1.0;
-    else if((steering_goal-steering_current)<0)
-        sign_goal=-1.0;
-    else
-        sign_goal=0.0;
-    array[0]=steering_current;
-    for(int i=1;i<len_t_list;++i){
-        if(abs(array[i-1])>=abs(steering_goal))
-            array[i]=steering_goal;
-        else {
-            array[i] = steering_current + sign_goal*i * max_rad_speed * Ts;
-        }
-    }
-}
-double** ode_model_predict(double* s0,double* t_list,int len_t_list,double* u_angle_list, double* u_engin_list,double* u_break_list){
-    double x=s0[0], y=s0[1],theta=s0[2],v=s0[3];
-    double u_angle=u_angle_list[0],u_engin=u_engin_list[0],u_break=u_break_list[0];
-    double v_last=v, theta_last=theta;
-    double a_drag=0.0;
-    //Apply for dynamic memory
-    double **s_list = new double*[len_t_list];//先new一个大指针，包含了所有数量的子数组，子数组具体多大不管，关注的是有多少行
-    for(int i = 0; i < len_t_list; i++)
-        s_list[i] = new double[5];//遍历每个小指针，new固定数量的子数组给这个小指针
-
-    //ode forward simulation
-    for(int i=0;i<len_t_list;++i){
-        u_angle=u_angle_list[i];
-        u_engin=u_engin_list[i];
-        u_break=u_break_list[i];
-        v_last=v;
-        a_drag=-0.5*A_front*Cd*rho_air*pow(v_last,2)/m_car;
-        theta_last=theta;
-        theta=theta_last+Ts*(v_last/L)*tan(u_angle);
-        v=v_last+Ts*(u_engin+u_break+a_drag);
-        x=x+Ts*v_last*cos(theta_last);
-        y=y+Ts*v_last*sin(theta_last);
-        s_list[i][0]=x;
-        s_list[i][1]=y;
-        s_list[i][2]=theta;
-        s_list[i][3]=v;
-        s_list[i][4]=u_angle;
-    }
-    return s_list;
 }
 void teensyCallback(const dynamo_msgs::TeensyReadPtr &msg) {
     s_current[3] = msg->speed_wheel;
 }
 
-void traj_vis(double** s_15l,double** s_15r,double** s_12_5l,double** s_12_5r, double** s_10l,double** s_10r,double** s_7_5l,double** s_7_5r,double** s_5l,double** s_5r,double** s_2_5l,double** s_2_5r,double** s_0, double** s_min,int len_t_list, int index_global_goal) {
-    visualization_msgs::Marker traj, traj_min, traj_used, traj_input,traj_global;
-    ros::Duration one_sec(.4);
-
-    traj.header.frame_id = traj_min.header.frame_id = traj_used.header.frame_id =
-    traj_input.header.frame_id = traj_global.header.frame_id =
-            "world"; //"base_link";
-    traj.header.stamp = traj_min.header.stamp = traj_used.header.stamp =
-    traj_input.header.stamp = traj_global.header.stamp = ros::Time::now();
-
-    // Set the namespace and id for this marker.  This serves to create a unique
-    // ID
-    // Any marker sent with the same namespace and id will overwrite the old one
-    traj.ns = "points";
-    traj_min.ns = "points_corrected";
-    traj_used.ns = "points_corrected_global";
-    traj_input.ns = "points_line";
-    traj_global.ns = "points_line_debug";
-
-    traj.action = traj_min.action = traj_used.action = traj_input.action =
-    traj_global.action = visualization_msgs::Marker::ADD;
-
-    traj.pose.orientation.w = traj_min.pose.orientation.w =
-    traj_used.pose.orientation.w = traj_input.pose.orientation.w =
-    traj_global.pose.orientation.w = 1.0;
-
-    traj.id = 0;
-    traj_min.id = 1;
-    //traj_used.id = 2;
-    traj_input.id = traj_history_id+500;
-    traj_global.id = 4;
-    traj_used.id=traj_history_id;
-    ++traj_history_id;
-
-    //set the lifetime
-    traj_used.lifetime=ros::Duration(0.0);
-    traj_input.lifetime=ros::Duration(0.0);
-    // Set the marker type.
-
-    traj.type = visualization_msgs::Marker::POINTS;
-    traj_min.type = visualization_msgs::Marker::POINTS;
-    traj_used.type = visualization_msgs::Marker::POINTS;
-    traj_input.type = visualization_msgs::Marker::POINTS;
-    traj_global.type = visualization_msgs::Marker::POINTS;
-
-    // POINTS markers use x and y scale for width/height respectively
-    traj.scale.x = 0.2;
-    traj.scale.y = 0.2;
-
-    traj_min.scale.x = 0.2;
-    traj_min.scale.y = 0.2;
-
-    traj_used.scale.x = 0.2;
-    traj_used.scale.y = 0.2;
-
-    traj_input.scale.x = 0.2;
-    traj_input.scale.y = 0.2;
-
-    traj_global.scale.x = 0.5;
-    traj_global.scale.y = 0.5;
-
-    traj.color.b = 1.0; // blue
-    traj.color.a = 1.0;
-
-    traj_min.color.g = 1.0f; // green
-    traj_min.color.a = 1.0;
-
-    traj_used.color.r = 1.0f; // red
-    traj_used.color.a = 1.0;
-
-    traj_input.color.r = 0.5; //brown
-    traj_input.color.a = 1.0;
-
-    traj_global.color.g = 0.5; // red
-    traj_global.color.a = 1.0;
-
-    for (int i = 0; i < len_t_list; i++) {
-        geometry_msgs::Point p_15l, p_15r, p_12_5l, p_12_5r,p_10l, p_10r, p_7_5l, p_7_5r, p_5l, p_5r,p_2_5l, p_2_5r, p_0;
-        p_15l.x = s_15l[i][0];
-        p_15l.y = s_15l[i][1];
-        p_15l.z = 0;
-        p_15r.x = s_15r[i][0];
-        p_15r.y = s_15r[i][1];
-        p_15r.z = 0;
-        p_12_5l.x = s_12_5l[i][0];
-        p_12_5l.y = s_12_5l[i][1];
-        p_12_5l.z = 0;
-        p_12_5r.x = s_12_5r[i][0];
-        p_12_5r.y = s_12_5r[i][1];
-        p_12_5r.z = 0;
-        p_10l.x = s_10l[i][0];
-        p_10l.y = s_10l[i][1];
-        p_10l.z = 0;
-        p_10r.x = s_10r[i][0];
-        p_10r.y = s_10r[i][1];
-        p_10r.z = 0;
-        p_7_5l.x = s_7_5l[i][0];
-        p_7_5l.y = s_7_5l[i][1];
-        p_7_5l.z = 0;
-        p_7_5r.x = s_7_5r[i][0];
-        p_7_5r.y = s_7_5r[i][1];
-        p_7_5r.z = 0;
-        p_5l.x = s_5l[i][0];
-        p_5l.y = s_5l[i][1];
-        p_5l.z = 0;
-        p_5r.x = s_5r[i][0];
-        p_5r.y = s_5r[i][1];
-        p_5r.z = 0;
-        p_2_5l.x = s_2_5l[i][0];
-        p_2_5l.y = s_2_5l[i][1];
-        p_2_5l.z = 0;
-        p_2_5r.x = s_2_5r[i][0];
-        p_2_5r.y = s_2_5r[i][1];
-        p_2_5r.z = 0;
-        p_0.x = s_0[i][0];
-        p_0.y = s_0[i][1];
-        p_0.z = 0;
-        traj.points.push_back(p_15l);
-        traj.points.push_back(p_15r);
-        traj.points.push_back(p_12_5l);
-        traj.points.push_back(p_12_5r);
-        traj.points.push_back(p_10l);
-        traj.points.push_back(p_10r);
-        traj.points.push_back(p_7_5l);
-        traj.points.push_back(p_7_5r);
-        traj.points.push_back(p_5l);
-        traj.points.push_back(p_5r);
-        traj.points.push_back(p_2_5l);
-        traj.points.push_back(p_2_5r);
-        traj.points.push_back(p_0);
-    }
-    for(int i=0;i<len_t_list;++i){
-        geometry_msgs::Point p_min;
-        p_min.x=s_min[i][0];
-        p_min.y=s_min[i][1];
-        p_min.z=0;
-        traj_min.points.push_back(p_min);
-    }
-    for(int i=0;i<len_t_list/3;++i){
-        geometry_msgs::Point p_used;
-        p_used.x=s_min[i][0];
-        p_used.y=s_min[i][1];
-        p_used.z=0;
-        traj_used.points.push_back(p_used);
-    }
-
-
-    geometry_msgs::Point p_input;
-    p_input.x=s_min[4][0];
-    p_input.y=s_min[4][1];
-    p_input.z=0;
-    traj_input.points.push_back(p_input);
-
-    geometry_msgs::Point p_global;
-    p_global.x=road_x[index_global_goal];
-    p_global.y=road_y[index_global_goal];
-    p_global.z=0;
-    traj_global.points.push_back(p_global);
-
-    pub_marker.publish(traj);
-    pub_marker.publish(traj_min);
-    pub_marker.publish(traj_used);
-    pub_marker.publish(traj_input);
-    pub_marker.publish(traj_global);
+void plan_on_map(const costmap_2d::Costmap2D& map,const double* state,double now,const double* changed_bounds,
+                 double margin,const costmap_2d::CellCounters* counters,const costmap_2d::CostmapPyramid* pyramid,
+                 const vector<geometry_msgs::Point>& footprint,costmap_2d::LatticePlan& plan){
+    //the caller keeps the map from changing until this returns
+    planner.setFootprint(footprint,map.getResolution());
+    planner.plan(map,state,now,changed_bounds,margin,plan,counters,pyramid);
 }
-void lattice_planner(costmap_2d::Costmap2DROS& costmap_ros){
-    auto_navi::motorMsg max_motor;
-    dynamo_msgs::SteeringStepper steeringmsg;
-    std_msgs::Int8 mapSwichmsg;
-
+void lattice_planner(costmap_2d::Costmap2DROS& costmap_ros, const ros::Time& map_stamp){
+    ros::SteadyTime tick_start=ros::SteadyTime::now();
     double s_current_temp[4];
     for (int i=0;i<4;++i){
         s_current_temp[i]=s_current[i];
     }
-    //calculate input
-    //time input
-    int len_t_list=T_final/Ts+1;
-    double t_list[len_t_list];
-    double u_angle_list_15l[len_t_list],u_angle_list_15r[len_t_list],u_angle_list_12_5l[len_t_list],u_angle_list_12_5r[len_t_list],u_angle_list_10l[len_t_list],u_angle_list_10r[len_t_list],u_angle_list_7_5l[len_t_list],u_angle_list_7_5r[len_t_list],u_angle_list_5l[len_t_list],u_angle_list_5r[len_t_list],u_angle_list_2_5l[len_t_list],u_angle_list_2_5r[len_t_list],u_angle_list_0[len_t_list];
-    double u_engine_list[len_t_list];
-    double u_break_list[len_t_list];
-    //steering input
-    fill_steering_input_array(u_angle_list_15l,len_t_list,0.261799);
-    fill_steering_input_array(u_angle_list_15r,len_t_list,-0.261799);
-    fill_steering_input_array(u_angle_list_12_5l,len_t_list,0.218166);
-    fill_steering_input_array(u_angle_list_12_5r,len_t_list,-0.218166);
-    fill_steering_input_array(u_angle_list_10l,len_t_list,0.17453);
-    fill_steering_input_array(u_angle_list_10r,len_t_list,-0.17453);
-    fill_steering_input_array(u_angle_list_7_5l,len_t_list,0.130899);
-    fill_steering_input_array(u_angle_list_7_5r,len_t_list,-0.130899);
-    fill_steering_input_array(u_angle_list_5l,len_t_list,0.087266);
-    fill_steering_input_array(u_angle_list_5r,len_t_list,-0.087266);
-    fill_steering_input_array(u_angle_list_2_5l,len_t_list,0.043633);
-    fill_steering_input_array(u_angle_list_2_5r,len_t_list,-0.043633);
-    fill_steering_input_array(u_angle_list_0,len_t_list,0);
-
-
-    bool gear_change=s_current_temp[3]>speed_switch;
-    bool engin_close=s_current_temp[3]>speed_toofast;
-    for(int i=0;i<len_t_list;++i){
-        //time input
-        t_list[i]=Ts*i;
-        //break input
-        u_break_list[i]=0.0;
-        //engin input
-        if(gear_change&&!engin_close&&!flag_slide){
-            u_engine_list[i]=1*cof_engine;}
-        else if(engin_close) {
-            u_engine_list[i] = 0.0;
-            flag_slide=true;
-        }
-        else{
-            u_engine_list[i]=2*cof_engine;
-            flag_slide=false;
-        }
-    }
-    //generate the traj using the model simulation
-    //s_list[0]:x
-    //      [1]:y
-    //      [2]:theta
-    //      [3]:v
-    //      [4]:u_angle(not the state but need to be recorded)
-    double** s_15l=ode_model_predict(s_current_temp,t_list,len_t_list,u_angle_list_15l,u_engine_list,u_break_list);
-    double** s_15r=ode_model_predict(s_current_temp,t_list,len_t_list,u_angle_list_15r,u_engine_list,u_break_list);
-    double** s_12_5l=ode_model_predict(s_current_temp,t_list,len_t_list,u_angle_list_12_5l,u_engine_list,u_break_list);
-    double** s_12_5r=ode_model_predict(s_current_temp,t_list,len_t_list,u_angle_list_12_5r,u_engine_list,u_break_list);
-    double** s_10l=ode_model_predict(s_current_temp,t_list,len_t_list,u_angle_list_10l,u_engine_list,u_break_list);
-    double** s_10r=ode_model_predict(s_current_temp,t_list,len_t_list,u_angle_list_10r,u_engine_list,u_break_list);
-    double** s_7_5l=ode_model_predict(s_current_temp,t_list,len_t_list,u_angle_list_7_5l,u_engine_list,u_break_list);
-    double** s_7_5r=ode_model_predict(s_current_temp,t_list,len_t_list,u_angle_list_7_5r,u_engine_list,u_break_list);
-    double** s_5l=ode_model_predict(s_current_temp,t_list,len_t_list,u_angle_list_5l,u_engine_list,u_break_list);
-    double** s_5r=ode_model_predict(s_current_temp,t_list,len_t_list,u_angle_list_5r,u_engine_list,u_break_list);
-    double** s_2_5l=ode_model_predict(s_current_temp,t_list,len_t_list,u_angle_list_2_5l,u_engine_list,u_break_list);
-    double** s_2_5r=ode_model_predict(s_current_temp,t_list,len_t_list,u_angle_list_2_5r,u_engine_list,u_break_list);
-    double** s_0=ode_model_predict(s_current_temp,t_list,len_t_list,u_angle_list_0,u_engine_list,u_break_list);
-    //score the traj
-    int index_global_goal=(drive_dist+dis_find_global)/1.0;
     //we have to wait until the map is updated
     ros::Rate r(100.0);
     while (ros::ok() && !costmap_ros.isInitialized())
         r.sleep();
-    double score_15l=score_traj(costmap_ros,s_15l,len_t_list,index_global_goal);
-    double score_15r=score_traj(costmap_ros,s_15r,len_t_list,index_global_goal);
-    double score_12_5l=score_traj(costmap_ros,s_12_5l,len_t_list,index_global_goal);
-    double score_12_5r=score_traj(costmap_ros,s_12_5r,len_t_list,index_global_goal);
-    double score_10l=score_traj(costmap_ros,s_10l,len_t_list,index_global_goal);
-    double score_10r=score_traj(costmap_ros,s_10r,len_t_list,index_global_goal);
-    double score_7_5l=score_traj(costmap_ros,s_7_5l,len_t_list,index_global_goal);
-    double score_7_5r=score_traj(costmap_ros,s_7_5r,len_t_list,index_global_goal);
-    double score_5l=score_traj(costmap_ros,s_5l,len_t_list,index_global_goal);
-    double score_5r=score_traj(costmap_ros,s_5r,len_t_list,index_global_goal);
-    double score_2_5l=score_traj(costmap_ros,s_2_5l,len_t_list,index_global_goal);
-    double score_2_5r=score_traj(costmap_ros,s_2_5r,len_t_list,index_global_goal);
-    double score_0=score_traj(costmap_ros,s_0,len_t_list,index_global_goal);
-
-    multimap<double,double**> score_s_list;
-    score_s_list.insert(make_pair(score_15l,s_15l));
-    score_s_list.insert(make_pair(score_15r,s_15r));
-    score_s_list.insert(make_pair(score_12_5l,s_12_5l));
-    score_s_list.insert(make_pair(score_12_5r,s_12_5r));
-    score_s_list.insert(make_pair(score_10l,s_10l));
-    score_s_list.insert(make_pair(score_10r,s_10r));
-    score_s_list.insert(make_pair(score_7_5l,s_7_5l));
-    score_s_list.insert(make_pair(score_7_5r,s_7_5r));
-    score_s_list.insert(make_pair(score_5l,s_5l));
-    score_s_list.insert(make_pair(score_5r,s_5r));
-    score_s_list.insert(make_pair(score_2_5l,s_2_5l));
-    score_s_list.insert(make_pair(score_2_5r,s_2_5r));
-    score_s_list.insert(make_pair(score_0,s_0));
+    costmap_ros.updateRobotFootprint(footprint,footprint_version);
+    double margin=costmap_ros.getLayeredCostmap()->getCircumscribedRadius();
+    double now=ros::Time::now().toSec();
+    if(planner_log.isOpen()){
+        record.stamp=now;
+        std::copy(s_current_temp,s_current_temp+4,record.state);
+        record.steering=planner.getSteering();
+        record.margin=margin;
+        record.footprint=footprint;
+    }
 
-    if(score_s_list.count(DBL_MAX)>6) {
-        max_motor.fast = 0;//fast:0 ->>>>use the pair of slow speed fast:1 ->>>>use the pair of fast speed
+    //the last plan is only followed on if the area updated since the last tick is known
+    double changed_bounds[4];
+    bool changes_known;
+    costmap_2d::LatticePlan plan;
+    //a snapshot is read without the costmap's mutex, so the tick neither waits for a map update nor holds one up
+    boost::shared_ptr<const costmap_2d::CostmapSnapshot> snapshot;
+    if(use_costmap_snapshots)
+        snapshot=costmap_ros.getLayeredCostmap()->getSnapshot();
+    if(snapshot){
+        changes_known=snapshot->getChangedBoundsSince(snapshot_epoch,changed_bounds[0],changed_bounds[1],
+                                                      changed_bounds[2],changed_bounds[3]);
+        snapshot_epoch=snapshot->getEpoch();
+        plan_on_map(snapshot->getCostmap(),s_current_temp,now,changes_known?changed_bounds:NULL,margin,
+                    snapshot->getCellCounters(),snapshot->getPyramid(),footprint,plan);
     }
     else{
-        max_motor.fast= 1;
+        //otherwise hold one consistent view of the costmap for the plan only, no copy of the map is made
+        costmap_2d::Costmap2DReadView view(costmap_ros);
+        costmap_2d::LayeredCostmap* layered_costmap=costmap_ros.getLayeredCostmap();
+        changes_known=layered_costmap->takeChangedBounds(changed_bounds[0],changed_bounds[1],
+                                                         changed_bounds[2],changed_bounds[3]);
+        plan_on_map(*view,s_current_temp,now,changes_known?changed_bounds:NULL,margin,
+                    layered_costmap->getCellCounters(),layered_costmap->getPyramid(),footprint,plan);
+        //the cells of the record are copied before the view is released, the record is written after publishing
+        if(planner_log.isOpen())
+            record.setMap(*view);
     }
-
-    double score_min=score_s_list.begin()->first;
-    double** traj_select;
-    typedef std::multimap<double,double**>::iterator multimap_iterator;
-
-    if(score_min==0.0 && score_s_list.count(score_min)<13) {
-        ROS_INFO("more than 1 traj's score is 0");
-        pair<multimap_iterator,multimap_iterator> it =score_s_list.equal_range(score_min);
-        while (it.first!=it.second)
-        {
-            it.first=score_s_list.erase(it.first);
-        }
-        traj_select=score_s_list.begin()->second;
+    if(planner_log.isOpen()){
+        record.changes_known=changes_known;
+        std::copy(changed_bounds,changed_bounds+4,record.changed_bounds);
     }
-    else if(score_s_list.count(score_min)>=13){
-        if(score_min==DBL_MAX||score_min==0.0){
-            ROS_INFO("all traj is score DBL_MAX, the score will be recomputed only based on the global goal");
-            score_15l=score_traj_only_global(costmap_ros,s_15l,len_t_list,index_global_goal);
-            score_15r=score_traj_only_global(costmap_ros,s_15r,len_t_list,index_global_goal);
-            score_12_5l=score_traj_only_global(costmap_ros,s_12_5l,len_t_list,index_global_goal);
-            score_12_5r=score_traj(costmap_ros,s_12_5r,len_t_list,index_global_goal);
-            score_10l=score_traj_only_global(costmap_ros,s_10l,len_t_list,index_global_goal);
-            score_10r=score_traj_only_global(costmap_ros,s_10r,len_t_list,index_global_goal);
-            score_7_5l=score_traj_only_global(costmap_ros,s_7_5l,len_t_list,index_global_goal);
-            score_7_5r=score_traj_only_global(costmap_ros,s_7_5r,len_t_list,index_global_goal);
-            score_5l=score_traj_only_global(costmap_ros,s_5l,len_t_list,index_global_goal);
-            score_5r=score_traj_only_global(costmap_ros,s_5r,len_t_list,index_global_goal);
-            score_2_5l=score_traj_only_global(costmap_ros,s_2_5l,len_t_list,index_global_goal);
-            score_2_5r=score_traj_only_global(costmap_ros,s_2_5r,len_t_list,index_global_goal);
-            score_0=score_traj_only_global(costmap_ros,s_0,len_t_list,index_global_goal);
-
-            multimap<double,double**> score_s_list_global;
-            score_s_list_global.insert(make_pair(score_15l,s_15l));
-            score_s_list_global.insert(make_pair(score_15r,s_15r));
-            score_s_list_global.insert(make_pair(score_12_5l,s_12_5l));
-            score_s_list_global.insert(make_pair(score_12_5r,s_12_5r));
-            score_s_list_global.insert(make_pair(score_10l,s_10l));
-            score_s_list_global.insert(make_pair(score_10r,s_10r));
-            score_s_list_global.insert(make_pair(score_7_5l,s_7_5l));
-            score_s_list_global.insert(make_pair(score_7_5r,s_7_5r));
-            score_s_list_global.insert(make_pair(score_5l,s_5l));
-            score_s_list_global.insert(make_pair(score_5r,s_5r));
-            score_s_list_global.insert(make_pair(score_2_5l,s_2_5l));
-            score_s_list_global.insert(make_pair(score_2_5r,s_2_5r));
-            score_s_list_global.insert(make_pair(score_0,s_0));
-            traj_select=score_s_list_global.begin()->second;
-            max_motor.fast = 0;
-        }
-        else{
-            ROS_INFO("all traj is score 0,skip this time,use 0 steering as selected traj");
-            traj_select=s_0;
+    ROS_DEBUG("lattice: rollout %.2f ms, scoring %.2f ms, selection %.2f ms, map switch %.2f ms",
+              plan.timings.rollout*1e3,plan.timings.scoring*1e3,plan.timings.selection*1e3,plan.timings.switch_map*1e3);
+
+    //the commands go out first, nothing else of the tick delays them
+    ros::SteadyTime publish_start=ros::SteadyTime::now();
+    publish_commands(plan,map_stamp);
+    if(!plan.warm_started){
+        const costmap_2d::MotionPrimitiveSet& primitives=planner.getPrimitives();
+        for(unsigned int p=0;p<primitives.size();++p){
+            ROS_DEBUG("lattice: %.1f deg scored %f (expected %f, worst %f)%s",primitives.getSteeringTarget(p)*180/PI,
+                      planner.getScores()[p],planner.getExpectedScores()[p],planner.getWorstScores()[p],
+                      planner.isPruned(p)?" (lower bound, pruned)":"");
         }
-
+        trajectory_visualizer->push(primitives,plan.primitive,plan.goal_x,plan.goal_y);
     }
-    else{
-        ROS_INFO("Min traj found");
-        traj_select=score_s_list.begin()->second;
+    if(planner_log.isOpen()){
+        //a snapshot does not change while it is held, so its cells are only copied now
+        if(snapshot)
+            record.setMap(snapshot->getCostmap());
+        record.plan=plan;
+        planner_log.write(record);
     }
 
-    std::cout<<"15l:"<<score_15l<<"\n"<< "15r:"<<score_15r<<"\n" << "12.5l:"<<score_12_5l<<"\n" << "12.5r:"<<score_12_5r<<"\n"<<"10l:"<<score_10l<<"\n"<< "10r:"<<score_10r<<"\n" << "7.5l:"<<score_7_5l<<"\n" << "7.5r:"<<score_7_5r<<"\n"<< "5l:"<<score_5l<<"\n"<< "5r:"<<score_5r<<"\n"<< "2.5l:"<<score_2_5l<<"\n" << "2.5r:"<<score_2_5r<<"\n"<< "0:"<<score_0<<std::endl;
-
-    traj_vis(s_15l,s_15r,s_12_5l,s_12_5r,s_10l,s_10r,s_7_5l,s_7_5r,s_5l,s_5r,s_2_5l,s_2_5r,s_0,traj_select,len_t_list,index_global_goal);
-    //considering the computing time, the offset should be set
-    steering_current=traj_select[5][4];
-    ROS_INFO("STEERING INPUT:%f",steering_current);
-    steeringmsg.steering_angle = steering_current*180/PI;
+    ros::SteadyTime tick_end=ros::SteadyTime::now();
+    //a warm started tick does not score or select, it is counted with its rollout and map switch only
+    stage_latency[ROLLOUT].record(plan.timings.rollout);
+    if(plan.num_skipped>0){
+        ++deadline_cuts;
+        ROS_DEBUG("lattice: deadline after %u scored primitives, %u skipped",plan.num_scored,plan.num_skipped);
+    }
+    if(plan.escaped){
+        ROS_WARN_THROTTLE(1.0,"lattice: every trajectory is blocked, steering along a grid path of %u cells",
+                          (unsigned int)planner.getEscape().getPathX().size());
+    }
+    if(!plan.warm_started){
+        stage_latency[SCORING].record(plan.timings.scoring);
+        stage_latency[SELECTION].record(plan.timings.selection);
+    }
+    stage_latency[SWITCH_MAP].record(plan.timings.switch_map);
+    stage_latency[PUBLISH].record((tick_end-publish_start).toSec());
+    stage_latency[TICK].record((tick_end-tick_start).toSec());
+}
+void publish_commands(const costmap_2d::LatticePlan& plan,const ros::Time& map_stamp){
+    dynamo_msgs::SteeringStepper steeringmsg;
+    std_msgs::Int8 mapSwichmsg;
+    auto_navi::motorMsg max_motor;
+    ROS_DEBUG("STEERING INPUT:%f",plan.steering);
+    steeringmsg.steering_angle = plan.steering*180/PI;
     steeringmsg.steering_stepper_engaged = 1;
+    //fast:0 ->>>>use the pair of slow speed fast:1 ->>>>use the pair of fast speed
+    max_motor.fast=plan.fast;
 
 
-    mapSwichmsg.data=switch_map(costmap_ros);
+    mapSwichmsg.data=plan.switch_map;
     //mapSwichmsg.data=0;
     mapSwitch.publish(mapSwichmsg);
     motoPub.publish(max_motor);
     steerPub.publish(steeringmsg);
+    if(planner.getConfig().use_longitudinal_product){
+        //the engine and brake level of the selected primitive, as indices into the engine and brake levels
+        longitudinalmsg.data.resize(2);
+        longitudinalmsg.data[0]=planner.getEngineLevel(plan.primitive);
+        longitudinalmsg.data[1]=planner.getBrakeLevel(plan.primitive);
+        longitudinalPub.publish(longitudinalmsg);
+    }
 
-    delete_s_array(s_15l,len_t_list);
-    delete_s_array(s_15r,len_t_list);
-    delete_s_array(s_12_5l,len_t_list);
-    delete_s_array(s_12_5r,len_t_list);
-    delete_s_array(s_10l,len_t_list);
-    delete_s_array(s_10r,len_t_list);
-    delete_s_array(s_7_5l,len_t_list);
-    delete_s_array(s_7_5r,len_t_list);
-    delete_s_array(s_5l,len_t_list);
-    delete_s_array(s_5r,len_t_list);
-    delete_s_array(s_2_5l,len_t_list);
-    delete_s_array(s_2_5r,len_t_list);
-    delete_s_array(s_0,len_t_list);
-    traj_select= nullptr;
-
+    //from the start of the map update, no sensor data in the map is newer, to the steering command
+    std_msgs::Float64 latencymsg;
+    latencymsg.data=(ros::Time::now()-map_stamp).toSec();
+    latencyPub.publish(latencymsg);
+    ROS_DEBUG("lattice: map to steering latency %.3f s",latencymsg.data);
 }
-double score_traj(costmap_2d::Costmap2DROS& costmap_ros,double** s_array,int len_t_list, int& index_global_goal){
-    double score=0.0,cost_obstacle=0.0;
-    bool trans_succ=true;
-    unsigned int x_map=0,y_map=0;
-    double cost_global=0.0;
-    if (index_global_goal>road_x.size())
-        index_global_goal=road_x.size();
-    double x_global_goal=road_x[index_global_goal];
-    double y_global_goal=road_y[index_global_goal];
-    costmap_2d::Costmap2D map=*(costmap_ros.getCostmap());
-    //cout<<"initialized:"<<costmap_ros.getLayeredCostmap()->isInitialized()<<endl;
-    for(int i=0;i<len_t_list;++i){
-        trans_succ=map.worldToMap(s_array[i][0],s_array[i][1],x_map,y_map);
-        if(trans_succ) {
-            cost_obstacle=static_cast<double>(map.getCost(x_map, y_map));
-            //ROS_INFO("cost: %f",cost);
-            if (cost_obstacle==254.0){
-                score=DBL_MAX;
-                break;
-            }
-            score += cost_obstacle/100.0;
+
+void publish_latency(const ros::WallTimerEvent& event){
+    //one status with the percentiles of every stage over the last second, in ms
+    diagnostic_msgs::DiagnosticArray diagnosticsmsg;
+    diagnosticsmsg.header.stamp=ros::Time::now();
+    diagnosticsmsg.status.resize(1);
+    diagnostic_msgs::DiagnosticStatus& status=diagnosticsmsg.status[0];
+    status.name="lattice_planner: latency";
+    status.level=diagnostic_msgs::DiagnosticStatus::OK;
+    costmap_2d::LatencySnapshot snapshot;
+    for(int stage=0;stage<NUM_STAGES;++stage){
+        stage_latency[stage].take(snapshot);
+        char value[128];
+        snprintf(value,sizeof(value),"n %u p50 %.2f p90 %.2f p99 %.2f max %.2f",snapshot.count,
+                 snapshot.percentile(0.5)*1e3,snapshot.percentile(0.9)*1e3,snapshot.percentile(0.99)*1e3,snapshot.max*1e3);
+        diagnostic_msgs::KeyValue keyvalue;
+        keyvalue.key=latency_stage_names[stage];
+        keyvalue.value=value;
+        status.values.push_back(keyvalue);
+        if(stage==TICK){
+            snprintf(value,sizeof(value),"%u ticks, p99 %.2f ms, %u cut at the deadline",snapshot.count,
+                     snapshot.percentile(0.99)*1e3,deadline_cuts);
+            status.message=value;
         }
-        cost_global+=(pow(s_array[i][0]-x_global_goal,2)+pow(s_array[i][1]-y_global_goal,2));
-        //cost_global+=(pow(s_array[i][0]-x_global_goal,2)+pow(s_array[i][1]-y_global_goal,2));
-    }
-    ROS_INFO("cost_obstacle:#####  %f", score);
-    if(score!=DBL_MAX){
-        score+=sqrt(cost_global/len_t_list);
-        ROS_INFO("cost_global:#####  %f", sqrt(cost_global/len_t_list));
     }
-    return score;
+    //the plan stayed on time, but on a coarser set of primitives
+    if(deadline_cuts>0)
+        status.level=diagnostic_msgs::DiagnosticStatus::WARN;
+    deadline_cuts=0;
+    diagnosticsPub.publish(diagnosticsmsg);
 }
-double score_traj_only_global(costmap_2d::Costmap2DROS& costmap_ros,double** s_array,int len_t_list, int& index_global_goal){
-    double score=0.0;
-    double cost_global=0.0;
-    if (index_global_goal>road_x.size())
-        index_global_goal=road_x.size();
-    float x_global_goal=road_x[index_global_goal];
-    float y_global_goal=road_y[index_global_goal];
-    costmap_2d::Costmap2D map=*(costmap_ros.getCostmap());
-    for(int i=0;i<len_t_list;++i){
-        cost_global+=(pow(s_array[i][0]-x_global_goal,2)+pow(s_array[i][1]-y_global_goal,2));
-    }
-    score+=sqrt(cost_global/len_t_list);
-    ROS_INFO("cost_global:#####  %f", sqrt(cost_global/len_t_list));
-    return score;
-}
-
-int switch_map(costmap_2d::Costmap2DROS& costmap_ros){
-    double map_width1=22.0,map_height1=16.0,map_width2=16.0,map_height2=22.0;
-    double carpose_theta=s_current[2];
-    int switchMap=0;
-    int flag_ahead_rear=0;//1: x,ahead 2:x,rear 3:y,ahead 4:y,rear
-    int index_check_free_x1=0,index_check_free_x2=0;//for pattern1
-    int index_check_free_y1=0,index_check_free_y2=0;//for pattern2
-    int num_free_1=0,num_free_2=0,num_threshold=10;
-
-    //limit the theta into [-3.14 3.14)
-    while(carpose_theta<-3.14){
-        carpose_theta=carpose_theta+6.28;
-    }
-    while(carpose_theta>=3.14){
-        carpose_theta=carpose_theta-6.28;
-    }
-
-    //check the map direction by car's orientation
-    if(carpose_theta>=-0.785&&carpose_theta<=0.785){
-        flag_ahead_rear=1;
-    }
-    else if((carpose_theta<=-2.355)||(carpose_theta>=2.355)){
-        flag_ahead_rear=2;
-    }
-    else if((carpose_theta<=2.355)&&(carpose_theta>=0.785)){
-        flag_ahead_rear=3;
-    }
-    else{
-        flag_ahead_rear=4;
-    }
-
-
-    if(costmap_ros.getCostmap()->getSizeInMetersX()>map_height1){
-        //map size pattern1
-        //check the ahead of the map
-        if(flag_ahead_rear==1) {
-            index_check_free_x1 = costmap_ros.getCostmap()->getSizeInCellsX() * 5 / 6;
-            for (int i = 0; i < costmap_ros.getCostmap()->getSizeInCellsY(); ++i) {
-                if (costmap_ros.getCostmap()->getCost(index_check_free_x1, i) == 0) {
-                    num_free_1++;
-                }
-            }
-            index_check_free_x2 = index_check_free_x1 + 1;
-            for (int i = 0; i < costmap_ros.getCostmap()->getSizeInCellsY(); ++i) {
-                if (costmap_ros.getCostmap()->getCost(index_check_free_x2, i) == 0) {
-                    num_free_2++;
-                }
-            }
-        }
-        else{
-            //check the rear of the map
-            index_check_free_x1=costmap_ros.getCostmap()->getSizeInCellsX()*1/6;
-            for(int i=0;i<costmap_ros.getCostmap()->getSizeInCellsY();++i){
-                if(costmap_ros.getCostmap()->getCost(index_check_free_x1,i)==0){
-                    num_free_1++;
-                }
-            }
-            index_check_free_x2=index_check_free_x1-1;
-            for(int i=0;i<costmap_ros.getCostmap()->getSizeInCellsY();++i){
-                if(costmap_ros.getCostmap()->getCost(index_check_free_x2,i)==0){
-                    num_free_2++;
-                }
-            }
+vector<double> load_steering_targets(ros::NodeHandle& private_nh){
+    //either an explicit list of targets in degrees, or num_steering_bins targets spread evenly over [-max, max]
+    vector<double> targets_deg;
+    if(!private_nh.getParam("steering_targets",targets_deg)||targets_deg.empty()){
+        int num_bins;
+        double max_deg;
+        private_nh.param("num_steering_bins",num_bins,13);
+        private_nh.param("max_steering_deg",max_deg,15.0);
+        num_bins=std::max(num_bins,1);
+        for(int k=0;k<num_bins;++k){
+            targets_deg.push_back(num_bins==1?0.0:-max_deg+2.0*max_deg*k/(num_bins-1));
         }
-        if((num_free_1>num_threshold&&num_free_2>num_threshold))
-            switchMap=1;
     }
-    else{
-        //map size pattern2
-        //check the ahead of the map
-        if(flag_ahead_rear==3){
-            index_check_free_y1=costmap_ros.getCostmap()->getSizeInCellsY()*5/6;
-            for(int i=0;i<costmap_ros.getCostmap()->getSizeInCellsX();++i){
-                if(costmap_ros.getCostmap()->getCost(i,index_check_free_y1)==0){
-                    num_free_1++;
-                }
-            }
-            index_check_free_y2=index_check_free_y1+1;
-            for(int i=0;i<costmap_ros.getCostmap()->getSizeInCellsX();++i){
-                if(costmap_ros.getCostmap()->getCost(i,index_check_free_y2)==0){
-                    num_free_2++;
-                }
-            }
-        }
-        else {
-            //check the rear of the map
-            index_check_free_y1 = costmap_ros.getCostmap()->getSizeInCellsY() * 1 / 6;
-            for (int i = 0; i < costmap_ros.getCostmap()->getSizeInCellsX(); ++i) {
-                if (costmap_ros.getCostmap()->getCost(i, index_check_free_y1) == 0) {
-                    num_free_1++;
-                }
-            }
-            index_check_free_y2 = index_check_free_y1 - 1;
-            for (int i = 0; i < costmap_ros.getCostmap()->getSizeInCellsX(); ++i) {
-                if (costmap_ros.getCostmap()->getCost(i, index_check_free_y2) == 0) {
-                    num_free_2++;
-                }
-            }
-        }
-        if((num_free_1>num_threshold&&num_free_2>num_threshold))
-            switchMap=1;
+    vector<double> targets_rad;
+    for(unsigned int k=0;k<targets_deg.size();++k){
+        targets_rad.push_back(targets_deg[k]*PI/180);
     }
-    ROS_INFO("if it is rear or head: #######%d",flag_ahead_rear);
-    ROS_INFO("how many free grids for ahead 5/6:###### %d",num_free_1);
-    ROS_INFO("how many free grids for rear 1/6-1:###### %d",num_free_2);
-    return switchMap;
+    return targets_rad;
 }
+
 int main(int argc, char** argv)
 {
     ros::init(argc, argv, "lattice_planner");
     ros::NodeHandle nh;
+    ros::NodeHandle private_nh("~");
     tf2_ros::Buffer buffer(ros::Duration(10));
     tf2_ros::TransformListener tf(buffer);
     costmap_2d::Costmap2DROS lcr("costmap", buffer);
+    //count the free cells of every row and column along with the map updates for the map switch
+    bool use_cell_counters;
+    private_nh.param("use_cell_counters",use_cell_counters,true);
+    //max-pooled levels of the costmap, the primitives skip the cell checks over free blocks
+    int cost_pyramid_levels;
+    private_nh.param("cost_pyramid_levels",cost_pyramid_levels,4);
+    {
+        boost::unique_lock<costmap_2d::Costmap2D::mutex_t> lock(*lcr.getCostmap()->getMutex());
+        lcr.getLayeredCostmap()->setTrackCellCounts(use_cell_counters);
+        lcr.getLayeredCostmap()->setPyramidLevels(std::max(cost_pyramid_levels,0));
+    }
+    private_nh.param("use_costmap_snapshots",use_costmap_snapshots,true);
+    lcr.getLayeredCostmap()->setPublishSnapshots(use_costmap_snapshots);
 
     ros::Subscriber sub_odom = nh.subscribe("car_pose_estimate", 1000, odomCallback);
     ros::Subscriber sub_teensyread = nh.subscribe("teensy_read", 10, teensyCallback);
 
     mapSwitch = nh.advertise<std_msgs::Int8>("map_switch", 1);
-    pub_marker = nh.advertise<visualization_msgs::Marker>("lattice_marker", 0);
     motoPub = nh.advertise<auto_navi::motorMsg>("fast", 1);
     steerPub = nh.advertise<dynamo_msgs::SteeringStepper>("cmd_steering_angle_goal", 100);
-
-    float x=0.0,y=0.0;
-    FILE *fp;
-    fp=fopen(file,"r");
-    while(1){
-        fscanf(fp,"%f,%f",&x,&y);
-        road_x.push_back(x);
-        road_y.push_back(y);
-        if (feof(fp)) break;
+    latencyPub = nh.advertise<std_msgs::Float64>("lattice_latency", 1);
+    longitudinalPub = nh.advertise<std_msgs::Float32MultiArray>("lattice_longitudinal", 1);
+    diagnosticsPub = nh.advertise<diagnostic_msgs::DiagnosticArray>("diagnostics", 1);
+    ros::WallTimer latency_timer = nh.createWallTimer(ros::WallDuration(1.0), publish_latency);
+
+    costmap_2d::LatticePlannerConfig config;
+    private_nh.param("time_step",config.time_step,Ts);
+    private_nh.param("horizon",config.horizon,T_final);
+    config.steering_targets=load_steering_targets(private_nh);
+    private_nh.param("use_longitudinal_product",config.use_longitudinal_product,config.use_longitudinal_product);
+    private_nh.param("cof_break",config.cof_break,config.cof_break);
+    private_nh.param("target_speed",config.target_speed,config.target_speed);
+    private_nh.param("weight_speed",config.weight_speed,config.weight_speed);
+    private_nh.param("weight_effort",config.weight_effort,config.weight_effort);
+    private_nh.param("use_footprint_check",config.use_footprint_check,true);
+    private_nh.param("use_warm_start",config.use_warm_start,config.use_warm_start);
+    private_nh.param("warm_start_replan_period",config.warm_start_replan_period,config.warm_start_replan_period);
+    private_nh.param("warm_start_max_deviation",config.warm_start_max_deviation,config.warm_start_max_deviation);
+    private_nh.param("warm_start_hysteresis",config.warm_start_hysteresis,config.warm_start_hysteresis);
+    private_nh.param("search_depth",config.search_depth,1);
+    private_nh.param("search_stage_time",config.search_stage_time,1.0);
+    private_nh.param("search_node_budget",config.search_node_budget,500);
+    private_nh.param("search_path_weight",config.search_path_weight,1.0);
+    private_nh.param("use_primitive_cache",config.use_primitive_cache,false);
+    double cache_steering_resolution_deg;
+    private_nh.param("cache_max_speed",config.cache_max_speed,10.0);
+    private_nh.param("cache_speed_resolution",config.cache_speed_resolution,0.5);
+    private_nh.param("cache_steering_resolution_deg",cache_steering_resolution_deg,0.5);
+    config.cache_steering_resolution=cache_steering_resolution_deg*PI/180;
+    private_nh.param("goal_lookahead",config.goal_lookahead,config.goal_lookahead);
+    //the calling thread takes part in the scoring, so the pool gets one thread less than the cores used
+    private_nh.param("num_planner_threads",config.num_threads,-1);
+    private_nh.param("use_branch_and_bound",config.use_branch_and_bound,false);
+    private_nh.param("plan_deadline",config.plan_deadline,0.0);
+    private_nh.param("anytime_coarse_stride",config.anytime_coarse_stride,3);
+    private_nh.param("use_escape_search",config.use_escape_search,true);
+    private_nh.param("escape_node_budget",config.escape_node_budget,20000);
+    private_nh.param("escape_time_budget",config.escape_time_budget,0.01);
+    private_nh.param("escape_lookahead",config.escape_lookahead,3.0);
+    private_nh.param("pose_sigma_xy",config.pose_sigma_xy,0.0);
+    private_nh.param("pose_sigma_theta",config.pose_sigma_theta,0.0);
+    private_nh.param("hypothesis_worst_weight",config.hypothesis_worst_weight,0.5);
+    if(config.num_threads<0)
+        config.num_threads=std::max(1u,boost::thread::hardware_concurrency())-1;
+    planner.configure(config);
+    ROS_INFO("lattice: %u primitives of %u steps",planner.getPrimitives().size(),planner.getPrimitives().getNumSteps());
+    if(config.search_depth>1)
+        ROS_INFO("lattice: searching %d stages of %.1f s",config.search_depth,config.search_stage_time);
+    if(config.use_primitive_cache)
+        ROS_INFO("lattice: primitive cache built up to %.1f m/s",config.cache_max_speed);
+    ROS_INFO("lattice: scoring on %d threads",config.num_threads+1);
+
+    string reference_path_file;
+    double closing_distance;
+    private_nh.param("reference_path_file",reference_path_file,
+                     string("/home/dlsh/Ecocar_offline_path_optimization/result_analysis/mue=0.9/traj_opt.csv"));
+    private_nh.param("reference_path_closing_distance",closing_distance,3.0);
+    costmap_2d::ReferencePath& reference_path=planner.getReferencePath();
+    if(!reference_path.load(reference_path_file,closing_distance)){
+        ROS_ERROR("lattice: could not read the reference path from %s",reference_path_file.c_str());
+        return 1;
+    }
+    ROS_INFO("lattice: reference path of %u points, %.1f m%s",reference_path.size(),reference_path.getLength(),
+             reference_path.isClosed()?", closed":"");
+
+    //record the inputs and decisions of every tick for lattice_replay
+    string record_file;
+    private_nh.param("record_file",record_file,string(""));
+    if(!record_file.empty()){
+        if(planner_log.open(record_file,config,reference_path))
+            ROS_INFO("lattice: recording to %s",record_file.c_str());
+        else
+            ROS_ERROR("lattice: could not open %s for recording",record_file.c_str());
     }
-    fclose(fp);
 
 
+    //the markers are taken at most visualization_rate times per second, and only while someone listens
+    double visualization_rate;
+    int marker_history;
+    private_nh.param("visualization_rate",visualization_rate,5.0);
+    private_nh.param("marker_history",marker_history,50);
+    costmap_2d::TrajectoryVisualizer visualizer(nh,"lattice_markers","world",visualization_rate,2,
+                                                std::max(marker_history,1));
+    trajectory_visualizer=&visualizer;
+
+    //plan once per costmap update, but at most every planner_min_period, or on a fixed rate of 5 Hz
+    bool plan_on_map_update;
+    double planner_min_period,map_update_timeout;
+    private_nh.param("plan_on_map_update",plan_on_map_update,true);
+    private_nh.param("planner_min_period",planner_min_period,0.05);
+    private_nh.param("map_update_timeout",map_update_timeout,0.5);
+
     float loop_Rate = 5; //[Hz]
     ros::Rate r(loop_Rate);
+    unsigned long map_epoch=0;
+    ros::Time map_stamp=ros::Time::now(),last_plan;
     ROS_INFO("Main loop.");
     while (ros::ok()) {
+        if(plan_on_map_update){
+            if(!lcr.waitForUpdate(map_epoch,map_stamp,map_update_timeout))
+                ROS_WARN_THROTTLE(1.0,"lattice: no costmap update for %.2f s, planning on the old map",map_update_timeout);
+            ros::Duration since_plan=ros::Time::now()-last_plan;
+            if(since_plan<ros::Duration(planner_min_period))
+                (ros::Duration(planner_min_period)-since_plan).sleep();
+        }
+        else{
+            map_stamp=ros::Time::now();
+        }
+        last_plan=ros::Time::now();
         ros::spinOnce();
-        lattice_planner(lcr);
-        r.sleep();
+        lattice_planner(lcr,map_stamp);
+        if(!plan_on_map_update)
+            r.sleep();
     }
+    trajectory_visualizer=NULL;
 
     return (0);
 }
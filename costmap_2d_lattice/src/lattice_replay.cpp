@@ -0,0 +1,336 @@
+/*
+ * lattice_replay: plays a planner log recorded by lattice_planner_node (parameter record_file)
+ * back through the planner core as fast as possible, without a ROS master.
+ *
+ * usage: lattice_replay <log> [-o decisions.csv] [-r reference.csv] [--closed-loop] [name:=value ...]
+ *
+ * Every tick is planned on the recorded costmap and state. The steering angle the tick starts
+ * from is taken from the log unless --closed-loop is given, then the planner keeps its own.
+ * The wall time of the planner stages is reported per stage, and the decisions are compared
+ * with the recorded ones, or with the decisions of an earlier replay written with -o.
+ * name:=value overrides a parameter of the recorded configuration, e.g. use_primitive_cache:=1.
+ */
+#include <costmap_2d/lattice_planner.h>
+#include <costmap_2d/planner_log.h>
+#include <ros/console.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using costmap_2d::LatticePlan;
+using costmap_2d::LatticePlannerConfig;
+
+namespace
+{
+
+/** @brief The part of a decision that is compared between runs. */
+struct Decision
+{
+  unsigned int primitive;
+  double steering;
+  int fast;
+  int switch_map;
+  bool warm_started;
+};
+
+Decision toDecision(const LatticePlan& plan)
+{
+  Decision decision;
+  decision.primitive = plan.primitive;
+  decision.steering = plan.steering;
+  decision.fast = plan.fast;
+  decision.switch_map = plan.switch_map;
+  decision.warm_started = plan.warm_started;
+  return decision;
+}
+
+bool setConfigValue(LatticePlannerConfig& config, const std::string& name, const std::string& value)
+{
+  double number = atof(value.c_str());
+  if (name == "time_step")
+    config.time_step = number;
+  else if (name == "horizon")
+    config.horizon = number;
+  else if (name == "use_footprint_check")
+    config.use_footprint_check = number != 0.0;
+  else if (name == "use_primitive_cache")
+    config.use_primitive_cache = number != 0.0;
+  else if (name == "cache_max_speed")
+    config.cache_max_speed = number;
+  else if (name == "cache_speed_resolution")
+    config.cache_speed_resolution = number;
+  else if (name == "cache_steering_resolution_deg")
+    config.cache_steering_resolution = number * M_PI / 180;
+  else if (name == "goal_lookahead")
+    config.goal_lookahead = number;
+  else if (name == "use_warm_start")
+    config.use_warm_start = number != 0.0;
+  else if (name == "warm_start_replan_period")
+    config.warm_start_replan_period = number;
+  else if (name == "warm_start_max_deviation")
+    config.warm_start_max_deviation = number;
+  else if (name == "warm_start_hysteresis")
+    config.warm_start_hysteresis = number;
+  else if (name == "search_depth")
+    config.search_depth = (int)number;
+  else if (name == "search_stage_time")
+    config.search_stage_time = number;
+  else if (name == "search_node_budget")
+    config.search_node_budget = (int)number;
+  else if (name == "search_path_weight")
+    config.search_path_weight = number;
+  else if (name == "use_longitudinal_product")
+    config.use_longitudinal_product = number != 0.0;
+  else if (name == "cof_break")
+    config.cof_break = number;
+  else if (name == "target_speed")
+    config.target_speed = number;
+  else if (name == "weight_speed")
+    config.weight_speed = number;
+  else if (name == "weight_effort")
+    config.weight_effort = number;
+  else if (name == "num_planner_threads")
+    config.num_threads = (int)number;
+  else if (name == "use_branch_and_bound")
+    config.use_branch_and_bound = number != 0.0;
+  else if (name == "plan_deadline")
+    config.plan_deadline = number;
+  else if (name == "anytime_coarse_stride")
+    config.anytime_coarse_stride = (int)number;
+  else if (name == "use_escape_search")
+    config.use_escape_search = number != 0.0;
+  else if (name == "escape_node_budget")
+    config.escape_node_budget = (int)number;
+  else if (name == "escape_time_budget")
+    config.escape_time_budget = number;
+  else if (name == "escape_lookahead")
+    config.escape_lookahead = number;
+  else if (name == "pose_sigma_xy")
+    config.pose_sigma_xy = number;
+  else if (name == "pose_sigma_theta")
+    config.pose_sigma_theta = number;
+  else if (name == "hypothesis_worst_weight")
+    config.hypothesis_worst_weight = number;
+  else
+    return false;
+  return true;
+}
+
+bool readDecisions(const std::string& filename, std::vector<Decision>& decisions)
+{
+  std::ifstream file(filename.c_str());
+  if (!file.is_open())
+    return false;
+  std::string line;
+  std::getline(file, line);  // header
+  while (std::getline(file, line))
+  {
+    unsigned int tick;
+    double stamp;
+    int warm_started;
+    Decision decision;
+    if (sscanf(line.c_str(), "%u,%lf,%u,%lf,%d,%d,%d", &tick, &stamp, &decision.primitive, &decision.steering,
+               &decision.fast, &decision.switch_map, &warm_started) != 7)
+      return false;
+    decision.warm_started = warm_started != 0;
+    decisions.push_back(decision);
+  }
+  return true;
+}
+
+/** @brief Print the mean, percentiles and maximum of a stage over all ticks. */
+void printStage(const char* name, std::vector<double> times)
+{
+  if (times.empty())
+    return;
+  std::sort(times.begin(), times.end());
+  double sum = 0.0;
+  for (unsigned int i = 0; i < times.size(); ++i)
+    sum += times[i];
+  printf("  %-10s mean %8.3f  p50 %8.3f  p95 %8.3f  p99 %8.3f  max %8.3f ms\n", name, 1e3 * sum / times.size(),
+         1e3 * times[times.size() / 2], 1e3 * times[std::min(times.size() - 1, times.size() * 95 / 100)],
+         1e3 * times[std::min(times.size() - 1, times.size() * 99 / 100)], 1e3 * times.back());
+}
+
+}  // namespace
+
+int main(int argc, char** argv)
+{
+  std::string log_file, output_file, reference_file;
+  bool closed_loop = false;
+  std::vector<std::string> overrides;
+  for (int i = 1; i < argc; ++i)
+  {
+    std::string arg = argv[i];
+    if (arg == "-o" && i + 1 < argc)
+      output_file = argv[++i];
+    else if (arg == "-r" && i + 1 < argc)
+      reference_file = argv[++i];
+    else if (arg == "--closed-loop")
+      closed_loop = true;
+    else if (arg.find(":=") != std::string::npos)
+      overrides.push_back(arg);
+    else if (log_file.empty() && arg[0] != '-')
+      log_file = arg;
+    else
+    {
+      fprintf(stderr, "unknown argument %s\n", arg.c_str());
+      return 1;
+    }
+  }
+  if (log_file.empty())
+  {
+    fprintf(stderr, "usage: lattice_replay <log> [-o decisions.csv] [-r reference.csv] [--closed-loop] "
+            "[name:=value ...]\n");
+    return 1;
+  }
+
+  // the planner reports every tick at info level, which would dominate the timings
+  if (ros::console::set_logger_level(ROSCONSOLE_DEFAULT_NAME, ros::console::levels::Warn))
+    ros::console::notifyLoggerLevelsChanged();
+
+  costmap_2d::PlannerLogReader reader;
+  LatticePlannerConfig config;
+  costmap_2d::LatticePlanner planner;
+  if (!reader.open(log_file, config, planner.getReferencePath()))
+  {
+    fprintf(stderr, "%s is no planner log\n", log_file.c_str());
+    return 1;
+  }
+  for (unsigned int i = 0; i < overrides.size(); ++i)
+  {
+    std::string name = overrides[i].substr(0, overrides[i].find(":="));
+    if (!setConfigValue(config, name, overrides[i].substr(name.size() + 2)))
+    {
+      fprintf(stderr, "unknown parameter %s\n", name.c_str());
+      return 1;
+    }
+  }
+  planner.configure(config);
+
+  std::vector<Decision> reference;
+  if (!reference_file.empty() && !readDecisions(reference_file, reference))
+  {
+    fprintf(stderr, "could not read the reference decisions from %s\n", reference_file.c_str());
+    return 1;
+  }
+  FILE* output = NULL;
+  if (!output_file.empty())
+  {
+    output = fopen(output_file.c_str(), "w");
+    if (!output)
+    {
+      fprintf(stderr, "could not open %s\n", output_file.c_str());
+      return 1;
+    }
+    fprintf(output, "tick,stamp,primitive,steering,fast,switch_map,warm_started\n");
+  }
+
+  std::vector<double> rollout, scoring, selection, switch_map, total;
+  unsigned int num_ticks = 0, num_replans = 0, num_scored = 0, num_cut = 0;
+  unsigned int primitive_diffs = 0, fast_diffs = 0, switch_diffs = 0, warm_diffs = 0, printed_diffs = 0;
+  double max_steering_diff = 0.0;
+  costmap_2d::Costmap2D map;
+  costmap_2d::CellCounters counters;
+  costmap_2d::PlannerLogRecord record;
+  while (reader.read(record))
+  {
+    record.getMap(map);
+    // the node keeps the counters up to date along with the map updates, outside of the tick
+    counters.rebuild(map);
+    planner.setFootprint(record.footprint, record.resolution);
+    if (!closed_loop)
+      planner.setSteering(record.steering);
+
+    LatticePlan plan;
+    planner.plan(map, record.state, record.stamp, record.changes_known ? record.changed_bounds : NULL,
+                 record.margin, plan, &counters);
+
+    rollout.push_back(plan.timings.rollout);
+    switch_map.push_back(plan.timings.switch_map);
+    total.push_back(plan.timings.total);
+    if (!plan.warm_started)
+    {
+      scoring.push_back(plan.timings.scoring);
+      selection.push_back(plan.timings.selection);
+      ++num_replans;
+      num_scored += plan.num_scored;
+      if (plan.num_skipped > 0)
+        ++num_cut;
+    }
+    if (output)
+      fprintf(output, "%u,%.6f,%u,%.9f,%d,%d,%d\n", num_ticks, record.stamp, plan.primitive, plan.steering,
+              plan.fast, plan.switch_map, plan.warm_started ? 1 : 0);
+
+    // compare with the reference run if one is given, with the recorded run otherwise
+    bool has_expected = reference_file.empty() || num_ticks < reference.size();
+    if (has_expected)
+    {
+      Decision expected = reference_file.empty() ? toDecision(record.plan) : reference[num_ticks];
+      Decision actual = toDecision(plan);
+      bool differs = false;
+      if (actual.primitive != expected.primitive)
+      {
+        ++primitive_diffs;
+        differs = true;
+      }
+      if (actual.fast != expected.fast)
+      {
+        ++fast_diffs;
+        differs = true;
+      }
+      if (actual.switch_map != expected.switch_map)
+      {
+        ++switch_diffs;
+        differs = true;
+      }
+      if (actual.warm_started != expected.warm_started)
+      {
+        ++warm_diffs;
+        differs = true;
+      }
+      max_steering_diff = std::max(max_steering_diff, fabs(actual.steering - expected.steering));
+      if (differs && printed_diffs < 10)
+      {
+        printf("tick %u: primitive %u/%u fast %d/%d switch %d/%d warm %d/%d (replay/reference)\n", num_ticks,
+               actual.primitive, expected.primitive, actual.fast, expected.fast, actual.switch_map,
+               expected.switch_map, actual.warm_started, expected.warm_started);
+        ++printed_diffs;
+      }
+    }
+    ++num_ticks;
+  }
+  if (output)
+    fclose(output);
+
+  double total_time = 0.0;
+  for (unsigned int i = 0; i < total.size(); ++i)
+    total_time += total[i];
+  printf("%u ticks, %u full replans, %u primitives, %d threads\n", num_ticks, num_replans,
+         planner.getPrimitives().size(), config.num_threads + 1);
+  if (num_ticks == 0)
+    return 1;
+  printf("throughput %.1f ticks/s of planner time\n", total_time > 0.0 ? num_ticks / total_time : 0.0);
+  if (num_replans > 0)
+    printf("%.1f primitives scored per replan, %u replans stopped at the deadline\n",
+           (double)num_scored / num_replans, num_cut);
+  printf("stage timings (scoring and selection over full replans only):\n");
+  printStage("rollout", rollout);
+  printStage("scoring", scoring);
+  printStage("selection", selection);
+  printStage("switch_map", switch_map);
+  printStage("total", total);
+
+  unsigned int num_compared = num_ticks;
+  if (!reference_file.empty())
+    num_compared = std::min(num_ticks, (unsigned int)reference.size());
+  printf("decisions against the %s run over %u ticks:\n", reference_file.empty() ? "recorded" : "reference",
+         num_compared);
+  printf("  primitive %u, fast %u, switch_map %u, warm start %u differ, steering differs by up to %.4f deg\n",
+         primitive_diffs, fast_diffs, switch_diffs, warm_diffs, max_steering_diff * 180 / M_PI);
+  return 0;
+}
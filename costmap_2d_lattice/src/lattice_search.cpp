@@ -0,0 +1,241 @@
+#include <costmap_2d/lattice_search.h>
+#include <costmap_2d/cost_values.h>
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace costmap_2d
+{
+
+LatticeSearch::LatticeSearch() :
+    depth_(0), node_budget_(0), path_weight_(0.0), u_engine_(0.0), best_g_stamp_(0), complete_(false),
+    num_expanded_(0), start_steering_(0.0)
+{
+  std::fill(start_state_, start_state_ + 4, 0.0);
+}
+
+void LatticeSearch::configure(const std::vector<double>& steering_targets, double time_step, double stage_time,
+                              unsigned int depth, unsigned int node_budget, double path_weight,
+                              const VehicleModel& model)
+{
+  set_.configure(steering_targets, time_step, stage_time, model);
+  depth_ = depth;
+  node_budget_ = node_budget;
+  path_weight_ = path_weight;
+  u_engine_list_.assign(set_.getNumSteps(), 0.0);
+  u_break_list_.assign(set_.getNumSteps(), 0.0);
+  // every expansion adds at most one node per primitive
+  unsigned int max_nodes = node_budget_ * set_.size() + 1;
+  nodes_.reserve(max_nodes);
+  open_.reserve(max_nodes);
+  chain_.reserve(depth_);
+  unsigned int num_slots = 1;
+  while (num_slots < 2 * max_nodes)
+    num_slots *= 2;
+  CostSlot empty = {0, DBL_MAX, 0};
+  best_g_.assign(num_slots, empty);
+  best_g_stamp_ = 0;
+}
+
+double LatticeSearch::stageCost(const Costmap2D& map, const FootprintChecker& checker, const ReferencePath& path,
+                                const Node& from, unsigned int p, double& s_end) const
+{
+  double cost_obstacle = 0.0, path_distance = 0.0;
+  // every sample is projected by walking the reference path on from the previous one
+  s_end = from.s;
+  double x_last = from.x, y_last = from.y, theta_last = from.theta;
+  for (unsigned int i = 0; i < set_.getNumSteps(); ++i)
+  {
+    double x = set_.x(p, i), y = set_.y(p, i), theta = set_.theta(p, i);
+    unsigned char cost = 0;
+    unsigned int mx, my;
+    if (checker.isConfigured())
+      cost = checker.sweptCost(map, x_last, y_last, theta_last, x, y, theta);
+    else if (map.worldToMap(x, y, mx, my))
+      cost = map.getCost(mx, my);
+    if (cost == LETHAL_OBSTACLE)
+      return -1.0;
+    cost_obstacle += cost / 100.0;
+
+    double distance;
+    if (path.projectFrom(s_end, x, y, s_end, distance))
+      path_distance += distance * set_.getTimeStep();
+
+    x_last = x;
+    y_last = y;
+    theta_last = theta;
+  }
+  return cost_obstacle + path_weight_ * path_distance;
+}
+
+double LatticeSearch::heuristic(const Node& node, double goal_x, double goal_y) const
+{
+  // drag only slows the car down, so the engine input alone bounds the speed of the remaining stages
+  double remaining_time = (depth_ - node.depth) * set_.getNumSteps() * set_.getTimeStep();
+  double reach = remaining_time * std::max(node.v, node.v + u_engine_ * remaining_time);
+  return std::max(0.0, hypot(goal_x - node.x, goal_y - node.y) - reach);
+}
+
+unsigned long long LatticeSearch::getKey(const Node& node, double resolution) const
+{
+  unsigned long long ix = (unsigned long long)((long long)floor(node.x / resolution) + (1 << 20)) & 0x1fffff;
+  unsigned long long iy = (unsigned long long)((long long)floor(node.y / resolution) + (1 << 20)) & 0x1fffff;
+  int heading_bin = (int)floor(node.theta * 36 / (2 * M_PI) + 0.5) % 36;
+  if (heading_bin < 0)
+    heading_bin += 36;
+  return ((((unsigned long long)node.depth << 21 | ix) << 21 | iy) << 6) | heading_bin;
+}
+
+double& LatticeSearch::bestG(unsigned long long key)
+{
+  // fibonacci hashing, linear probing; the table is never more than half full
+  unsigned int mask = best_g_.size() - 1;
+  unsigned int slot = (unsigned int)((key * 0x9e3779b97f4a7c15ULL) >> 32) & mask;
+  while (best_g_[slot].stamp == best_g_stamp_ && best_g_[slot].key != key)
+    slot = (slot + 1) & mask;
+  CostSlot& entry = best_g_[slot];
+  if (entry.stamp != best_g_stamp_)
+  {
+    entry.key = key;
+    entry.g = DBL_MAX;
+    entry.stamp = best_g_stamp_;
+  }
+  return entry.g;
+}
+
+bool LatticeSearch::search(const Costmap2D& map, const FootprintChecker& checker, const ReferencePath& path,
+                           const double* start_state, double steering_current, double u_engine, double goal_x,
+                           double goal_y, int preferred, double preferred_bonus)
+{
+  chain_.clear();
+  complete_ = false;
+  num_expanded_ = 0;
+  if (set_.size() == 0 || depth_ == 0)
+    return false;
+
+  std::copy(start_state, start_state + 4, start_state_);
+  start_steering_ = steering_current;
+  u_engine_ = u_engine;
+  std::fill(u_engine_list_.begin(), u_engine_list_.end(), u_engine);
+
+  nodes_.clear();
+  // a new stamp empties the cost table in O(1), the slots are only wiped once the stamp wraps
+  if (++best_g_stamp_ == 0)
+  {
+    for (unsigned int k = 0; k < best_g_.size(); ++k)
+      best_g_[k].stamp = 0;
+    best_g_stamp_ = 1;
+  }
+  open_.reset(0.0, 0.1, 1024);
+
+  Node root;
+  root.x = start_state[0];
+  root.y = start_state[1];
+  root.theta = start_state[2];
+  root.v = start_state[3];
+  root.steering = steering_current;
+  root.g = 0.0;
+  // the only full projection of the search, every stage walks on from the node it starts at
+  double root_distance;
+  if (!path.project(root.x, root.y, root.s, root_distance))
+    root.s = 0.0;
+  root.parent = -1;
+  root.primitive = 0;
+  root.depth = 0;
+  nodes_.push_back(root);
+  open_.push(0, heuristic(root, goal_x, goal_y));
+
+  int result = -1;
+  unsigned int index;
+  double f;
+  unsigned int last = set_.getNumSteps() - 1;
+  while (open_.pop(index, f))
+  {
+    Node node = nodes_[index];
+    if (node.depth > 0 && bestG(getKey(node, map.getResolution())) < node.g)
+      continue;  // a cheaper node reached the same lattice cell after this one was queued
+
+    if (node.depth == depth_)
+    {
+      result = index;
+      complete_ = true;
+      break;
+    }
+    if (num_expanded_ >= node_budget_)
+    {
+      // out of budget, the partial chain with the lowest estimate is the best guess
+      if (node.depth > 0)
+        result = index;
+      break;
+    }
+    ++num_expanded_;
+
+    double node_state[4] = {node.x, node.y, node.theta, node.v};
+    set_.rollout(node_state, node.steering, &u_engine_list_[0], &u_break_list_[0]);
+    for (unsigned int p = 0; p < set_.size(); ++p)
+    {
+      double s_end;
+      double cost = stageCost(map, checker, path, node, p, s_end);
+      if (cost < 0.0)
+        continue;
+
+      Node child;
+      child.x = set_.x(p, last);
+      child.y = set_.y(p, last);
+      child.theta = set_.theta(p, last);
+      child.v = set_.v(p, last);
+      child.steering = set_.u(p, last);
+      child.g = node.g + cost;
+      child.s = s_end;
+      child.parent = index;
+      child.primitive = p;
+      child.depth = node.depth + 1;
+      if (child.depth == depth_)
+        child.g += hypot(goal_x - child.x, goal_y - child.y);
+      if (node.depth == 0 && (int)p == preferred)
+        child.g = std::max(0.0, child.g - preferred_bonus);
+
+      double& best_g = bestG(getKey(child, map.getResolution()));
+      if (best_g <= child.g)
+        continue;
+      best_g = child.g;
+
+      nodes_.push_back(child);
+      open_.push(nodes_.size() - 1, child.depth == depth_ ? child.g : child.g + heuristic(child, goal_x, goal_y));
+    }
+  }
+
+  if (result < 0)
+    return false;
+  for (int n = result; nodes_[n].parent >= 0; n = nodes_[n].parent)
+    chain_.push_back(nodes_[n].primitive);
+  std::reverse(chain_.begin(), chain_.end());
+  return true;
+}
+
+void LatticeSearch::getChainPath(std::vector<double>& x, std::vector<double>& y)
+{
+  x.clear();
+  y.clear();
+  double state[4];
+  std::copy(start_state_, start_state_ + 4, state);
+  double steering = start_steering_;
+  unsigned int last = set_.getNumSteps() - 1;
+  for (unsigned int c = 0; c < chain_.size(); ++c)
+  {
+    unsigned int p = chain_[c];
+    set_.rollout(state, steering, &u_engine_list_[0], &u_break_list_[0]);
+    for (unsigned int i = 0; i < set_.getNumSteps(); ++i)
+    {
+      x.push_back(set_.x(p, i));
+      y.push_back(set_.y(p, i));
+    }
+    state[0] = set_.x(p, last);
+    state[1] = set_.y(p, last);
+    state[2] = set_.theta(p, last);
+    state[3] = set_.v(p, last);
+    steering = set_.u(p, last);
+  }
+}
+
+}  // namespace costmap_2d
@@ -60,11 +60,26 @@ LayeredCostmap::LayeredCostmap(std::string global_frame, bool rolling_window, bo
     bxn_(0),
     by0_(0),
     byn_(0),
+    changed_minx_(1e30),
+    changed_miny_(1e30),
+    changed_maxx_(-1e30),
+    changed_maxy_(-1e30),
+    changed_all_(true),
+    track_cell_counts_(false),
+    publish_snapshots_(false),
+    update_epoch_(0),
+    full_change_pending_(true),
+    full_change_epoch_(0),
     initialized_(false),
     size_locked_(false),
     circumscribed_radius_(1.0),
     inscribed_radius_(0.1)
 {
+  for (unsigned int e = 0; e < CostmapSnapshot::HISTORY; ++e)
+  {
+    changed_history_[e][0] = changed_history_[e][1] = 1e30;
+    changed_history_[e][2] = changed_history_[e][3] = -1e30;
+  }
   if (track_unknown)
     costmap_.setDefaultValue(255);
   else
@@ -85,6 +100,10 @@ void LayeredCostmap::resizeMap(unsigned int size_x, unsigned int size_y, double
   boost::unique_lock<Costmap2D::mutex_t> lock(*(costmap_.getMutex()));
   size_locked_ = size_locked;
   costmap_.resizeMap(size_x, size_y, resolution, origin_x, origin_y);
+  changed_all_ = true;
+  full_change_pending_ = true;
+  cell_counters_.invalidate();
+  pyramid_.invalidate();
   for (vector<boost::shared_ptr<Layer> >::iterator plugin = plugins_.begin(); plugin != plugins_.end();
       ++plugin)
   {
@@ -92,18 +111,62 @@ void LayeredCostmap::resizeMap(unsigned int size_x, unsigned int size_y, double
   }
 }
 
+bool LayeredCostmap::takeChangedBounds(double& minx, double& miny, double& maxx, double& maxy)
+{
+  boost::unique_lock<Costmap2D::mutex_t> lock(*(costmap_.getMutex()));
+  bool known = !changed_all_;
+  minx = changed_minx_;
+  miny = changed_miny_;
+  maxx = changed_maxx_;
+  maxy = changed_maxy_;
+
+  changed_minx_ = changed_miny_ = 1e30;
+  changed_maxx_ = changed_maxy_ = -1e30;
+  changed_all_ = false;
+  return known;
+}
+
+void LayeredCostmap::setPublishSnapshots(bool publish)
+{
+  boost::unique_lock<Costmap2D::mutex_t> lock(*(costmap_.getMutex()));
+  publish_snapshots_ = publish;
+  if (!publish)
+  {
+    // readers keep the snapshots they hold, the pool forgets them
+    boost::atomic_store(&snapshot_, boost::shared_ptr<CostmapSnapshot>());
+    snapshot_pool_.clear();
+    // the bounds of the updates in between are not recorded
+    full_change_pending_ = true;
+  }
+}
+
 void LayeredCostmap::updateMap(double robot_x, double robot_y, double robot_yaw)
 {
   // Lock for the remainder of this function, some plugins (e.g. VoxelLayer)
   // implement thread unsafe updateBounds() functions.
   boost::unique_lock<Costmap2D::mutex_t> lock(*(costmap_.getMutex()));
+  updateLayers(robot_x, robot_y, robot_yaw);
+  if (publish_snapshots_)
+    publishSnapshot();
+}
+
+void LayeredCostmap::updateLayers(double robot_x, double robot_y, double robot_yaw)
+{
+  update_changed_[0] = update_changed_[1] = 1e30;
+  update_changed_[2] = update_changed_[3] = -1e30;
 
   // if we're using a rolling buffer costmap... we need to update the origin using the robot's position
   if (rolling_window_)
   {
     double new_origin_x = robot_x - costmap_.getSizeInMetersX() / 2;
     double new_origin_y = robot_y - costmap_.getSizeInMetersY() / 2;
+    // the cells move by the same whole number of cells as in Costmap2D::updateOrigin()
+    int cell_dx = int((new_origin_x - costmap_.getOriginX()) / costmap_.getResolution());
+    int cell_dy = int((new_origin_y - costmap_.getOriginY()) / costmap_.getResolution());
+    if (track_cell_counts_)
+      cell_counters_.shift(costmap_, cell_dx, cell_dy);
     costmap_.updateOrigin(new_origin_x, new_origin_y);
+    pyramid_.shift(costmap_, cell_dx, cell_dy);
   }
 
   if (plugins_.size() == 0)
@@ -144,13 +207,34 @@ void LayeredCostmap::updateMap(double robot_x, double robot_y, double robot_yaw)
   if (xn < x0 || yn < y0)
     return;
 
+  changed_minx_ = std::min(changed_minx_, minx_);
+  changed_miny_ = std::min(changed_miny_, miny_);
+  changed_maxx_ = std::max(changed_maxx_, maxx_);
+  changed_maxy_ = std::max(changed_maxy_, maxy_);
+  update_changed_[0] = minx_;
+  update_changed_[1] = miny_;
+  update_changed_[2] = maxx_;
+  update_changed_[3] = maxy_;
+
+  if (track_cell_counts_)
+    cell_counters_.remove(costmap_, x0, y0, xn, yn);
   costmap_.resetMap(x0, y0, xn, yn);
   for (vector<boost::shared_ptr<Layer> >::iterator plugin = plugins_.begin(); plugin != plugins_.end();
        ++plugin)
   {
     (*plugin)->updateCosts(costmap_, x0, y0, xn, yn);
-    ROS_INFO("updateCost finished");
+    ROS_DEBUG("updateCost finished");
+  }
+  if (track_cell_counts_)
+  {
+    // stale counters are counted anew over the whole map once, then only the window is recounted
+    if (cell_counters_.isValid())
+      cell_counters_.add(costmap_, x0, y0, xn, yn);
+    else
+      cell_counters_.rebuild(costmap_);
   }
+  if (pyramid_.getNumLevels() > 0)
+    pyramid_.update(costmap_, x0, y0, xn, yn);
   //ROS_INFO("is sizelocked: %d",isSizeLocked());
   bx0_ = x0;
   bxn_ = xn;
@@ -160,6 +244,44 @@ void LayeredCostmap::updateMap(double robot_x, double robot_y, double robot_yaw)
   initialized_ = true;
 }
 
+void LayeredCostmap::publishSnapshot()
+{
+  ++update_epoch_;
+  if (full_change_pending_)
+  {
+    full_change_epoch_ = update_epoch_;
+    full_change_pending_ = false;
+  }
+  std::copy(update_changed_, update_changed_ + 4, changed_history_[update_epoch_ % CostmapSnapshot::HISTORY]);
+
+  // a snapshot referenced by the pool alone is neither published nor held by a reader, and as it
+  // was replaced already, no reader can get it again, so it is overwritten instead of allocated
+  boost::shared_ptr<CostmapSnapshot> snapshot;
+  for (unsigned int k = 0; k < snapshot_pool_.size() && !snapshot; ++k)
+  {
+    if (snapshot_pool_[k].use_count() == 1)
+      snapshot = snapshot_pool_[k];
+  }
+  if (!snapshot)
+  {
+    snapshot.reset(new CostmapSnapshot());
+    snapshot_pool_.push_back(snapshot);
+  }
+
+  // the cost array is only reallocated if the size of the map changed
+  snapshot->costmap_ = costmap_;
+  if (track_cell_counts_)
+    snapshot->counters_ = cell_counters_;
+  else
+    snapshot->counters_.invalidate();
+  snapshot->pyramid_ = pyramid_;
+  snapshot->epoch_ = update_epoch_;
+  snapshot->full_change_epoch_ = full_change_epoch_;
+  std::copy(&changed_history_[0][0], &changed_history_[0][0] + 4 * CostmapSnapshot::HISTORY,
+            &snapshot->changed_[0][0]);
+  boost::atomic_store(&snapshot_, snapshot);
+}
+
 bool LayeredCostmap::isCurrent()
 {
   current_ = true;
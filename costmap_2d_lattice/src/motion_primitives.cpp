@@ -0,0 +1,174 @@
+#include <costmap_2d/motion_primitives.h>
+#include <algorithm>
+#include <cmath>
+
+namespace costmap_2d
+{
+
+MotionPrimitiveSet::MotionPrimitiveSet() :
+    num_primitives_(0), num_steps_(0), straight_primitive_(0), time_step_(0.1)
+{
+}
+
+void MotionPrimitiveSet::configure(const std::vector<double>& steering_targets, double time_step, double horizon,
+                                   const VehicleModel& model)
+{
+  configure(steering_targets, std::vector<double>(1, 0.0), time_step, horizon, model);
+}
+
+void MotionPrimitiveSet::configure(const std::vector<double>& steering_targets,
+                                   const std::vector<double>& accelerations, double time_step, double horizon,
+                                   const VehicleModel& model)
+{
+  model_ = model;
+  steering_targets_ = steering_targets;
+  accelerations_ = accelerations;
+  if (accelerations_.empty() || steering_targets_.empty())
+    accelerations_.assign(1, 0.0);
+  time_step_ = time_step;
+  num_primitives_ = steering_targets_.size() * accelerations_.size();
+  num_steps_ = (int)(horizon / time_step) + 1;
+
+  straight_primitive_ = 0;
+  for (unsigned int p = 1; p < steering_targets_.size(); ++p)
+  {
+    if (fabs(steering_targets_[p]) < fabs(steering_targets_[straight_primitive_]))
+      straight_primitive_ = p;
+  }
+
+  unsigned int buffer_size = num_primitives_ * num_steps_;
+  x_.assign(buffer_size, 0.0);
+  y_.assign(buffer_size, 0.0);
+  theta_.assign(buffer_size, 0.0);
+  v_.assign(buffer_size, 0.0);
+  u_.assign(buffer_size, 0.0);
+  tan_u_.assign(buffer_size, 0.0);
+  accel_.assign(buffer_size, 0.0);
+
+  lane_x_.assign(num_primitives_, 0.0);
+  lane_y_.assign(num_primitives_, 0.0);
+  lane_theta_.assign(num_primitives_, 0.0);
+  lane_v_.assign(num_primitives_, 0.0);
+  lane_cos_.assign(num_primitives_, 1.0);
+  lane_sin_.assign(num_primitives_, 0.0);
+}
+
+void MotionPrimitiveSet::fillSteeringProfile(double steering_current, double steering_goal, double* profile,
+                                             unsigned int stride) const
+{
+  double sign_goal;
+  if ((steering_goal - steering_current) > 0)
+    sign_goal = 1.0;
+  else if ((steering_goal - steering_current) < 0)
+    sign_goal = -1.0;
+  else
+    sign_goal = 0.0;
+
+  // move towards the goal at the maximum steering rate and hold it once it is reached
+  profile[0] = steering_current;
+  for (unsigned int i = 1; i < num_steps_; ++i)
+  {
+    if (fabs(profile[(i - 1) * stride]) >= fabs(steering_goal))
+      profile[i * stride] = steering_goal;
+    else
+      profile[i * stride] = steering_current + sign_goal * i * model_.max_steering_rate * time_step_;
+  }
+}
+
+void MotionPrimitiveSet::rollout(const double* start_state, double steering_current, const double* u_engine,
+                                 const double* u_break)
+{
+  if (num_primitives_ == 0)
+    return;
+
+  // the profile and tan(u) only depend on the steering target, so they are computed for the
+  // primitives of the first acceleration and copied to the others
+  unsigned int num_targets = steering_targets_.size();
+  for (unsigned int p = 0; p < num_targets; ++p)
+    fillSteeringProfile(steering_current, steering_targets_[p], &u_[p], num_primitives_);
+  for (unsigned int i = 0; i < num_steps_; ++i)
+  {
+    double* u = &u_[i * num_primitives_];
+    double* tan_u = &tan_u_[i * num_primitives_];
+    for (unsigned int p = 0; p < num_targets; ++p)
+      tan_u[p] = tan(u[p]);
+    for (unsigned int a = 1; a < accelerations_.size(); ++a)
+    {
+      std::copy(u, u + num_targets, u + a * num_targets);
+      std::copy(tan_u, tan_u + num_targets, tan_u + a * num_targets);
+    }
+  }
+
+  for (unsigned int i = 0; i < num_steps_; ++i)
+  {
+    double accel = u_engine[i] + u_break[i];
+    for (unsigned int a = 0; a < accelerations_.size(); ++a)
+      std::fill(accel_.begin() + i * num_primitives_ + a * num_targets,
+                accel_.begin() + i * num_primitives_ + (a + 1) * num_targets, accel + accelerations_[a]);
+  }
+
+  double cos_theta = cos(start_state[2]), sin_theta = sin(start_state[2]);
+  std::fill(lane_x_.begin(), lane_x_.end(), start_state[0]);
+  std::fill(lane_y_.begin(), lane_y_.end(), start_state[1]);
+  std::fill(lane_theta_.begin(), lane_theta_.end(), start_state[2]);
+  std::fill(lane_v_.begin(), lane_v_.end(), start_state[3]);
+  std::fill(lane_cos_.begin(), lane_cos_.end(), cos_theta);
+  std::fill(lane_sin_.begin(), lane_sin_.end(), sin_theta);
+
+  integrateLanes();
+}
+
+void MotionPrimitiveSet::integrateLanes()
+{
+  const unsigned int n = num_primitives_;
+  const double ts = time_step_;
+  const double ts_over_l = time_step_ / model_.wheel_base;
+  const double drag_factor = 0.5 * model_.front_area * model_.drag_coefficient * model_.air_density / model_.mass;
+
+  double* __restrict__ lx = &lane_x_[0];
+  double* __restrict__ ly = &lane_y_[0];
+  double* __restrict__ lth = &lane_theta_[0];
+  double* __restrict__ lv = &lane_v_[0];
+  double* __restrict__ lc = &lane_cos_[0];
+  double* __restrict__ ls = &lane_sin_[0];
+
+  for (unsigned int i = 0; i < num_steps_; ++i)
+  {
+    const double* __restrict__ tan_u = &tan_u_[i * n];
+    const double* __restrict__ accel = &accel_[i * n];
+    double* __restrict__ x = &x_[i * n];
+    double* __restrict__ y = &y_[i * n];
+    double* __restrict__ theta = &theta_[i * n];
+    double* __restrict__ v = &v_[i * n];
+
+#pragma omp simd
+    for (unsigned int p = 0; p < n; ++p)
+    {
+      double v_last = lv[p];
+      double d_theta = ts_over_l * v_last * tan_u[p];
+
+      // the position advances along the heading of the previous step
+      lx[p] += ts * v_last * lc[p];
+      ly[p] += ts * v_last * ls[p];
+      lth[p] += d_theta;
+      // braking stops the car, it does not drive it backwards
+      lv[p] = std::max(v_last + ts * (accel[p] - drag_factor * v_last * v_last), 0.0);
+
+      // rotate the heading by d_theta, which stays well below a radian per step, so short
+      // Taylor series of sin and cos are exact to double precision for practical purposes
+      double d2 = d_theta * d_theta;
+      double sin_d = d_theta * (1.0 - d2 / 6.0 * (1.0 - d2 / 20.0 * (1.0 - d2 / 42.0 * (1.0 - d2 / 72.0))));
+      double cos_d = 1.0 - d2 / 2.0 * (1.0 - d2 / 12.0 * (1.0 - d2 / 30.0 * (1.0 - d2 / 56.0)));
+      double c = lc[p], s = ls[p];
+      lc[p] = c * cos_d - s * sin_d;
+      ls[p] = s * cos_d + c * sin_d;
+
+      x[p] = lx[p];
+      y[p] = ly[p];
+      theta[p] = lth[p];
+      v[p] = lv[p];
+    }
+  }
+}
+
+}  // namespace costmap_2d
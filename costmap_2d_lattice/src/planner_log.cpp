@@ -0,0 +1,223 @@
+#include <costmap_2d/planner_log.h>
+#include <cstring>
+
+namespace costmap_2d
+{
+
+namespace
+{
+const char LOG_MAGIC[8] = {'L', 'A', 'T', 'L', 'O', 'G', '\0', '\0'};
+// version 2 added use_branch_and_bound, version 3 the anytime mode, version 4 the grid escape search,
+// version 5 the start hypotheses
+const unsigned int LOG_VERSION = 5;
+
+template<typename T>
+void writeValue(std::ostream& out, const T& value)
+{
+  out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template<typename T>
+bool readValue(std::istream& in, T& value)
+{
+  in.read(reinterpret_cast<char*>(&value), sizeof(T));
+  return in.good();
+}
+
+template<typename T>
+void writeVector(std::ostream& out, const std::vector<T>& values)
+{
+  writeValue(out, (unsigned int)values.size());
+  if (!values.empty())
+    out.write(reinterpret_cast<const char*>(&values[0]), values.size() * sizeof(T));
+}
+
+template<typename T>
+bool readVector(std::istream& in, std::vector<T>& values)
+{
+  unsigned int size;
+  if (!readValue(in, size))
+    return false;
+  values.resize(size);
+  if (size > 0)
+    in.read(reinterpret_cast<char*>(&values[0]), size * sizeof(T));
+  return in.good();
+}
+
+// the fields of the configuration, in the order they are stored, read and written by the same code;
+// fields added after the first version come last, a log of an older version keeps their defaults
+template<typename Stream, typename Function>
+bool transferConfig(Stream& stream, unsigned int version, LatticePlannerConfig& config, Function transfer)
+{
+  bool ok = transfer(stream, config.time_step) && transfer(stream, config.horizon)
+      && transfer(stream, config.use_footprint_check) && transfer(stream, config.use_primitive_cache)
+      && transfer(stream, config.cache_max_speed) && transfer(stream, config.cache_speed_resolution)
+      && transfer(stream, config.cache_steering_resolution) && transfer(stream, config.goal_lookahead)
+      && transfer(stream, config.use_warm_start) && transfer(stream, config.warm_start_replan_period)
+      && transfer(stream, config.warm_start_max_deviation) && transfer(stream, config.warm_start_hysteresis)
+      && transfer(stream, config.search_depth) && transfer(stream, config.search_stage_time)
+      && transfer(stream, config.search_node_budget) && transfer(stream, config.search_path_weight)
+      && transfer(stream, config.use_longitudinal_product) && transfer(stream, config.cof_break)
+      && transfer(stream, config.target_speed) && transfer(stream, config.weight_speed)
+      && transfer(stream, config.weight_effort) && transfer(stream, config.num_threads);
+  if (ok && version >= 2)
+    ok = transfer(stream, config.use_branch_and_bound);
+  if (ok && version >= 3)
+    ok = transfer(stream, config.plan_deadline) && transfer(stream, config.anytime_coarse_stride);
+  if (ok && version >= 4)
+    ok = transfer(stream, config.use_escape_search) && transfer(stream, config.escape_node_budget)
+        && transfer(stream, config.escape_time_budget) && transfer(stream, config.escape_lookahead);
+  if (ok && version >= 5)
+    ok = transfer(stream, config.pose_sigma_xy) && transfer(stream, config.pose_sigma_theta)
+        && transfer(stream, config.hypothesis_worst_weight);
+  return ok;
+}
+
+struct ValueWriter
+{
+  template<typename T>
+  bool operator()(std::ostream& out, const T& value) const
+  {
+    writeValue(out, value);
+    return true;
+  }
+};
+
+struct ValueReader
+{
+  template<typename T>
+  bool operator()(std::istream& in, T& value) const
+  {
+    return readValue(in, value);
+  }
+};
+}  // namespace
+
+void PlannerLogRecord::setMap(const Costmap2D& map)
+{
+  size_x = map.getSizeInCellsX();
+  size_y = map.getSizeInCellsY();
+  resolution = map.getResolution();
+  origin_x = map.getOriginX();
+  origin_y = map.getOriginY();
+  costs.assign(map.getCharMap(), map.getCharMap() + size_x * size_y);
+}
+
+void PlannerLogRecord::getMap(Costmap2D& map) const
+{
+  if (map.getSizeInCellsX() != size_x || map.getSizeInCellsY() != size_y || map.getResolution() != resolution
+      || map.getOriginX() != origin_x || map.getOriginY() != origin_y)
+    map.resizeMap(size_x, size_y, resolution, origin_x, origin_y);
+  if (!costs.empty())
+    memcpy(map.getCharMap(), &costs[0], costs.size());
+}
+
+bool PlannerLogWriter::open(const std::string& filename, const LatticePlannerConfig& config,
+                            const ReferencePath& path)
+{
+  file_.open(filename.c_str(), std::ios::binary | std::ios::trunc);
+  if (!file_.is_open())
+    return false;
+
+  file_.write(LOG_MAGIC, sizeof(LOG_MAGIC));
+  writeValue(file_, LOG_VERSION);
+  LatticePlannerConfig stored = config;
+  transferConfig(file_, LOG_VERSION, stored, ValueWriter());
+  writeVector(file_, config.steering_targets);
+
+  writeValue(file_, path.isClosed());
+  writeVector(file_, path.getX());
+  writeVector(file_, path.getY());
+  file_.flush();
+  return file_.good();
+}
+
+void PlannerLogWriter::write(const PlannerLogRecord& record)
+{
+  writeValue(file_, record.stamp);
+  for (unsigned int i = 0; i < 4; ++i)
+    writeValue(file_, record.state[i]);
+  writeValue(file_, record.steering);
+  writeValue(file_, record.changes_known);
+  for (unsigned int i = 0; i < 4; ++i)
+    writeValue(file_, record.changed_bounds[i]);
+  writeValue(file_, record.margin);
+
+  writeValue(file_, (unsigned int)record.footprint.size());
+  for (unsigned int i = 0; i < record.footprint.size(); ++i)
+  {
+    writeValue(file_, record.footprint[i].x);
+    writeValue(file_, record.footprint[i].y);
+  }
+
+  writeValue(file_, record.size_x);
+  writeValue(file_, record.size_y);
+  writeValue(file_, record.resolution);
+  writeValue(file_, record.origin_x);
+  writeValue(file_, record.origin_y);
+  writeVector(file_, record.costs);
+
+  writeValue(file_, record.plan.primitive);
+  writeValue(file_, record.plan.steering);
+  writeValue(file_, record.plan.fast);
+  writeValue(file_, record.plan.switch_map);
+  writeValue(file_, record.plan.warm_started);
+  writeValue(file_, record.plan.goal_x);
+  writeValue(file_, record.plan.goal_y);
+  writeValue(file_, record.plan.timings.rollout);
+  writeValue(file_, record.plan.timings.scoring);
+  writeValue(file_, record.plan.timings.selection);
+  writeValue(file_, record.plan.timings.switch_map);
+  writeValue(file_, record.plan.timings.total);
+}
+
+bool PlannerLogReader::open(const std::string& filename, LatticePlannerConfig& config, ReferencePath& path)
+{
+  file_.open(filename.c_str(), std::ios::binary);
+  char magic[sizeof(LOG_MAGIC)];
+  unsigned int version;
+  if (!file_.read(magic, sizeof(magic)) || memcmp(magic, LOG_MAGIC, sizeof(magic)) != 0
+      || !readValue(file_, version) || version < 1 || version > LOG_VERSION)
+    return false;
+  if (!transferConfig(file_, version, config, ValueReader()) || !readVector(file_, config.steering_targets))
+    return false;
+
+  bool closed;
+  std::vector<double> x, y;
+  if (!readValue(file_, closed) || !readVector(file_, x) || !readVector(file_, y) || x.size() != y.size())
+    return false;
+  path.setPoints(x, y, closed);
+  return true;
+}
+
+bool PlannerLogReader::read(PlannerLogRecord& record)
+{
+  bool ok = readValue(file_, record.stamp);
+  for (unsigned int i = 0; i < 4; ++i)
+    ok = ok && readValue(file_, record.state[i]);
+  ok = ok && readValue(file_, record.steering) && readValue(file_, record.changes_known);
+  for (unsigned int i = 0; i < 4; ++i)
+    ok = ok && readValue(file_, record.changed_bounds[i]);
+  ok = ok && readValue(file_, record.margin);
+
+  unsigned int footprint_size = 0;
+  ok = ok && readValue(file_, footprint_size);
+  record.footprint.resize(ok ? footprint_size : 0);
+  for (unsigned int i = 0; ok && i < footprint_size; ++i)
+    ok = readValue(file_, record.footprint[i].x) && readValue(file_, record.footprint[i].y);
+
+  ok = ok && readValue(file_, record.size_x) && readValue(file_, record.size_y)
+      && readValue(file_, record.resolution) && readValue(file_, record.origin_x)
+      && readValue(file_, record.origin_y) && readVector(file_, record.costs)
+      && record.costs.size() == record.size_x * record.size_y;
+
+  LatticePlan& plan = record.plan;
+  ok = ok && readValue(file_, plan.primitive) && readValue(file_, plan.steering) && readValue(file_, plan.fast)
+      && readValue(file_, plan.switch_map) && readValue(file_, plan.warm_started) && readValue(file_, plan.goal_x)
+      && readValue(file_, plan.goal_y) && readValue(file_, plan.timings.rollout)
+      && readValue(file_, plan.timings.scoring) && readValue(file_, plan.timings.selection)
+      && readValue(file_, plan.timings.switch_map) && readValue(file_, plan.timings.total);
+  return ok;
+}
+
+}  // namespace costmap_2d
@@ -0,0 +1,151 @@
+#include <costmap_2d/primitive_cache.h>
+#include <algorithm>
+#include <cmath>
+
+namespace costmap_2d
+{
+
+PrimitiveCache::PrimitiveCache() :
+    num_speed_buckets_(0), num_steering_buckets_(0), bucket_size_(0), speed_resolution_(1.0),
+    steering_resolution_(1.0), min_steering_(0.0)
+{
+}
+
+const size_t PrimitiveCache::MAX_CACHE_SIZE;
+
+bool PrimitiveCache::build(const MotionPrimitiveSet& set, const std::vector<double>& engine_levels, double max_speed,
+                           double speed_resolution, double steering_resolution)
+{
+  x_.clear();
+  y_.clear();
+  theta_.clear();
+  if (set.size() == 0 || set.getNumSteps() == 0 || engine_levels.empty() || !(speed_resolution > 0.0)
+      || !(steering_resolution > 0.0))
+    return false;
+
+  // the current steering angle always lies between the outermost targets
+  const std::vector<double>& targets = set.getSteeringTargets();
+  double min_target = *std::min_element(targets.begin(), targets.end());
+  double max_target = *std::max_element(targets.begin(), targets.end());
+
+  // the bucket counts stay in double until they are known to fit, a fine resolution must not wrap them
+  double num_speed_buckets = floor(std::max(max_speed, 0.0) / speed_resolution) + 1;
+  double num_steering_buckets = ceil((max_target - min_target) / steering_resolution - 1e-9) + 1;
+  if (!(num_speed_buckets <= MAX_CACHE_SIZE) || !(num_steering_buckets <= MAX_CACHE_SIZE))
+    return false;
+  size_t factors[3] = {engine_levels.size(), (size_t)num_speed_buckets, (size_t)num_steering_buckets};
+  size_t cache_size = set.size() * set.getNumSteps();
+  for (unsigned int f = 0; f < 3; ++f)
+  {
+    if (cache_size > MAX_CACHE_SIZE / factors[f])
+      return false;
+    cache_size *= factors[f];
+  }
+
+  engine_levels_ = engine_levels;
+  speed_resolution_ = speed_resolution;
+  steering_resolution_ = steering_resolution;
+  num_speed_buckets_ = factors[1];
+  num_steering_buckets_ = factors[2];
+  min_steering_ = min_target;
+  bucket_size_ = set.size() * set.getNumSteps();
+  x_.resize(cache_size);
+  y_.resize(cache_size);
+  theta_.resize(cache_size);
+
+  MotionPrimitiveSet scratch = set;
+  std::vector<double> u_engine(set.getNumSteps()), u_break(set.getNumSteps(), 0.0);
+  for (unsigned int e = 0; e < engine_levels_.size(); ++e)
+  {
+    std::fill(u_engine.begin(), u_engine.end(), engine_levels_[e]);
+    for (unsigned int b = 0; b < num_speed_buckets_; ++b)
+    {
+      double start_state[4] = {0.0, 0.0, 0.0, b * speed_resolution_};
+      for (unsigned int k = 0; k < num_steering_buckets_; ++k)
+      {
+        scratch.rollout(start_state, min_steering_ + k * steering_resolution_, &u_engine[0], &u_break[0]);
+
+        unsigned int offset = getBucketOffset(e, b, k);
+        std::copy(scratch.x_.begin(), scratch.x_.end(), x_.begin() + offset);
+        std::copy(scratch.y_.begin(), scratch.y_.end(), y_.begin() + offset);
+        std::copy(scratch.theta_.begin(), scratch.theta_.end(), theta_.begin() + offset);
+      }
+    }
+  }
+  return true;
+}
+
+bool PrimitiveCache::transform(const double* start_state, double steering_current, double u_engine,
+                               MotionPrimitiveSet& set) const
+{
+  if (!isBuilt() || set.size() * set.getNumSteps() != bucket_size_)
+    return false;
+
+  unsigned int e = 0;
+  while (e < engine_levels_.size() && fabs(engine_levels_[e] - u_engine) > 1e-9)
+    ++e;
+  if (e == engine_levels_.size())
+    return false;
+
+  double speed_bucket = start_state[3] / speed_resolution_;
+  if (speed_bucket < 0.0 || speed_bucket > num_speed_buckets_ - 1)
+    return false;
+  double steering_bucket = (steering_current - min_steering_) / steering_resolution_;
+  if (steering_bucket < -1e-9 || steering_bucket > num_steering_buckets_ - 1 + 1e-9)
+    return false;
+  steering_bucket = std::min(std::max(steering_bucket, 0.0), num_steering_buckets_ - 1.0);
+
+  // bilinear weights of the four neighbouring buckets
+  unsigned int b0 = (unsigned int)speed_bucket;
+  unsigned int b1 = std::min(b0 + 1, num_speed_buckets_ - 1);
+  unsigned int k0 = (unsigned int)steering_bucket;
+  unsigned int k1 = std::min(k0 + 1, num_steering_buckets_ - 1);
+  double wb = speed_bucket - b0, wk = steering_bucket - k0;
+  const unsigned int offsets[4] = {getBucketOffset(e, b0, k0), getBucketOffset(e, b0, k1),
+                                   getBucketOffset(e, b1, k0), getBucketOffset(e, b1, k1)};
+  const float weights[4] = {(float)((1 - wb) * (1 - wk)), (float)((1 - wb) * wk), (float)(wb * (1 - wk)),
+                            (float)(wb * wk)};
+
+  double cos_theta = cos(start_state[2]), sin_theta = sin(start_state[2]);
+  double* __restrict__ x = &set.x_[0];
+  double* __restrict__ y = &set.y_[0];
+  double* __restrict__ theta = &set.theta_[0];
+
+#pragma omp simd
+  for (unsigned int index = 0; index < bucket_size_; ++index)
+  {
+    float bx = 0.0f, by = 0.0f, bth = 0.0f;
+    for (unsigned int n = 0; n < 4; ++n)
+    {
+      bx += weights[n] * x_[offsets[n] + index];
+      by += weights[n] * y_[offsets[n] + index];
+      bth += weights[n] * theta_[offsets[n] + index];
+    }
+    x[index] = start_state[0] + cos_theta * bx - sin_theta * by;
+    y[index] = start_state[1] + sin_theta * bx + cos_theta * by;
+    theta[index] = start_state[2] + bth;
+  }
+
+  // the speed does not depend on the steering and the profiles only on the exact current
+  // angle, so both are recomputed instead of being looked up
+  const VehicleModel& model = set.getVehicleModel();
+  double drag_factor = 0.5 * model.front_area * model.drag_coefficient * model.air_density / model.mass;
+  unsigned int num_targets = set.getSteeringTargets().size();
+  for (unsigned int a = 0; a < set.getAccelerations().size(); ++a)
+  {
+    double accel = u_engine + set.getAccelerations()[a];
+    double v = start_state[3];
+    for (unsigned int i = 0; i < set.getNumSteps(); ++i)
+    {
+      v = std::max(v + set.getTimeStep() * (accel - drag_factor * v * v), 0.0);
+      double* lanes = &set.v_[set.getIndex(set.getPrimitive(0, a), i)];
+      std::fill(lanes, lanes + num_targets, v);
+    }
+  }
+  for (unsigned int p = 0; p < set.size(); ++p)
+    set.fillSteeringProfile(steering_current, set.getSteeringTarget(p), &set.u_[p], set.size());
+
+  return true;
+}
+
+}  // namespace costmap_2d
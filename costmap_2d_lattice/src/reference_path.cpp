@@ -0,0 +1,238 @@
+#include <costmap_2d/reference_path.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <limits>
+
+namespace costmap_2d
+{
+
+ReferencePath::ReferencePath() :
+    length_(0.0), closed_(false), grid_origin_x_(0.0), grid_origin_y_(0.0), grid_resolution_(1.0), grid_size_x_(0),
+    grid_size_y_(0)
+{
+}
+
+bool ReferencePath::load(const std::string& filename, double closing_distance)
+{
+  std::ifstream file(filename.c_str());
+  if (!file)
+    return false;
+
+  std::vector<double> x, y;
+  std::string line;
+  while (std::getline(file, line))
+  {
+    double px, py;
+    if (sscanf(line.c_str(), "%lf,%lf", &px, &py) == 2)
+    {
+      x.push_back(px);
+      y.push_back(py);
+    }
+  }
+  if (x.size() < 2)
+    return false;
+
+  setPoints(x, y, hypot(x.back() - x.front(), y.back() - y.front()) <= closing_distance);
+  return true;
+}
+
+void ReferencePath::setPoints(const std::vector<double>& x, const std::vector<double>& y, bool closed)
+{
+  x_ = x;
+  y_ = y;
+  closed_ = closed && x_.size() > 2;
+  s_.assign(x_.size(), 0.0);
+  for (unsigned int i = 1; i < x_.size(); ++i)
+    s_[i] = s_[i - 1] + hypot(x_[i] - x_[i - 1], y_[i] - y_[i - 1]);
+  length_ = s_.empty() ? 0.0 : s_.back();
+  if (closed_)
+    length_ += hypot(x_.front() - x_.back(), y_.front() - y_.back());
+
+  cell_begin_.clear();
+  cell_segments_.clear();
+  grid_size_x_ = grid_size_y_ = 0;
+  if (x_.size() < 2)
+    return;
+
+  double min_x = *std::min_element(x_.begin(), x_.end()), max_x = *std::max_element(x_.begin(), x_.end());
+  double min_y = *std::min_element(y_.begin(), y_.end()), max_y = *std::max_element(y_.begin(), y_.end());
+
+  // cells of about two segments keep the lists short, the cap keeps the grid small for sparse paths
+  grid_resolution_ = std::max(2.0 * length_ / numSegments(), 1e-3);
+  while ((max_x - min_x) / grid_resolution_ * (max_y - min_y) / grid_resolution_ > 1e6)
+    grid_resolution_ *= 2.0;
+  grid_origin_x_ = min_x;
+  grid_origin_y_ = min_y;
+  grid_size_x_ = (int)((max_x - min_x) / grid_resolution_) + 1;
+  grid_size_y_ = (int)((max_y - min_y) / grid_resolution_) + 1;
+
+  // two passes over the segments, counting and then filling every cell their bounding box touches
+  cell_begin_.assign(grid_size_x_ * grid_size_y_ + 1, 0);
+  for (unsigned int pass = 0; pass < 2; ++pass)
+  {
+    std::vector<unsigned int> fill;
+    if (pass == 1)
+    {
+      for (unsigned int c = 1; c < cell_begin_.size(); ++c)
+        cell_begin_[c] += cell_begin_[c - 1];
+      cell_segments_.resize(cell_begin_.back());
+      fill.assign(cell_begin_.begin(), cell_begin_.end() - 1);
+    }
+
+    for (unsigned int k = 0; k < numSegments(); ++k)
+    {
+      unsigned int next = (k + 1) % x_.size();
+      int i0 = (int)((std::min(x_[k], x_[next]) - grid_origin_x_) / grid_resolution_);
+      int i1 = (int)((std::max(x_[k], x_[next]) - grid_origin_x_) / grid_resolution_);
+      int j0 = (int)((std::min(y_[k], y_[next]) - grid_origin_y_) / grid_resolution_);
+      int j1 = (int)((std::max(y_[k], y_[next]) - grid_origin_y_) / grid_resolution_);
+      for (int j = j0; j <= j1; ++j)
+      {
+        for (int i = i0; i <= i1; ++i)
+        {
+          unsigned int cell = j * grid_size_x_ + i;
+          if (pass == 0)
+            ++cell_begin_[cell + 1];
+          else
+            cell_segments_[fill[cell]++] = k;
+        }
+      }
+    }
+  }
+}
+
+double ReferencePath::projectOnSegment(unsigned int segment, double x, double y, double& s) const
+{
+  unsigned int next = (segment + 1) % x_.size();
+  double dx = x_[next] - x_[segment], dy = y_[next] - y_[segment];
+  double length_sq = dx * dx + dy * dy;
+  double t = 0.0;
+  if (length_sq > 0.0)
+    t = std::min(std::max(((x - x_[segment]) * dx + (y - y_[segment]) * dy) / length_sq, 0.0), 1.0);
+  s = s_[segment] + t * sqrt(length_sq);
+  double ex = x_[segment] + t * dx - x, ey = y_[segment] + t * dy - y;
+  return ex * ex + ey * ey;
+}
+
+bool ReferencePath::project(double x, double y, double& s, double& distance) const
+{
+  if (cell_begin_.empty())
+    return false;
+
+  // the cell of the query, which may lie outside of the grid
+  int cx = (int)floor((x - grid_origin_x_) / grid_resolution_);
+  int cy = (int)floor((y - grid_origin_y_) / grid_resolution_);
+  int max_ring = std::max(std::max(abs(cx), abs(cx - (grid_size_x_ - 1))),
+                          std::max(abs(cy), abs(cy - (grid_size_y_ - 1))));
+
+  // visit the cells ring by ring around the query, every cell of ring r + 1 is at least r cells away
+  double best = std::numeric_limits<double>::max();
+  for (int r = 0; r <= max_ring; ++r)
+  {
+    for (int j = cy - r; j <= cy + r; ++j)
+    {
+      if (j < 0 || j >= grid_size_y_)
+        continue;
+      int step = (j == cy - r || j == cy + r) ? 1 : std::max(2 * r, 1);
+      for (int i = cx - r; i <= cx + r; i += step)
+      {
+        if (i < 0 || i >= grid_size_x_)
+          continue;
+        unsigned int cell = j * grid_size_x_ + i;
+        for (unsigned int c = cell_begin_[cell]; c < cell_begin_[cell + 1]; ++c)
+        {
+          double segment_s;
+          double d = projectOnSegment(cell_segments_[c], x, y, segment_s);
+          if (d < best)
+          {
+            best = d;
+            s = segment_s;
+          }
+        }
+      }
+    }
+    if (best != std::numeric_limits<double>::max() && sqrt(best) <= r * grid_resolution_)
+      break;
+  }
+
+  distance = sqrt(best);
+  return true;
+}
+
+bool ReferencePath::projectFrom(double s_start, double x, double y, double& s, double& distance) const
+{
+  if (x_.size() < 2)
+    return false;
+
+  // forward while the next segment comes closer, then backward from the start segment; only one of
+  // the two walks gets past its first step unless the path bends back to the query
+  int num_segments = numSegments();
+  int start = segmentAt(s_start);
+  double best = projectOnSegment(start, x, y, s);
+  for (int direction = 1; direction >= -1; direction -= 2)
+  {
+    int k = start;
+    for (int n = 1; n < num_segments; ++n)
+    {
+      k += direction;
+      if (closed_)
+        k = (k + num_segments) % num_segments;
+      else if (k < 0 || k >= num_segments)
+        break;
+      double segment_s;
+      double d = projectOnSegment(k, x, y, segment_s);
+      if (d > best)
+        break;
+      if (d < best)
+      {
+        best = d;
+        s = segment_s;
+      }
+    }
+  }
+  distance = sqrt(best);
+  return true;
+}
+
+unsigned int ReferencePath::segmentAt(double& s) const
+{
+  if (closed_ && length_ > 0.0)
+  {
+    s = fmod(s, length_);
+    if (s < 0.0)
+      s += length_;
+  }
+  else
+  {
+    s = std::min(std::max(s, 0.0), s_.back());
+  }
+
+  unsigned int k = std::upper_bound(s_.begin(), s_.end(), s) - s_.begin() - 1;
+  if (!closed_ && k == x_.size() - 1)
+    k = x_.size() - 2;
+  return k;
+}
+
+bool ReferencePath::pointAt(double s, double& x, double& y) const
+{
+  if (x_.empty())
+    return false;
+  if (x_.size() == 1)
+  {
+    x = x_[0];
+    y = y_[0];
+    return true;
+  }
+
+  unsigned int k = segmentAt(s);
+  unsigned int next = (k + 1) % x_.size();
+  double segment_length = (next == 0 ? length_ : s_[next]) - s_[k];
+  double t = segment_length > 0.0 ? (s - s_[k]) / segment_length : 0.0;
+  x = x_[k] + t * (x_[next] - x_[k]);
+  y = y_[k] + t * (y_[next] - y_[k]);
+  return true;
+}
+
+}  // namespace costmap_2d
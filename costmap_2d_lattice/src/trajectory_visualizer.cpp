@@ -0,0 +1,190 @@
+#include <costmap_2d/trajectory_visualizer.h>
+#include <algorithm>
+#ifdef __linux__
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace costmap_2d
+{
+
+namespace
+{
+enum MarkerIndex
+{
+  ALL_PRIMITIVES, SELECTED, SELECTED_TRAIL, INPUT_TRAIL, GLOBAL_GOAL, NUM_MARKERS
+};
+
+// the trail markers take the ids from 10 and from 510 on, as the planner node always did
+const int TRAIL_ID = 10, INPUT_TRAIL_ID = 510;
+
+void setupMarker(visualization_msgs::Marker& marker, const std::string& frame_id, const std::string& ns, int id,
+                 double scale, float r, float g, float b)
+{
+  marker.header.frame_id = frame_id;
+  marker.ns = ns;
+  marker.id = id;
+  marker.type = visualization_msgs::Marker::POINTS;
+  marker.action = visualization_msgs::Marker::ADD;
+  marker.pose.orientation.w = 1.0;
+  // POINTS markers use x and y scale for width/height respectively
+  marker.scale.x = scale;
+  marker.scale.y = scale;
+  marker.color.r = r;
+  marker.color.g = g;
+  marker.color.b = b;
+  marker.color.a = 1.0;
+  marker.lifetime = ros::Duration(0.0);
+}
+
+void setPoint(geometry_msgs::Point& point, double x, double y)
+{
+  point.x = x;
+  point.y = y;
+  point.z = 0.0;
+}
+}  // namespace
+
+TrajectoryVisualizer::TrajectoryVisualizer(ros::NodeHandle& nh, const std::string& topic,
+                                           const std::string& frame_id, double rate, unsigned int queue_size,
+                                           unsigned int history_size) :
+    period_(rate > 0.0 ? 1.0 / rate : 0.0), history_size_(std::min(std::max(history_size, 1u), 500u)),
+    history_index_(0), frames_(std::max(queue_size, 1u)), first_frame_(0), num_frames_(0), num_dropped_(0),
+    shutdown_(false), thread_(NULL)
+{
+  if (rate <= 0.0)
+    return;
+  publisher_ = nh.advertise<visualization_msgs::MarkerArray>(topic, 1);
+
+  markers_.markers.resize(NUM_MARKERS);
+  setupMarker(markers_.markers[ALL_PRIMITIVES], frame_id, "points", 0, 0.2, 0.0, 0.0, 1.0);
+  setupMarker(markers_.markers[SELECTED], frame_id, "points_corrected", 1, 0.2, 0.0, 1.0, 0.0);
+  setupMarker(markers_.markers[SELECTED_TRAIL], frame_id, "points_corrected_global", TRAIL_ID, 0.2, 1.0, 0.0, 0.0);
+  setupMarker(markers_.markers[INPUT_TRAIL], frame_id, "points_line", INPUT_TRAIL_ID, 0.2, 0.5, 0.0, 0.0);
+  setupMarker(markers_.markers[GLOBAL_GOAL], frame_id, "points_line_debug", 4, 0.5, 0.0, 0.5, 0.0);
+  markers_.markers[INPUT_TRAIL].points.resize(1);
+  markers_.markers[GLOBAL_GOAL].points.resize(1);
+
+  thread_ = new boost::thread(boost::bind(&TrajectoryVisualizer::publishLoop, this));
+}
+
+TrajectoryVisualizer::~TrajectoryVisualizer()
+{
+  if (!thread_)
+    return;
+  {
+    boost::unique_lock<boost::mutex> lock(mutex_);
+    shutdown_ = true;
+  }
+  frame_cond_.notify_one();
+  thread_->join();
+  delete thread_;
+  if (num_dropped_ > 0)
+    ROS_DEBUG("lattice: %u visualization frames dropped on a full queue", num_dropped_);
+}
+
+bool TrajectoryVisualizer::push(const MotionPrimitiveSet& set, unsigned int selected, double goal_x, double goal_y)
+{
+  if (!thread_ || publisher_.getNumSubscribers() == 0)
+    return false;
+  ros::Time now = ros::Time::now();
+  if (now - last_push_ < period_)
+    return false;
+
+  boost::unique_lock<boost::mutex> lock(mutex_);
+  if (num_frames_ == frames_.size())
+  {
+    ++num_dropped_;
+    return false;
+  }
+  // the slot is not read by the publisher thread until it is counted in num_frames_
+  Frame& frame = frames_[(first_frame_ + num_frames_) % frames_.size()];
+  lock.unlock();
+
+  frame.stamp = now;
+  frame.num_primitives = set.size();
+  frame.num_steps = set.getNumSteps();
+  frame.selected = selected;
+  frame.goal_x = goal_x;
+  frame.goal_y = goal_y;
+  frame.x.resize(set.size() * set.getNumSteps());
+  frame.y.resize(set.size() * set.getNumSteps());
+  for (unsigned int i = 0; i < set.getNumSteps(); ++i)
+  {
+    for (unsigned int p = 0; p < set.size(); ++p)
+    {
+      frame.x[set.getIndex(p, i)] = set.x(p, i);
+      frame.y[set.getIndex(p, i)] = set.y(p, i);
+    }
+  }
+  last_push_ = now;
+
+  lock.lock();
+  ++num_frames_;
+  lock.unlock();
+  frame_cond_.notify_one();
+  return true;
+}
+
+void TrajectoryVisualizer::publishLoop()
+{
+#ifdef __linux__
+  // markers are nice to have, the planner threads go first when the cores are busy
+  setpriority(PRIO_PROCESS, syscall(SYS_gettid), 19);
+#endif
+  boost::unique_lock<boost::mutex> lock(mutex_);
+  while (true)
+  {
+    while (!shutdown_ && num_frames_ == 0)
+      frame_cond_.wait(lock);
+    if (shutdown_)
+      return;
+
+    // the planner does not write to the oldest frame while it is counted, so it is read unlocked
+    const Frame& frame = frames_[first_frame_];
+    lock.unlock();
+    fillMarkers(frame);
+    lock.lock();
+    first_frame_ = (first_frame_ + 1) % frames_.size();
+    --num_frames_;
+
+    lock.unlock();
+    publisher_.publish(markers_);
+    lock.lock();
+  }
+}
+
+void TrajectoryVisualizer::fillMarkers(const Frame& frame)
+{
+  for (unsigned int m = 0; m < NUM_MARKERS; ++m)
+    markers_.markers[m].header.stamp = frame.stamp;
+
+  // the point buffers keep their capacity, so only the first frame allocates
+  std::vector<geometry_msgs::Point>& all = markers_.markers[ALL_PRIMITIVES].points;
+  all.resize(frame.x.size());
+  for (unsigned int k = 0; k < frame.x.size(); ++k)
+    setPoint(all[k], frame.x[k], frame.y[k]);
+
+  std::vector<geometry_msgs::Point>& selected = markers_.markers[SELECTED].points;
+  std::vector<geometry_msgs::Point>& trail = markers_.markers[SELECTED_TRAIL].points;
+  selected.resize(frame.num_steps);
+  trail.resize(frame.num_steps / 3);
+  for (unsigned int i = 0; i < frame.num_steps; ++i)
+  {
+    unsigned int index = i * frame.num_primitives + frame.selected;
+    setPoint(selected[i], frame.x[index], frame.y[index]);
+    if (i < trail.size())
+      trail[i] = selected[i];
+  }
+
+  // the trail overwrites its oldest markers once history_size of them are shown
+  markers_.markers[SELECTED_TRAIL].id = TRAIL_ID + history_index_;
+  markers_.markers[INPUT_TRAIL].id = INPUT_TRAIL_ID + history_index_;
+  history_index_ = (history_index_ + 1) % history_size_;
+  unsigned int input_step = std::min(4u, frame.num_steps - 1);
+  markers_.markers[INPUT_TRAIL].points[0] = selected[input_step];
+  setPoint(markers_.markers[GLOBAL_GOAL].points[0], frame.goal_x, frame.goal_y);
+}
+
+}  // namespace costmap_2d
@@ -0,0 +1,83 @@
+#include <costmap_2d/worker_pool.h>
+
+namespace costmap_2d
+{
+
+WorkerPool::WorkerPool(unsigned int num_threads) :
+    task_(NULL), num_tasks_(0), next_task_(0), unfinished_tasks_(0), batch_(0), shutdown_(false)
+{
+  for (unsigned int t = 0; t < num_threads; ++t)
+    threads_.push_back(new boost::thread(boost::bind(&WorkerPool::workerLoop, this)));
+}
+
+WorkerPool::~WorkerPool()
+{
+  {
+    boost::unique_lock<boost::mutex> lock(mutex_);
+    shutdown_ = true;
+  }
+  work_cond_.notify_all();
+  for (unsigned int t = 0; t < threads_.size(); ++t)
+  {
+    threads_[t]->join();
+    delete threads_[t];
+  }
+}
+
+void WorkerPool::run(unsigned int num_tasks, const boost::function<void(unsigned int)>& task)
+{
+  if (num_tasks == 0)
+    return;
+
+  {
+    boost::unique_lock<boost::mutex> lock(mutex_);
+    task_ = &task;
+    num_tasks_ = num_tasks;
+    next_task_ = 0;
+    unfinished_tasks_ = num_tasks;
+    ++batch_;
+  }
+  work_cond_.notify_all();
+
+  // the caller works on the batch as well instead of idling until it is done
+  runPendingTasks();
+
+  boost::unique_lock<boost::mutex> lock(mutex_);
+  while (unfinished_tasks_ > 0)
+    done_cond_.wait(lock);
+  task_ = NULL;
+}
+
+void WorkerPool::workerLoop()
+{
+  unsigned long last_batch = 0;
+  while (true)
+  {
+    {
+      boost::unique_lock<boost::mutex> lock(mutex_);
+      while (!shutdown_ && batch_ == last_batch)
+        work_cond_.wait(lock);
+      if (shutdown_)
+        return;
+      last_batch = batch_;
+    }
+    runPendingTasks();
+  }
+}
+
+void WorkerPool::runPendingTasks()
+{
+  boost::unique_lock<boost::mutex> lock(mutex_);
+  while (next_task_ < num_tasks_)
+  {
+    unsigned int index = next_task_++;
+    const boost::function<void(unsigned int)>& task = *task_;
+    lock.unlock();
+    task(index);
+    lock.lock();
+    if (--unfinished_tasks_ == 0)
+      done_cond_.notify_all();
+  }
+}
+
+}  // namespace costmap_2d
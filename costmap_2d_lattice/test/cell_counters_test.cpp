@@ -0,0 +1,118 @@
+#include <gtest/gtest.h>
+#include <costmap_2d/cell_counters.h>
+#include <costmap_2d/cost_values.h>
+#include <cstdlib>
+
+using namespace costmap_2d;
+
+namespace
+{
+
+void fillRandom(Costmap2D& map, unsigned int x0, unsigned int y0, unsigned int xn, unsigned int yn)
+{
+  const unsigned char values[4] = {FREE_SPACE, LETHAL_OBSTACLE, NO_INFORMATION, 100};
+  for (unsigned int my = y0; my < yn; ++my)
+  {
+    for (unsigned int mx = x0; mx < xn; ++mx)
+      map.setCost(mx, my, values[rand() % 4]);
+  }
+}
+
+// compare every row and column against a count over the cells
+void expectCounts(const Costmap2D& map, const CellCounters& counters)
+{
+  ASSERT_TRUE(counters.isValid());
+  ASSERT_EQ(counters.getSizeInCellsX(), map.getSizeInCellsX());
+  ASSERT_EQ(counters.getSizeInCellsY(), map.getSizeInCellsY());
+  for (unsigned int mx = 0; mx < map.getSizeInCellsX(); ++mx)
+  {
+    unsigned int num_free = 0, num_lethal = 0;
+    for (unsigned int my = 0; my < map.getSizeInCellsY(); ++my)
+    {
+      num_free += map.getCost(mx, my) == FREE_SPACE;
+      num_lethal += map.getCost(mx, my) == LETHAL_OBSTACLE;
+    }
+    EXPECT_EQ(counters.getFreeInColumn(mx), num_free) << "column " << mx;
+    EXPECT_EQ(counters.getLethalInColumn(mx), num_lethal) << "column " << mx;
+  }
+  for (unsigned int my = 0; my < map.getSizeInCellsY(); ++my)
+  {
+    unsigned int num_free = 0, num_lethal = 0;
+    for (unsigned int mx = 0; mx < map.getSizeInCellsX(); ++mx)
+    {
+      num_free += map.getCost(mx, my) == FREE_SPACE;
+      num_lethal += map.getCost(mx, my) == LETHAL_OBSTACLE;
+    }
+    EXPECT_EQ(counters.getFreeInRow(my), num_free) << "row " << my;
+    EXPECT_EQ(counters.getLethalInRow(my), num_lethal) << "row " << my;
+  }
+}
+
+}  // namespace
+
+TEST(CellCounters, rebuild_test)
+{
+  srand(1);
+  Costmap2D map(37, 23, 0.5, 0.0, 0.0);
+  fillRandom(map, 0, 0, 37, 23);
+  CellCounters counters;
+  EXPECT_FALSE(counters.isValid());
+  counters.rebuild(map);
+  expectCounts(map, counters);
+}
+
+TEST(CellCounters, window_update_test)
+{
+  srand(2);
+  Costmap2D map(40, 30, 0.5, 0.0, 0.0);
+  fillRandom(map, 0, 0, 40, 30);
+  CellCounters counters;
+  counters.rebuild(map);
+  for (int k = 0; k < 50; ++k)
+  {
+    unsigned int x0 = rand() % 40, y0 = rand() % 30;
+    unsigned int xn = x0 + rand() % (41 - x0), yn = y0 + rand() % (31 - y0);
+    counters.remove(map, x0, y0, xn, yn);
+    fillRandom(map, x0, y0, xn, yn);
+    counters.add(map, x0, y0, xn, yn);
+  }
+  expectCounts(map, counters);
+
+  // a map of another size makes the counters stale
+  Costmap2D other(10, 10, 0.5, 0.0, 0.0);
+  counters.add(other, 0, 0, 10, 10);
+  EXPECT_FALSE(counters.isValid());
+}
+
+TEST(CellCounters, shift_test)
+{
+  srand(3);
+  // the shifts of the rolling window, with the default value FREE_SPACE and NO_INFORMATION
+  const int shifts[8][2] = {{3, 0}, {0, -2}, {-5, 4}, {7, 7}, {-1, -1}, {0, 0}, {39, 0}, {-12, 25}};
+  for (int d = 0; d < 2; ++d)
+  {
+    Costmap2D map(40, 30, 0.5, 0.0, 0.0, d == 0 ? FREE_SPACE : NO_INFORMATION);
+    fillRandom(map, 0, 0, 40, 30);
+    CellCounters counters;
+    counters.rebuild(map);
+    for (int k = 0; k < 8; ++k)
+    {
+      // updateOrigin() truncates the shift towards zero
+      double new_origin_x = map.getOriginX() + (shifts[k][0] + (shifts[k][0] < 0 ? -0.25 : 0.25)) * 0.5;
+      double new_origin_y = map.getOriginY() + (shifts[k][1] + (shifts[k][1] < 0 ? -0.25 : 0.25)) * 0.5;
+      counters.shift(map, shifts[k][0], shifts[k][1]);
+      map.updateOrigin(new_origin_x, new_origin_y);
+      expectCounts(map, counters);
+    }
+
+    // a shift past the whole map drops all cells, the counters have to be rebuilt
+    counters.shift(map, 40, 0);
+    EXPECT_FALSE(counters.isValid());
+  }
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -124,6 +124,36 @@ TEST(CostmapCoordinates, hard_coordinates_test)
   EXPECT_EQ(my, 2);
 }
 
+TEST(CostmapCoordinates, origin_shift_test)
+{
+  // every cell keeps its world position when the window moves, cells from outside get the default value
+  const int shifts[9][2] = {{3, 0}, {0, -2}, {-5, 4}, {7, 7}, {-1, -1}, {0, 0}, {-6, 10}, {20, 0}, {2, -30}};
+  Costmap2D costmap(12, 9, 0.5, 1.0, -2.0, 7);
+  for (unsigned int j = 0; j < 9; ++j)
+  {
+    for (unsigned int i = 0; i < 12; ++i)
+      costmap.setCost(i, j, i * 9 + j);
+  }
+  for (int k = 0; k < 9; ++k)
+  {
+    Costmap2D before(costmap);
+    // updateOrigin() truncates the shift towards zero
+    costmap.updateOrigin(costmap.getOriginX() + (shifts[k][0] + (shifts[k][0] < 0 ? -0.25 : 0.25)) * 0.5,
+                         costmap.getOriginY() + (shifts[k][1] + (shifts[k][1] < 0 ? -0.25 : 0.25)) * 0.5);
+    EXPECT_DOUBLE_EQ(costmap.getOriginX(), before.getOriginX() + shifts[k][0] * 0.5);
+    EXPECT_DOUBLE_EQ(costmap.getOriginY(), before.getOriginY() + shifts[k][1] * 0.5);
+    for (int j = 0; j < 9; ++j)
+    {
+      for (int i = 0; i < 12; ++i)
+      {
+        int old_i = i + shifts[k][0], old_j = j + shifts[k][1];
+        bool inside = old_i >= 0 && old_i < 12 && old_j >= 0 && old_j < 9;
+        EXPECT_EQ(costmap.getCost(i, j), inside ? before.getCost(old_i, old_j) : 7) << "shift " << k;
+      }
+    }
+  }
+}
+
 int main(int argc, char** argv)
 {
   testing::InitGoogleTest( &argc, argv );
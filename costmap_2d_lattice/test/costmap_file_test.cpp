@@ -0,0 +1,106 @@
+#include <gtest/gtest.h>
+#include <costmap_2d/costmap_2d.h>
+#include <costmap_2d/cost_values.h>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+using namespace costmap_2d;
+
+namespace
+{
+
+void fillRandom(Costmap2D& map)
+{
+  for (unsigned int my = 0; my < map.getSizeInCellsY(); ++my)
+  {
+    for (unsigned int mx = 0; mx < map.getSizeInCellsX(); ++mx)
+      map.setCost(mx, my, rand() % 256);
+  }
+}
+
+void expectSameMap(const Costmap2D& a, const Costmap2D& b)
+{
+  ASSERT_EQ(a.getSizeInCellsX(), b.getSizeInCellsX());
+  ASSERT_EQ(a.getSizeInCellsY(), b.getSizeInCellsY());
+  EXPECT_EQ(a.getResolution(), b.getResolution());
+  EXPECT_EQ(a.getOriginX(), b.getOriginX());
+  EXPECT_EQ(a.getOriginY(), b.getOriginY());
+  EXPECT_EQ(0, memcmp(a.getCharMap(), b.getCharMap(), a.getSizeInCellsX() * a.getSizeInCellsY()));
+}
+
+}  // namespace
+
+TEST(CostmapFile, binary_round_trip_test)
+{
+  Costmap2D map(37, 23, 0.05, -1.25, 2.5, NO_INFORMATION);
+  fillRandom(map);
+  ASSERT_TRUE(map.saveBinaryMap("costmap_file_test.costmap"));
+
+  Costmap2D loaded(3, 3, 1.0, 0.0, 0.0);
+  ASSERT_TRUE(loaded.loadBinaryMap("costmap_file_test.costmap"));
+  expectSameMap(map, loaded);
+  EXPECT_EQ(loaded.getDefaultValue(), NO_INFORMATION);
+  EXPECT_FALSE(loaded.isMapped());
+
+  // the pgm dump is no costmap file, and a failed load leaves the map as it was
+  ASSERT_TRUE(map.saveMap("costmap_file_test.pgm"));
+  EXPECT_FALSE(loaded.loadBinaryMap("costmap_file_test.pgm"));
+  EXPECT_FALSE(loaded.loadBinaryMap("costmap_file_test.missing"));
+  expectSameMap(map, loaded);
+
+  remove("costmap_file_test.costmap");
+  remove("costmap_file_test.pgm");
+}
+
+TEST(CostmapFile, mapped_test)
+{
+  Costmap2D map(64, 48, 0.1, 3.0, -4.0);
+  fillRandom(map);
+  ASSERT_TRUE(map.saveBinaryMap("costmap_file_test.costmap"));
+
+  {
+    Costmap2D mapped(std::string("costmap_file_test.costmap"));
+    ASSERT_TRUE(mapped.isMapped());
+    expectSameMap(map, mapped);
+
+    // a cell set in the mapped map is not written to the file
+    unsigned char cost = mapped.getCost(5, 7);
+    mapped.setCost(5, 7, cost + 1);
+    EXPECT_EQ(mapped.getCost(5, 7), (unsigned char)(cost + 1));
+    Costmap2D reloaded(std::string("costmap_file_test.costmap"));
+    expectSameMap(map, reloaded);
+
+    // after a resize the cells are allocated as usual
+    mapped.resizeMap(10, 10, 0.1, 0.0, 0.0);
+    EXPECT_FALSE(mapped.isMapped());
+  }
+
+  Costmap2D missing(std::string("costmap_file_test.missing"));
+  EXPECT_FALSE(missing.isMapped());
+  EXPECT_EQ(missing.getSizeInCellsX(), 0u);
+
+  remove("costmap_file_test.costmap");
+}
+
+TEST(CostmapFile, pgm_test)
+{
+  Costmap2D map(3, 2, 0.1, 0.0, 0.0);
+  const unsigned char costs[6] = {0, 7, 42, 100, 254, 255};
+  for (unsigned int k = 0; k < 6; ++k)
+    map.setCost(k % 3, k / 3, costs[k]);
+  ASSERT_TRUE(map.saveMap("costmap_file_test.pgm"));
+
+  std::ifstream file("costmap_file_test.pgm");
+  std::string contents((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+  EXPECT_EQ(contents, "P2\n3\n2\n255\n0 7 42 \n100 254 255 \n");
+  remove("costmap_file_test.pgm");
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
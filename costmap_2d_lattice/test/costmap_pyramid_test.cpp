@@ -0,0 +1,162 @@
+#include <gtest/gtest.h>
+#include <costmap_2d/costmap_pyramid.h>
+#include <costmap_2d/cost_values.h>
+#include <algorithm>
+#include <cstdlib>
+
+using namespace costmap_2d;
+
+namespace
+{
+
+// the highest cost of the cells in [x0, xn) x [y0, yn), clipped to the map
+unsigned char maxCost(const Costmap2D& map, int x0, int y0, int xn, int yn)
+{
+  unsigned char max_cost = 0;
+  for (int my = std::max(y0, 0); my < std::min(yn, (int)map.getSizeInCellsY()); ++my)
+  {
+    for (int mx = std::max(x0, 0); mx < std::min(xn, (int)map.getSizeInCellsX()); ++mx)
+      max_cost = std::max(max_cost, map.getCost(mx, my));
+  }
+  return max_cost;
+}
+
+// every block of every level against the cells it covers, block 0 starts the phase before cell 0
+void expectPooled(const Costmap2D& map, const CostmapPyramid& pyramid)
+{
+  ASSERT_TRUE(pyramid.isValid());
+  for (unsigned int level = 1; level <= pyramid.getNumLevels(); ++level)
+  {
+    int block = 1 << level;
+    int phase_x = pyramid.getPhaseX() % block, phase_y = pyramid.getPhaseY() % block;
+    ASSERT_EQ(pyramid.getSizeInBlocksX(level), (phase_x + map.getSizeInCellsX() + block - 1) / block);
+    ASSERT_EQ(pyramid.getSizeInBlocksY(level), (phase_y + map.getSizeInCellsY() + block - 1) / block);
+    for (int by = 0; by < (int)pyramid.getSizeInBlocksY(level); ++by)
+    {
+      for (int bx = 0; bx < (int)pyramid.getSizeInBlocksX(level); ++bx)
+      {
+        EXPECT_EQ(pyramid.getCost(level, bx, by), maxCost(map, bx * block - phase_x, by * block - phase_y,
+                                                          (bx + 1) * block - phase_x, (by + 1) * block - phase_y))
+            << "level " << level << " block " << bx << ", " << by;
+      }
+    }
+  }
+}
+
+void fillRandom(Costmap2D& map, unsigned int x0, unsigned int y0, unsigned int xn, unsigned int yn)
+{
+  for (unsigned int my = y0; my < yn; ++my)
+  {
+    for (unsigned int mx = x0; mx < xn; ++mx)
+      map.setCost(mx, my, rand() % 50 == 0 ? rand() % 256 : FREE_SPACE);
+  }
+}
+
+}  // namespace
+
+TEST(CostmapPyramid, rebuild_test)
+{
+  srand(3);
+  // odd sizes leave partial blocks at the far edges
+  Costmap2D map(45, 37, 0.1, 0.0, 0.0);
+  fillRandom(map, 0, 0, 45, 37);
+  CostmapPyramid pyramid;
+  EXPECT_FALSE(pyramid.isValid());
+  pyramid.setNumLevels(4);
+  pyramid.rebuild(map);
+  expectPooled(map, pyramid);
+  EXPECT_EQ(pyramid.getSizeInBlocksX(4), 3u);
+  EXPECT_EQ(pyramid.getSizeInBlocksY(4), 3u);
+}
+
+TEST(CostmapPyramid, update_test)
+{
+  srand(4);
+  Costmap2D map(64, 50, 0.1, 0.0, 0.0);
+  fillRandom(map, 0, 0, 64, 50);
+  CostmapPyramid pyramid;
+  pyramid.setNumLevels(3);
+  pyramid.rebuild(map);
+  // windows that cut through blocks, with costs that rise and fall
+  for (int k = 0; k < 50; ++k)
+  {
+    unsigned int x0 = rand() % 64, y0 = rand() % 50;
+    unsigned int xn = x0 + 1 + rand() % (64 - x0), yn = y0 + 1 + rand() % (50 - y0);
+    fillRandom(map, x0, y0, xn, yn);
+    pyramid.update(map, x0, y0, xn, yn);
+  }
+  expectPooled(map, pyramid);
+
+  // a map of another size is pooled from scratch
+  map.resizeMap(20, 30, 0.1, 0.0, 0.0);
+  fillRandom(map, 0, 0, 20, 30);
+  pyramid.update(map, 0, 0, 1, 1);
+  expectPooled(map, pyramid);
+}
+
+TEST(CostmapPyramid, shift_test)
+{
+  srand(6);
+  Costmap2D map(61, 47, 0.1, 0.0, 0.0);
+  fillRandom(map, 0, 0, 61, 47);
+  CostmapPyramid pyramid;
+  pyramid.setNumLevels(4);
+  pyramid.rebuild(map);
+  // rolling window moves of a few cells, which are no multiple of the blocks, and one jump across the map
+  for (int k = 0; k < 40; ++k)
+  {
+    int dx = rand() % 11 - 5, dy = rand() % 9 - 4;
+    if (k == 30)
+      dx = 70;
+    // half a cell further, so the origin rounds towards zero onto whole cells
+    map.updateOrigin(map.getOriginX() + (dx + (dx < 0 ? -0.5 : 0.5)) * map.getResolution(),
+                     map.getOriginY() + (dy + (dy < 0 ? -0.5 : 0.5)) * map.getResolution());
+    pyramid.shift(map, dx, dy);
+    expectPooled(map, pyramid);
+
+    // the cells that came in are written and pooled like in an update of the layers
+    unsigned int x0 = dx > 0 ? std::max(61 - dx, 0) : 0, xn = dx > 0 ? 61 : std::min(-dx, 61);
+    fillRandom(map, x0, 0, xn, 47);
+    pyramid.update(map, x0, 0, xn, 47);
+    unsigned int y0 = dy > 0 ? 47 - dy : 0, yn = dy > 0 ? 47 : -dy;
+    fillRandom(map, 0, y0, 61, yn);
+    pyramid.update(map, 0, y0, 61, yn);
+    expectPooled(map, pyramid);
+    EXPECT_GE(pyramid.getMaxCost(10, 10, 30, 30), maxCost(map, 10, 10, 30, 30));
+  }
+  EXPECT_TRUE(pyramid.getPhaseX() != 0 || pyramid.getPhaseY() != 0);
+}
+
+TEST(CostmapPyramid, max_cost_test)
+{
+  srand(5);
+  Costmap2D map(100, 80, 0.1, 0.0, 0.0);
+  fillRandom(map, 0, 0, 100, 80);
+  CostmapPyramid pyramid;
+  pyramid.setNumLevels(4);
+  pyramid.rebuild(map);
+  for (int k = 0; k < 2000; ++k)
+  {
+    int x0 = rand() % 120 - 10, y0 = rand() % 100 - 10;
+    int xn = x0 + 1 + rand() % 40, yn = y0 + 1 + rand() % 40;
+    EXPECT_GE(pyramid.getMaxCost(x0, y0, xn, yn), maxCost(map, x0, y0, xn, yn));
+  }
+  // whole blocks are exact, windows outside the map are free
+  EXPECT_EQ(pyramid.getMaxCost(32, 16, 48, 32), maxCost(map, 32, 16, 48, 32));
+  EXPECT_EQ(pyramid.getMaxCost(-20, 0, 0, 10), FREE_SPACE);
+  EXPECT_EQ(pyramid.getMaxCost(0, 80, 10, 90), FREE_SPACE);
+
+  // a free window stays free, a lethal cell is found from any window around it
+  Costmap2D free_map(100, 80, 0.1, 0.0, 0.0);
+  free_map.setCost(50, 40, LETHAL_OBSTACLE);
+  pyramid.rebuild(free_map);
+  EXPECT_EQ(pyramid.getMaxCost(0, 0, 30, 30), FREE_SPACE);
+  EXPECT_EQ(pyramid.getMaxCost(45, 38, 51, 41), LETHAL_OBSTACLE);
+  EXPECT_EQ(pyramid.getMaxCost(50, 40, 51, 41), LETHAL_OBSTACLE);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,205 @@
+#include <gtest/gtest.h>
+#include <costmap_2d/cost_values.h>
+#include <costmap_2d/layered_costmap.h>
+#include <boost/atomic.hpp>
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+#include <algorithm>
+
+using namespace costmap_2d;
+
+namespace
+{
+
+// marks the cell of one point lethal, or fills every cell of the update with one cost
+class PointLayer : public Layer
+{
+public:
+  PointLayer() :
+      x_(0.0), y_(0.0), fill_(-1)
+  {
+  }
+
+  virtual void updateBounds(double robot_x, double robot_y, double robot_yaw, double* min_x, double* min_y,
+                            double* max_x, double* max_y)
+  {
+    if (fill_ >= 0)
+    {
+      *min_x = *min_y = -1e3;
+      *max_x = *max_y = 1e3;
+      return;
+    }
+    *min_x = std::min(*min_x, x_);
+    *min_y = std::min(*min_y, y_);
+    *max_x = std::max(*max_x, x_);
+    *max_y = std::max(*max_y, y_);
+  }
+
+  virtual void updateCosts(Costmap2D& master_grid, int min_i, int min_j, int max_i, int max_j)
+  {
+    if (fill_ >= 0)
+    {
+      for (int j = min_j; j < max_j; ++j)
+      {
+        for (int i = min_i; i < max_i; ++i)
+          master_grid.setCost(i, j, fill_);
+      }
+      return;
+    }
+    unsigned int mx, my;
+    if (master_grid.worldToMap(x_, y_, mx, my))
+      master_grid.setCost(mx, my, LETHAL_OBSTACLE);
+  }
+
+  double x_, y_;
+  int fill_;
+};
+
+// every snapshot has to hold a single cost, the one of the update it was taken after
+void readSnapshots(LayeredCostmap* layers, const boost::atomic<bool>* done, unsigned int* num_torn, unsigned int* num_read)
+{
+  unsigned long last_epoch = 0;
+  while (!done->load())
+  {
+    boost::shared_ptr<const CostmapSnapshot> snapshot = layers->getSnapshot();
+    if (!snapshot || snapshot->getEpoch() == last_epoch)
+      continue;
+    last_epoch = snapshot->getEpoch();
+    const Costmap2D& map = snapshot->getCostmap();
+    const unsigned char* costs = map.getCharMap();
+    unsigned int num_cells = map.getSizeInCellsX() * map.getSizeInCellsY();
+    if (std::count(costs, costs + num_cells, costs[0]) != (int)num_cells
+        || costs[0] != snapshot->getEpoch() % 200)
+      ++*num_torn;
+    ++*num_read;
+  }
+}
+
+}  // namespace
+
+TEST(CostmapSnapshot, publish_test)
+{
+  LayeredCostmap layers("map", false, false);
+  layers.resizeMap(40, 40, 0.1, 0.0, 0.0);
+  boost::shared_ptr<PointLayer> layer(new PointLayer());
+  layers.addPlugin(layer);
+  layers.setTrackCellCounts(true);
+  layers.setPyramidLevels(2);
+
+  layers.updateMap(0.0, 0.0, 0.0);
+  EXPECT_FALSE(layers.getSnapshot());
+
+  layers.setPublishSnapshots(true);
+  layer->x_ = 1.05;
+  layer->y_ = 2.05;
+  layers.updateMap(0.0, 0.0, 0.0);
+  boost::shared_ptr<const CostmapSnapshot> first = layers.getSnapshot();
+  ASSERT_TRUE(first);
+  EXPECT_EQ(first->getEpoch(), 1u);
+  EXPECT_EQ(first->getCostmap().getCost(10, 20), LETHAL_OBSTACLE);
+  ASSERT_TRUE(first->getCellCounters());
+  EXPECT_EQ(first->getCellCounters()->getLethalInRow(20), 1u);
+  ASSERT_TRUE(first->getPyramid());
+  EXPECT_EQ(first->getPyramid()->getCost(2, 2, 5), LETHAL_OBSTACLE);
+
+  // a snapshot that is held does not change with the master costmap
+  layer->x_ = 3.05;
+  layers.updateMap(0.0, 0.0, 0.0);
+  layers.getCostmap()->setCost(30, 20, FREE_SPACE);
+  EXPECT_EQ(first->getCostmap().getCost(30, 20), FREE_SPACE);
+  boost::shared_ptr<const CostmapSnapshot> second = layers.getSnapshot();
+  EXPECT_EQ(second->getEpoch(), 2u);
+  EXPECT_EQ(second->getCostmap().getCost(30, 20), LETHAL_OBSTACLE);
+  EXPECT_EQ(second->getCellCounters()->getLethalInRow(20), 2u);
+  EXPECT_EQ(first->getCellCounters()->getLethalInRow(20), 1u);
+  EXPECT_EQ(second->getPyramid()->getCost(1, 15, 10), LETHAL_OBSTACLE);
+  EXPECT_EQ(first->getPyramid()->getCost(1, 15, 10), FREE_SPACE);
+
+  // once released, the first one is refilled instead of a new one allocated
+  const CostmapSnapshot* first_address = first.get();
+  first.reset();
+  second.reset();
+  layers.updateMap(0.0, 0.0, 0.0);
+  EXPECT_EQ(layers.getSnapshot().get(), first_address);
+  EXPECT_EQ(layers.getSnapshot()->getEpoch(), 3u);
+
+  layers.setPublishSnapshots(false);
+  EXPECT_FALSE(layers.getSnapshot());
+}
+
+TEST(CostmapSnapshot, changed_bounds_test)
+{
+  LayeredCostmap layers("map", false, false);
+  layers.resizeMap(40, 40, 0.1, 0.0, 0.0);
+  boost::shared_ptr<PointLayer> layer(new PointLayer());
+  layers.addPlugin(layer);
+  layers.setPublishSnapshots(true);
+
+  double minx, miny, maxx, maxy;
+  layers.updateMap(0.0, 0.0, 0.0);
+  EXPECT_FALSE(layers.getSnapshot()->getChangedBoundsSince(0, minx, miny, maxx, maxy));
+
+  layer->x_ = 1.0;
+  layer->y_ = 2.0;
+  layers.updateMap(0.0, 0.0, 0.0);
+  layer->x_ = 3.0;
+  layer->y_ = 0.5;
+  layers.updateMap(0.0, 0.0, 0.0);
+  boost::shared_ptr<const CostmapSnapshot> snapshot = layers.getSnapshot();
+  ASSERT_EQ(snapshot->getEpoch(), 3u);
+  ASSERT_TRUE(snapshot->getChangedBoundsSince(1, minx, miny, maxx, maxy));
+  EXPECT_DOUBLE_EQ(minx, 1.0);
+  EXPECT_DOUBLE_EQ(miny, 0.5);
+  EXPECT_DOUBLE_EQ(maxx, 3.0);
+  EXPECT_DOUBLE_EQ(maxy, 2.0);
+  ASSERT_TRUE(snapshot->getChangedBoundsSince(2, minx, miny, maxx, maxy));
+  EXPECT_DOUBLE_EQ(minx, 3.0);
+  EXPECT_DOUBLE_EQ(maxy, 0.5);
+  ASSERT_TRUE(snapshot->getChangedBoundsSince(3, minx, miny, maxx, maxy));
+  EXPECT_GT(minx, maxx);
+
+  // too old for the history, or resized in between
+  for (unsigned int k = 0; k <= CostmapSnapshot::HISTORY; ++k)
+    layers.updateMap(0.0, 0.0, 0.0);
+  EXPECT_FALSE(layers.getSnapshot()->getChangedBoundsSince(3, minx, miny, maxx, maxy));
+  unsigned long epoch = layers.getSnapshot()->getEpoch();
+  layers.resizeMap(50, 50, 0.1, 0.0, 0.0);
+  layers.updateMap(0.0, 0.0, 0.0);
+  EXPECT_FALSE(layers.getSnapshot()->getChangedBoundsSince(epoch, minx, miny, maxx, maxy));
+  EXPECT_EQ(layers.getSnapshot()->getCostmap().getSizeInCellsX(), 50u);
+  epoch = layers.getSnapshot()->getEpoch();
+  layers.updateMap(0.0, 0.0, 0.0);
+  EXPECT_TRUE(layers.getSnapshot()->getChangedBoundsSince(epoch, minx, miny, maxx, maxy));
+}
+
+TEST(CostmapSnapshot, concurrent_read_test)
+{
+  LayeredCostmap layers("map", false, false);
+  layers.resizeMap(100, 100, 0.1, 0.0, 0.0);
+  boost::shared_ptr<PointLayer> layer(new PointLayer());
+  layers.addPlugin(layer);
+  layers.setPublishSnapshots(true);
+
+  // the layer covers the whole map, with the cost of the epoch the update will be published as
+  boost::atomic<bool> done(false);
+  unsigned int num_torn[2] = {0, 0}, num_read[2] = {0, 0};
+  boost::thread_group readers;
+  for (int t = 0; t < 2; ++t)
+    readers.create_thread(boost::bind(&readSnapshots, &layers, &done, &num_torn[t], &num_read[t]));
+  for (unsigned int epoch = 1; epoch <= 2000; ++epoch)
+  {
+    layer->fill_ = epoch % 200;
+    layers.updateMap(0.0, 0.0, 0.0);
+  }
+  done.store(true);
+  readers.join_all();
+
+  EXPECT_EQ(num_torn[0] + num_torn[1], 0u);
+  EXPECT_GT(num_read[0] + num_read[1], 0u);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
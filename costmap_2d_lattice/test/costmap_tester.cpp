@@ -61,7 +61,7 @@ void CostmapTester::checkConsistentCosts(){
   costmap_2d::Costmap2D* costmap = costmap_ros_.getCostmap();
 
   //get a copy of the costmap contained by our ros wrapper
-  costmap->saveMap("costmap_test.pgm");
+  costmap->saveBinaryMap("costmap_test.costmap");
 
   //loop through the costmap and check for any unexpected drop-offs in costs
   for(unsigned int i = 0; i < costmap->getSizeInCellsX(); ++i){
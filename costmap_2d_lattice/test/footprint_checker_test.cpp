@@ -0,0 +1,71 @@
+#include <gtest/gtest.h>
+#include <costmap_2d/footprint_checker.h>
+#include <costmap_2d/cost_values.h>
+#include <cmath>
+#include <vector>
+
+using namespace costmap_2d;
+
+namespace
+{
+
+// a car-like rectangle, 2 m long and 1 m wide around the reference point
+std::vector<geometry_msgs::Point> rectangle()
+{
+  std::vector<geometry_msgs::Point> footprint(4);
+  footprint[0].x = -0.5;
+  footprint[0].y = -0.5;
+  footprint[1].x = 1.5;
+  footprint[1].y = -0.5;
+  footprint[2].x = 1.5;
+  footprint[2].y = 0.5;
+  footprint[3].x = -0.5;
+  footprint[3].y = 0.5;
+  return footprint;
+}
+
+}  // namespace
+
+TEST(FootprintChecker, footprint_cost_test)
+{
+  Costmap2D map(40, 40, 0.5, 0.0, 0.0);
+  FootprintChecker checker;
+  checker.setFootprint(rectangle(), 0.5);
+  ASSERT_TRUE(checker.isConfigured());
+
+  // an obstacle next to the front corner, away from the cell of the reference point
+  map.setCost(23, 20, LETHAL_OBSTACLE);
+  EXPECT_EQ(checker.footprintCost(map, 10.2, 10.2, 0.0), LETHAL_OBSTACLE);
+  EXPECT_EQ(checker.footprintCost(map, 10.2, 10.2, M_PI), 0);
+  EXPECT_EQ(checker.footprintCost(map, 10.2, 10.2, M_PI / 2), 0);
+
+  map.setCost(20, 23, 100);
+  EXPECT_EQ(checker.footprintCost(map, 10.2, 10.2, M_PI / 2), 100);
+
+  // poses partly or fully outside of the map only look at the cells inside
+  EXPECT_EQ(checker.footprintCost(map, -0.2, 5.0, M_PI), 0);
+  EXPECT_EQ(checker.footprintCost(map, -10.0, -10.0, 0.0), 0);
+}
+
+TEST(FootprintChecker, swept_cost_test)
+{
+  Costmap2D map(40, 40, 0.5, 0.0, 0.0);
+  FootprintChecker checker;
+  checker.setFootprint(rectangle(), 0.5);
+
+  // a thin wall the footprint jumps over between two samples 4 m apart
+  for (unsigned int j = 0; j < 40; ++j)
+    map.setCost(20, j, LETHAL_OBSTACLE);
+  EXPECT_EQ(checker.footprintCost(map, 7.2, 10.2, 0.0), 0);
+  EXPECT_EQ(checker.footprintCost(map, 11.2, 10.2, 0.0), 0);
+  EXPECT_EQ(checker.sweptCost(map, 7.2, 10.2, 0.0, 11.2, 10.2, 0.0), LETHAL_OBSTACLE);
+
+  // moving along the wall stays free
+  EXPECT_EQ(checker.sweptCost(map, 7.2, 2.2, M_PI / 2, 7.2, 15.2, M_PI / 2), 0);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
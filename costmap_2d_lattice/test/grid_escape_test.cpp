@@ -0,0 +1,129 @@
+#include <gtest/gtest.h>
+#include <costmap_2d/grid_escape.h>
+#include <cmath>
+
+using namespace costmap_2d;
+
+namespace
+{
+
+// every cell of the path can be entered and every step goes to a neighbour
+void expectFreePath(const Costmap2D& map, const GridEscape& escape)
+{
+  const std::vector<double>& x = escape.getPathX();
+  const std::vector<double>& y = escape.getPathY();
+  ASSERT_EQ(x.size(), y.size());
+  ASSERT_GE(x.size(), 2u);
+  for (unsigned int k = 0; k < x.size(); ++k)
+  {
+    unsigned int mx, my;
+    ASSERT_TRUE(map.worldToMap(x[k], y[k], mx, my));
+    if (k > 0)
+    {
+      EXPECT_LT(map.getCost(mx, my), INSCRIBED_INFLATED_OBSTACLE) << "step " << k;
+      EXPECT_LE(hypot(x[k] - x[k - 1], y[k] - y[k - 1]), M_SQRT2 * map.getResolution() + 1e-9);
+    }
+  }
+}
+
+}  // namespace
+
+TEST(GridEscape, open_map_test)
+{
+  Costmap2D map(40, 40, 0.5, 0.0, 0.0);
+  GridEscape escape;
+  escape.configure(1000, 0.0, INSCRIBED_INFLATED_OBSTACLE, 1.0);
+  ASSERT_TRUE(escape.search(map, 1.2, 1.2, 15.2, 1.2));
+  EXPECT_TRUE(escape.reachedGoal());
+  expectFreePath(map, escape);
+  EXPECT_EQ(escape.getPathX().size(), 29u);
+  // a straight line expands little more than the cells on it
+  EXPECT_LE(escape.getNumExpanded(), 40u);
+
+  double x, y;
+  ASSERT_TRUE(escape.getLookahead(3.0, x, y));
+  EXPECT_NEAR(x, 4.25, 1e-9);
+  EXPECT_NEAR(y, 1.25, 1e-9);
+  // past its end the lookahead stays at the end of the path
+  ASSERT_TRUE(escape.getLookahead(100.0, x, y));
+  EXPECT_NEAR(x, 15.25, 1e-9);
+}
+
+TEST(GridEscape, wall_gap_test)
+{
+  // a wall across the map with a gap at one end, the goal behind it
+  Costmap2D map(40, 40, 0.5, 0.0, 0.0);
+  for (unsigned int j = 0; j < 36; ++j)
+    map.setCost(20, j, LETHAL_OBSTACLE);
+  for (unsigned int j = 0; j < 35; ++j)
+  {
+    map.setCost(19, j, INSCRIBED_INFLATED_OBSTACLE);
+    map.setCost(21, j, INSCRIBED_INFLATED_OBSTACLE);
+  }
+  GridEscape escape;
+  escape.configure(5000, 0.0, INSCRIBED_INFLATED_OBSTACLE, 1.0);
+  ASSERT_TRUE(escape.search(map, 5.0, 5.0, 15.0, 5.0));
+  EXPECT_TRUE(escape.reachedGoal());
+  expectFreePath(map, escape);
+  double top = 0.0;
+  for (unsigned int k = 0; k < escape.getPathY().size(); ++k)
+    top = std::max(top, escape.getPathY()[k]);
+  EXPECT_GT(top, 18.0);
+
+  // the same search again forgets the last one
+  ASSERT_TRUE(escape.search(map, 5.0, 5.0, 15.0, 5.0));
+  EXPECT_TRUE(escape.reachedGoal());
+
+  // closing the gap leaves the cell closest to the goal on this side
+  for (unsigned int j = 36; j < 40; ++j)
+    map.setCost(20, j, LETHAL_OBSTACLE);
+  ASSERT_TRUE(escape.search(map, 5.0, 5.0, 15.2, 5.2));
+  EXPECT_FALSE(escape.reachedGoal());
+  expectFreePath(map, escape);
+  EXPECT_NEAR(escape.getPathX().back(), 9.25, 1e-9);
+  EXPECT_NEAR(escape.getPathY().back(), 5.25, 1e-9);
+}
+
+TEST(GridEscape, budget_and_start_test)
+{
+  Costmap2D map(40, 40, 0.5, 0.0, 0.0);
+  GridEscape escape;
+  // out of budget, the search still returns the way towards the goal found so far
+  escape.configure(5, 0.0, INSCRIBED_INFLATED_OBSTACLE, 1.0);
+  ASSERT_TRUE(escape.search(map, 1.2, 1.2, 15.2, 1.2));
+  EXPECT_FALSE(escape.reachedGoal());
+  EXPECT_EQ(escape.getNumExpanded(), 5u);
+  expectFreePath(map, escape);
+
+  // a start inside the inflation walks down it, but not into a lethal cell
+  escape.configure(1000, 0.0, INSCRIBED_INFLATED_OBSTACLE, 1.0);
+  for (unsigned int i = 0; i < 40; ++i)
+  {
+    for (unsigned int j = 0; j < 40; ++j)
+      map.setCost(i, j, i < 4 ? INSCRIBED_INFLATED_OBSTACLE : 100);
+  }
+  map.setCost(4, 2, LETHAL_OBSTACLE);
+  ASSERT_TRUE(escape.search(map, 1.2, 1.2, 15.2, 1.2));
+  EXPECT_TRUE(escape.reachedGoal());
+  for (unsigned int k = 0; k < escape.getPathX().size(); ++k)
+  {
+    unsigned int mx, my;
+    map.worldToMap(escape.getPathX()[k], escape.getPathY()[k], mx, my);
+    EXPECT_NE(map.getCost(mx, my), LETHAL_OBSTACLE);
+  }
+
+  // a start outside the map or boxed in by lethal cells has no escape
+  EXPECT_FALSE(escape.search(map, -1.0, 1.0, 15.2, 1.2));
+  for (unsigned int i = 9; i < 12; ++i)
+  {
+    for (unsigned int j = 9; j < 12; ++j)
+      map.setCost(i, j, i == 10 && j == 10 ? FREE_SPACE : LETHAL_OBSTACLE);
+  }
+  EXPECT_FALSE(escape.search(map, 5.2, 5.2, 15.2, 1.2));
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
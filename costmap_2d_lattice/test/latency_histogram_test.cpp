@@ -0,0 +1,78 @@
+#include <gtest/gtest.h>
+#include <costmap_2d/latency_histogram.h>
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+
+using namespace costmap_2d;
+
+namespace
+{
+
+void recordMany(LatencyHistogram* histogram, double seconds, unsigned int n)
+{
+  for (unsigned int k = 0; k < n; ++k)
+    histogram->record(seconds);
+}
+
+}  // namespace
+
+TEST(LatencyHistogram, bucket_test)
+{
+  EXPECT_EQ(LatencyHistogram::getBucket(0.0), 0u);
+  EXPECT_EQ(LatencyHistogram::getBucket(-1.0), 0u);
+  EXPECT_EQ(LatencyHistogram::getBucket(1e3), LatencySnapshot::NUM_BUCKETS - 1);
+  // every duration lies below the limit of its bucket and at or above the limit of the one before
+  for (double seconds = 1e-6; seconds < 1.0; seconds *= 1.07)
+  {
+    unsigned int bucket = LatencyHistogram::getBucket(seconds);
+    ASSERT_GT(bucket, 0u);
+    EXPECT_LT(seconds, LatencyHistogram::getBucketLimit(bucket) * (1 + 1e-12));
+    EXPECT_GE(seconds, LatencyHistogram::getBucketLimit(bucket - 1) * (1 - 1e-12));
+    EXPECT_LE(LatencyHistogram::getBucketLimit(bucket), seconds * 1.25 * (1 + 1e-12));
+  }
+}
+
+TEST(LatencyHistogram, percentile_test)
+{
+  LatencyHistogram histogram;
+  for (int k = 1; k <= 100; ++k)
+    histogram.record(k * 1e-4);
+  LatencySnapshot snapshot;
+  histogram.take(snapshot);
+  EXPECT_EQ(snapshot.count, 100u);
+  EXPECT_NEAR(snapshot.mean(), 50.5e-4, 1e-9);
+  EXPECT_NEAR(snapshot.max, 1e-2, 1e-9);
+  EXPECT_GE(snapshot.percentile(0.5), 50e-4);
+  EXPECT_LE(snapshot.percentile(0.5), 50e-4 * 1.25);
+  EXPECT_GE(snapshot.percentile(0.99), 99e-4);
+  EXPECT_LE(snapshot.percentile(0.99), snapshot.max);
+  EXPECT_EQ(snapshot.percentile(1.0), snapshot.max);
+
+  // take() starts the next period from zero
+  histogram.take(snapshot);
+  EXPECT_EQ(snapshot.count, 0u);
+  EXPECT_EQ(snapshot.max, 0.0);
+  EXPECT_EQ(snapshot.percentile(0.5), 0.0);
+}
+
+TEST(LatencyHistogram, concurrent_record_test)
+{
+  LatencyHistogram histogram;
+  boost::thread_group threads;
+  for (int t = 0; t < 4; ++t)
+    threads.create_thread(boost::bind(&recordMany, &histogram, (t + 1) * 1e-3, 10000));
+  threads.join_all();
+
+  LatencySnapshot snapshot;
+  histogram.take(snapshot);
+  EXPECT_EQ(snapshot.count, 40000u);
+  EXPECT_NEAR(snapshot.max, 4e-3, 1e-9);
+  EXPECT_NEAR(snapshot.mean(), 2.5e-3, 1e-6);
+  EXPECT_EQ(snapshot.counts[LatencyHistogram::getBucket(1e-3)], 10000u);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
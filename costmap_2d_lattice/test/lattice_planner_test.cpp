@@ -0,0 +1,656 @@
+#include <gtest/gtest.h>
+#include <costmap_2d/lattice_planner.h>
+#include <costmap_2d/planner_log.h>
+#include <costmap_2d/cost_values.h>
+#include <boost/atomic.hpp>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+using namespace costmap_2d;
+
+// every allocation of the test is counted, so a test can check that planning ticks do not allocate
+boost::atomic<unsigned long> num_allocations(0);
+
+void* operator new(std::size_t size)
+{
+  num_allocations.fetch_add(1, boost::memory_order_relaxed);
+  void* memory = malloc(size > 0 ? size : 1);
+  if (!memory)
+    throw std::bad_alloc();
+  return memory;
+}
+
+void* operator new[](std::size_t size)
+{
+  return operator new(size);
+}
+
+void operator delete(void* memory) throw()
+{
+  free(memory);
+}
+
+void operator delete(void* memory, std::size_t) throw()
+{
+  free(memory);
+}
+
+void operator delete[](void* memory) throw()
+{
+  free(memory);
+}
+
+void operator delete[](void* memory, std::size_t) throw()
+{
+  free(memory);
+}
+
+namespace
+{
+
+LatticePlannerConfig defaultConfig()
+{
+  LatticePlannerConfig config;
+  for (int k = 0; k < 13; ++k)
+    config.steering_targets.push_back((-15.0 + 2.5 * k) * M_PI / 180);
+  config.use_footprint_check = false;
+  return config;
+}
+
+// a straight reference line along y = 20
+void straightPath(ReferencePath& path)
+{
+  std::vector<double> x, y;
+  for (int k = 0; k <= 40; ++k)
+  {
+    x.push_back(k);
+    y.push_back(20.0);
+  }
+  path.setPoints(x, y, false);
+}
+
+// a fresh planner, so every call starts from the same steering, with the scores of one tick
+void scoreOnce(const LatticePlannerConfig& config, const std::vector<geometry_msgs::Point>& footprint,
+               const Costmap2D& map, const double* state, const std::vector<double>& offsets, LatticePlanner& planner)
+{
+  planner.configure(config);
+  if (!footprint.empty())
+    planner.setFootprint(footprint, map.getResolution());
+  straightPath(planner.getReferencePath());
+  planner.setStartHypotheses(offsets);
+  LatticePlan plan;
+  planner.plan(map, state, 0.0, NULL, 0.5, plan);
+}
+
+}  // namespace
+
+TEST(LatticePlanner, straight_road_test)
+{
+  Costmap2D map(80, 80, 0.5, 0.0, 0.0);
+  LatticePlanner planner;
+  planner.configure(defaultConfig());
+  straightPath(planner.getReferencePath());
+
+  double state[4] = {5.0, 20.0, 0.0, 3.0};
+  LatticePlan plan;
+  planner.plan(map, state, 0.0, NULL, 0.5, plan);
+  EXPECT_FALSE(plan.warm_started);
+  EXPECT_EQ(plan.primitive, 6u);
+  EXPECT_EQ(plan.fast, 1);
+  EXPECT_NEAR(plan.steering, 0.0, 1e-9);
+  EXPECT_NEAR(plan.goal_x, 15.0, 1e-6);
+  EXPECT_NEAR(plan.goal_y, 20.0, 1e-6);
+  EXPECT_EQ(planner.getScores().size(), 13u);
+
+  // shortly after, with nothing changed near the plan, the plan is followed on
+  double changed_bounds[4] = {0.0, 0.0, 1.0, 1.0};
+  state[0] += 0.3;
+  planner.plan(map, state, 0.1, changed_bounds, 0.5, plan);
+  EXPECT_TRUE(plan.warm_started);
+  EXPECT_EQ(plan.primitive, 6u);
+  // nothing is rolled out, and the goal is the one of the plan followed on
+  EXPECT_EQ(plan.timings.rollout, 0.0);
+  EXPECT_NEAR(plan.goal_x, 15.0, 1e-6);
+
+  // unknown changes always replan
+  planner.plan(map, state, 0.2, NULL, 0.5, plan);
+  EXPECT_FALSE(plan.warm_started);
+}
+
+TEST(LatticePlanner, short_horizon_test)
+{
+  // a horizon without the step whose steering is sent is raised to hold it
+  LatticePlannerConfig config = defaultConfig();
+  config.horizon = 0.2;
+  LatticePlanner planner;
+  planner.configure(config);
+  EXPECT_GT(planner.getConfig().horizon, 0.2);
+  EXPECT_GT(planner.getPrimitives().getNumSteps(), 6u);
+
+  Costmap2D map(80, 80, 0.5, 0.0, 0.0);
+  straightPath(planner.getReferencePath());
+  double state[4] = {5.0, 20.0, 0.0, 3.0};
+  LatticePlan plan;
+  planner.plan(map, state, 0.0, NULL, 0.5, plan);
+  EXPECT_EQ(plan.primitive, 6u);
+  double changed_bounds[4] = {0.0, 0.0, 1.0, 1.0};
+  planner.plan(map, state, 0.1, changed_bounds, 0.5, plan);
+  EXPECT_EQ(plan.primitive, 6u);
+}
+
+TEST(LatticePlanner, blocked_road_test)
+{
+  // a wall across the road ahead of the car, with a gap above the line
+  Costmap2D map(80, 80, 0.5, 0.0, 0.0);
+  for (unsigned int j = 0; j < 80; ++j)
+  {
+    if (j < 41 || j > 46)
+      map.setCost(24, j, LETHAL_OBSTACLE);
+  }
+  LatticePlanner planner;
+  planner.configure(defaultConfig());
+  straightPath(planner.getReferencePath());
+
+  double state[4] = {5.0, 20.0, 0.0, 5.0};
+  LatticePlan plan;
+  planner.plan(map, state, 0.0, NULL, 0.5, plan);
+  EXPECT_EQ(planner.getScores()[6], DBL_MAX);
+  EXPECT_GT(planner.getPrimitives().getSteeringTarget(plan.primitive), 0.0);
+}
+
+TEST(LatticePlanner, search_warm_start_test)
+{
+  // a short wall on the line at the end of the horizon, the search only checks its first stage
+  Costmap2D map(80, 80, 0.5, 0.0, 0.0);
+  for (unsigned int j = 38; j < 41; ++j)
+    map.setCost(40, j, LETHAL_OBSTACLE);
+  LatticePlannerConfig config = defaultConfig();
+  config.search_depth = 3;
+  LatticePlanner planner;
+  planner.configure(config);
+  straightPath(planner.getReferencePath());
+
+  double state[4] = {5.0, 20.0, 0.0, 6.0};
+  LatticePlan plan;
+  planner.plan(map, state, 0.0, NULL, 0.5, plan);
+  ASSERT_EQ(planner.getScores()[plan.primitive], DBL_MAX);
+
+  // the wall is not in the changed area, but the blocked pick is not followed on
+  double changed_bounds[4] = {0.0, 0.0, 1.0, 1.0};
+  state[0] += 0.6;
+  planner.plan(map, state, 0.1, changed_bounds, 0.5, plan);
+  EXPECT_FALSE(plan.warm_started);
+
+  // a free pick of the search is
+  Costmap2D free_map(80, 80, 0.5, 0.0, 0.0);
+  state[0] = 5.0;
+  planner.configure(config);
+  planner.plan(free_map, state, 0.0, NULL, 0.5, plan);
+  ASSERT_NE(planner.getScores()[plan.primitive], DBL_MAX);
+  state[0] += 0.6;
+  planner.plan(free_map, state, 0.1, changed_bounds, 0.5, plan);
+  EXPECT_TRUE(plan.warm_started);
+}
+
+TEST(LatticePlanner, escape_test)
+{
+  // a wall right ahead of the car that no primitive gets around, with a gap far below the road
+  Costmap2D map(80, 80, 0.5, 0.0, 0.0);
+  for (unsigned int j = 0; j < 80; ++j)
+  {
+    if (j < 6 || j > 10)
+      map.setCost(16, j, LETHAL_OBSTACLE);
+  }
+  LatticePlannerConfig config = defaultConfig();
+  config.escape_lookahead = 6.0;
+  LatticePlanner planner;
+  planner.configure(config);
+  straightPath(planner.getReferencePath());
+
+  double state[4] = {5.0, 20.0, 0.0, 3.0};
+  LatticePlan plan;
+  planner.plan(map, state, 0.0, NULL, 0.5, plan);
+  EXPECT_TRUE(plan.escaped);
+  EXPECT_EQ(plan.fast, 0);
+  EXPECT_TRUE(planner.getEscape().reachedGoal());
+  // the grid path leads down to the gap, so the car turns right instead of heading for the goal
+  EXPECT_LT(planner.getPrimitives().getSteeringTarget(plan.primitive), 0.0);
+
+  config.use_escape_search = false;
+  planner.configure(config);
+  planner.plan(map, state, 0.0, NULL, 0.5, plan);
+  EXPECT_FALSE(plan.escaped);
+  EXPECT_EQ(plan.primitive, 6u);
+}
+
+TEST(LatticePlanner, start_hypotheses_test)
+{
+  srand(5);
+  Costmap2D map(80, 80, 0.5, 0.0, 0.0), free_map(80, 80, 0.5, 0.0, 0.0);
+  // soft costs around the road and a short wall ahead that blocks the primitives close to straight
+  for (unsigned int b = 0; b < 150; ++b)
+    map.setCost(10 + rand() % 20, 30 + rand() % 20, 1 + rand() % 200);
+  for (unsigned int i = 24; i < 26; ++i)
+  {
+    for (unsigned int j = 40; j < 42; ++j)
+      map.setCost(i, j, LETHAL_OBSTACLE);
+  }
+  std::vector<geometry_msgs::Point> box(4);
+  box[0].x = box[1].x = 0.3;
+  box[2].x = box[3].x = -0.3;
+  box[0].y = box[3].y = 0.2;
+  box[1].y = box[2].y = -0.2;
+
+  LatticePlannerConfig config = defaultConfig();
+  config.use_warm_start = false;
+  double state[4] = {5.0, 19.6, 0.05, 4.0};
+  const double h1[3] = {0.13, -0.21, -0.04}, h2[3] = {-0.07, 0.18, 0.03};
+  for (int with_footprint = 0; with_footprint < 2; ++with_footprint)
+  {
+    config.use_footprint_check = with_footprint == 1;
+    std::vector<geometry_msgs::Point> footprint = with_footprint ? box : std::vector<geometry_msgs::Point>();
+    std::vector<double> none, zero(3, 0.0), first(h1, h1 + 3), second(h2, h2 + 3), both(first);
+    both.insert(both.end(), h2, h2 + 3);
+
+    // the state as the only hypothesis scores exactly like no hypotheses
+    LatticePlanner plain, single;
+    scoreOnce(config, footprint, map, state, none, plain);
+    scoreOnce(config, footprint, map, state, zero, single);
+    EXPECT_EQ(plain.getNumHypotheses(), 0u);
+    EXPECT_EQ(single.getNumHypotheses(), 1u);
+    EXPECT_EQ(single.getScores(), plain.getScores());
+    EXPECT_EQ(single.getExpectedScores(), plain.getWorstScores());
+    EXPECT_EQ(single.getWorstScores(), plain.getWorstScores());
+
+    // a hypothesis sees the obstacles the state moved by it sees, the global goal stays the one of the state
+    double moved[4] = {state[0] + h1[0], state[1] + h1[1], state[2] + h1[2], state[3]};
+    LatticePlanner from_h1, from_h1_free, from_moved, from_moved_free;
+    scoreOnce(config, footprint, map, state, first, from_h1);
+    scoreOnce(config, footprint, free_map, state, first, from_h1_free);
+    scoreOnce(config, footprint, map, moved, none, from_moved);
+    scoreOnce(config, footprint, free_map, moved, none, from_moved_free);
+    unsigned int num_blocked = 0;
+    for (unsigned int p = 0; p < plain.getScores().size(); ++p)
+    {
+      bool blocked = from_moved.getWorstScores()[p] == DBL_MAX;
+      num_blocked += blocked;
+      ASSERT_EQ(from_h1.getWorstScores()[p] == DBL_MAX, blocked) << "primitive " << p;
+      if (!blocked)
+      {
+        EXPECT_NEAR(from_h1.getWorstScores()[p] - from_h1_free.getWorstScores()[p],
+                    from_moved.getWorstScores()[p] - from_moved_free.getWorstScores()[p], 1e-9) << "primitive " << p;
+      }
+    }
+    EXPECT_GT(num_blocked, 0u);
+    EXPECT_LT(num_blocked, plain.getScores().size());
+
+    // both hypotheses at once give the mean and the worst of the two
+    LatticePlanner from_h2, from_both;
+    scoreOnce(config, footprint, map, state, second, from_h2);
+    scoreOnce(config, footprint, map, state, both, from_both);
+    for (unsigned int p = 0; p < plain.getScores().size(); ++p)
+    {
+      // the worst scores keep DBL_MAX where the fallback rescored a fully blocked tick
+      double a = from_h1.getWorstScores()[p], b = from_h2.getWorstScores()[p];
+      if (a == DBL_MAX || b == DBL_MAX)
+      {
+        EXPECT_EQ(from_both.getWorstScores()[p], DBL_MAX);
+        continue;
+      }
+      EXPECT_NEAR(from_both.getExpectedScores()[p], 0.5 * (a + b), 1e-9);
+      EXPECT_NEAR(from_both.getWorstScores()[p], std::max(a, b), 1e-9);
+      EXPECT_NEAR(from_both.getScores()[p], 0.5 * (from_both.getExpectedScores()[p] + from_both.getWorstScores()[p]),
+                  1e-9);
+    }
+  }
+
+  // the sigma points of the configuration, blocked wherever the state alone is blocked
+  config.pose_sigma_xy = 0.05;
+  LatticePlanner nominal, sigma;
+  scoreOnce(config, std::vector<geometry_msgs::Point>(), map, state, std::vector<double>(), sigma);
+  EXPECT_EQ(sigma.getNumHypotheses(), 5u);
+  config.pose_sigma_theta = 0.05;
+  scoreOnce(config, std::vector<geometry_msgs::Point>(), map, state, std::vector<double>(), sigma);
+  EXPECT_EQ(sigma.getNumHypotheses(), 7u);
+  config.pose_sigma_xy = config.pose_sigma_theta = 0.0;
+  scoreOnce(config, std::vector<geometry_msgs::Point>(), map, state, std::vector<double>(), nominal);
+  for (unsigned int p = 0; p < nominal.getScores().size(); ++p)
+  {
+    if (nominal.getScores()[p] == DBL_MAX)
+    {
+      EXPECT_EQ(sigma.getScores()[p], DBL_MAX);
+    }
+    else if (sigma.getScores()[p] != DBL_MAX)
+    {
+      EXPECT_LE(sigma.getExpectedScores()[p], sigma.getWorstScores()[p]);
+    }
+  }
+}
+
+TEST(LatticePlanner, log_round_trip_test)
+{
+  LatticePlannerConfig config = defaultConfig();
+  config.search_node_budget = 123;
+  config.use_warm_start = false;
+  config.use_branch_and_bound = true;
+  config.plan_deadline = 0.04;
+  config.anytime_coarse_stride = 2;
+  config.escape_lookahead = 2.5;
+  config.pose_sigma_theta = 0.04;
+  ReferencePath path;
+  straightPath(path);
+
+  Costmap2D map(80, 80, 0.5, -3.0, 2.0);
+  map.setCost(30, 40, 100);
+  PlannerLogRecord record;
+  record.stamp = 12.5;
+  record.state[0] = 5.0;
+  record.state[1] = 20.0;
+  record.state[3] = 3.0;
+  record.steering = 0.01;
+  record.changes_known = true;
+  record.changed_bounds[2] = 4.0;
+  record.margin = 0.7;
+  record.footprint.resize(3);
+  record.footprint[1].x = 1.0;
+  record.footprint[2].y = 0.5;
+  record.setMap(map);
+  record.plan.primitive = 7;
+  record.plan.steering = 0.02;
+  record.plan.fast = 1;
+  record.plan.timings.total = 0.003;
+
+  const char* filename = "lattice_planner_test.log";
+  {
+    PlannerLogWriter writer;
+    ASSERT_TRUE(writer.open(filename, config, path));
+    writer.write(record);
+    writer.write(record);
+  }
+
+  PlannerLogReader reader;
+  LatticePlannerConfig read_config;
+  ReferencePath read_path;
+  ASSERT_TRUE(reader.open(filename, read_config, read_path));
+  EXPECT_EQ(read_config.search_node_budget, 123);
+  EXPECT_FALSE(read_config.use_warm_start);
+  EXPECT_TRUE(read_config.use_branch_and_bound);
+  EXPECT_EQ(read_config.plan_deadline, 0.04);
+  EXPECT_EQ(read_config.anytime_coarse_stride, 2);
+  EXPECT_EQ(read_config.escape_lookahead, 2.5);
+  EXPECT_EQ(read_config.pose_sigma_theta, 0.04);
+  EXPECT_EQ(read_config.steering_targets, config.steering_targets);
+  EXPECT_EQ(read_path.getX(), path.getX());
+  EXPECT_EQ(read_path.isClosed(), path.isClosed());
+
+  for (unsigned int r = 0; r < 2; ++r)
+  {
+    PlannerLogRecord read_record;
+    ASSERT_TRUE(reader.read(read_record));
+    EXPECT_EQ(read_record.stamp, 12.5);
+    EXPECT_EQ(read_record.steering, 0.01);
+    EXPECT_TRUE(read_record.changes_known);
+    EXPECT_EQ(read_record.changed_bounds[2], 4.0);
+    ASSERT_EQ(read_record.footprint.size(), 3u);
+    EXPECT_EQ(read_record.footprint[2].y, 0.5);
+    EXPECT_EQ(read_record.plan.primitive, 7u);
+    EXPECT_EQ(read_record.plan.timings.total, 0.003);
+
+    Costmap2D read_map;
+    read_record.getMap(read_map);
+    EXPECT_EQ(read_map.getSizeInCellsX(), 80u);
+    EXPECT_EQ(read_map.getOriginX(), -3.0);
+    EXPECT_EQ(read_map.getCost(30, 40), 100);
+    EXPECT_EQ(read_map.getCost(31, 40), 0);
+  }
+  PlannerLogRecord past_end;
+  EXPECT_FALSE(reader.read(past_end));
+  remove(filename);
+}
+
+TEST(LatticePlanner, replay_determinism_test)
+{
+  // two planners fed the same ticks take the same decisions, regardless of the number of threads
+  Costmap2D map(80, 80, 0.5, 0.0, 0.0);
+  for (unsigned int j = 30; j < 40; ++j)
+    map.setCost(30, j, LETHAL_OBSTACLE);
+  LatticePlannerConfig config = defaultConfig();
+  LatticePlanner single, parallel;
+  single.configure(config);
+  config.num_threads = 3;
+  parallel.configure(config);
+  straightPath(single.getReferencePath());
+  straightPath(parallel.getReferencePath());
+
+  double state[4] = {5.0, 19.0, 0.1, 4.0};
+  for (unsigned int tick = 0; tick < 10; ++tick)
+  {
+    LatticePlan a, b;
+    single.plan(map, state, 0.1 * tick, NULL, 0.5, a);
+    parallel.plan(map, state, 0.1 * tick, NULL, 0.5, b);
+    EXPECT_EQ(a.primitive, b.primitive);
+    EXPECT_EQ(a.steering, b.steering);
+    EXPECT_EQ(a.fast, b.fast);
+    EXPECT_EQ(a.switch_map, b.switch_map);
+    state[0] += 0.4;
+  }
+}
+
+TEST(LatticePlanner, branch_and_bound_test)
+{
+  // pruning only skips primitives that cannot win, so every decision matches the full scoring
+  srand(7);
+  for (int variant = 0; variant < 3; ++variant)
+  {
+    LatticePlannerConfig config = defaultConfig();
+    config.use_longitudinal_product = variant == 1;
+    config.num_threads = variant == 2 ? 3 : 0;
+    LatticePlanner full, pruned;
+    full.configure(config);
+    config.use_branch_and_bound = true;
+    pruned.configure(config);
+    straightPath(full.getReferencePath());
+    straightPath(pruned.getReferencePath());
+
+    unsigned int num_pruned = 0;
+    for (unsigned int tick = 0; tick < 40; ++tick)
+    {
+      // random blocks and soft costs ahead of the car, some ticks leave most of the road blocked
+      Costmap2D map(80, 80, 0.5, 0.0, 0.0);
+      unsigned int num_blocks = tick % 4 == 3 ? 60 : rand() % 8;
+      for (unsigned int b = 0; b < num_blocks; ++b)
+        map.setCost(12 + rand() % 30, 25 + rand() % 30, rand() % 3 == 0 ? 100 : LETHAL_OBSTACLE);
+
+      double state[4] = {5.0, 19.0 + 0.1 * (rand() % 20), 0.2 * (rand() % 5 - 2), 2.0 + rand() % 4};
+      LatticePlan a, b;
+      full.plan(map, state, 0.1 * tick, NULL, 0.5, a);
+      pruned.plan(map, state, 0.1 * tick, NULL, 0.5, b);
+      EXPECT_EQ(a.primitive, b.primitive) << "variant " << variant << " tick " << tick;
+      EXPECT_EQ(a.steering, b.steering);
+      EXPECT_EQ(a.fast, b.fast) << "variant " << variant << " tick " << tick;
+      for (unsigned int p = 0; p < full.getScores().size(); ++p)
+      {
+        if (pruned.isPruned(p))
+          EXPECT_LE(pruned.getScores()[p], full.getScores()[p]);
+        else
+          EXPECT_EQ(pruned.getScores()[p], full.getScores()[p]);
+      }
+      num_pruned += pruned.getNumPruned();
+      EXPECT_EQ(full.getNumPruned(), 0u);
+    }
+    EXPECT_GT(num_pruned, 0u) << "variant " << variant;
+  }
+}
+
+TEST(LatticePlanner, anytime_test)
+{
+  srand(11);
+  LatticePlannerConfig config = defaultConfig();
+  config.use_warm_start = false;
+  config.num_threads = 2;
+  LatticePlanner full, relaxed, hurried;
+  full.configure(config);
+  // a deadline that is never reached scores every primitive, in a different order
+  config.plan_deadline = 10.0;
+  relaxed.configure(config);
+  // a deadline that has passed before the first primitive leaves the coarse pass only
+  config.plan_deadline = 1e-9;
+  hurried.configure(config);
+  straightPath(full.getReferencePath());
+  straightPath(relaxed.getReferencePath());
+  straightPath(hurried.getReferencePath());
+
+  unsigned int num_primitives = full.getPrimitives().size();
+  for (unsigned int tick = 0; tick < 20; ++tick)
+  {
+    Costmap2D map(80, 80, 0.5, 0.0, 0.0);
+    for (unsigned int b = rand() % 8; b > 0; --b)
+      map.setCost(12 + rand() % 30, 25 + rand() % 30, LETHAL_OBSTACLE);
+    double state[4] = {5.0, 19.0 + 0.1 * (rand() % 20), 0.2 * (rand() % 5 - 2), 2.0 + rand() % 4};
+
+    LatticePlan a, b, c;
+    full.plan(map, state, 0.1 * tick, NULL, 0.5, a);
+    relaxed.plan(map, state, 0.1 * tick, NULL, 0.5, b);
+    hurried.plan(map, state, 0.1 * tick, NULL, 0.5, c);
+    EXPECT_EQ(a.primitive, b.primitive) << "tick " << tick;
+    EXPECT_EQ(a.fast, b.fast);
+    EXPECT_EQ(b.num_skipped, 0u);
+    EXPECT_EQ(b.num_scored, num_primitives);
+    EXPECT_EQ(relaxed.getScores(), full.getScores());
+    unsigned int num_relaxed_scored = 0;
+    for (unsigned int p = 0; p < num_primitives; ++p)
+      num_relaxed_scored += relaxed.isScored(p);
+    EXPECT_EQ(num_relaxed_scored, num_primitives);
+
+    // the coarse pass is scored in full, the refinement is cut
+    EXPECT_GT(c.num_skipped, 0u);
+    unsigned int num_hurried_scored = 0;
+    for (unsigned int p = 0; p < num_primitives; ++p)
+      num_hurried_scored += hurried.isScored(p);
+    EXPECT_EQ(num_hurried_scored, c.num_scored);
+    EXPECT_EQ(num_hurried_scored + c.num_skipped, num_primitives);
+    const std::vector<unsigned int>& coarse = hurried.getCoarsePrimitives();
+    for (unsigned int k = 0; k < coarse.size(); ++k)
+      EXPECT_TRUE(hurried.isScored(coarse[k])) << "coarse primitive " << coarse[k];
+    EXPECT_LT(c.primitive, num_primitives);
+    // the scores depend on the steering command kept from the last tick, which only matches on the first one
+    for (unsigned int p = 0; tick == 0 && p < num_primitives; ++p)
+    {
+      if (hurried.getScores()[p] < DBL_MAX)
+      {
+        EXPECT_EQ(hurried.getScores()[p], full.getScores()[p]);
+      }
+    }
+  }
+}
+
+TEST(LatticePlanner, pyramid_test)
+{
+  // the broad phase only skips steps whose cells are all free, so every score matches the full check
+  srand(11);
+  std::vector<geometry_msgs::Point> box(4);
+  box[0].x = box[1].x = 0.6;
+  box[2].x = box[3].x = -0.6;
+  box[0].y = box[3].y = 0.4;
+  box[1].y = box[2].y = -0.4;
+  LatticePlannerConfig config = defaultConfig();
+  config.use_footprint_check = true;
+  LatticePlanner full, broad;
+  full.configure(config);
+  broad.configure(config);
+  straightPath(full.getReferencePath());
+  straightPath(broad.getReferencePath());
+  CostmapPyramid pyramid;
+  pyramid.setNumLevels(4);
+  for (unsigned int tick = 0; tick < 20; ++tick)
+  {
+    // mostly free space with a few soft and lethal cells ahead of the car
+    Costmap2D map(160, 160, 0.25, 0.0, 0.0);
+    unsigned int num_cells = rand() % 12;
+    for (unsigned int c = 0; c < num_cells; ++c)
+      map.setCost(30 + rand() % 80, 50 + rand() % 60, rand() % 2 == 0 ? 1 + rand() % 200 : LETHAL_OBSTACLE);
+    pyramid.rebuild(map);
+    full.setFootprint(box, map.getResolution());
+    broad.setFootprint(box, map.getResolution());
+
+    double state[4] = {5.0, 19.0 + 0.1 * (rand() % 20), 0.2 * (rand() % 5 - 2), 2.0 + rand() % 4};
+    LatticePlan a, b;
+    full.plan(map, state, 0.1 * tick, NULL, 0.5, a);
+    broad.plan(map, state, 0.1 * tick, NULL, 0.5, b, NULL, &pyramid);
+    EXPECT_EQ(a.primitive, b.primitive) << "tick " << tick;
+    EXPECT_EQ(full.getScores(), broad.getScores()) << "tick " << tick;
+  }
+}
+
+TEST(LatticePlanner, allocation_free_tick_test)
+{
+  Costmap2D map(80, 80, 0.5, 0.0, 0.0);
+  for (unsigned int j = 30; j < 40; ++j)
+    map.setCost(30, j, LETHAL_OBSTACLE);
+  std::vector<geometry_msgs::Point> footprint(4);
+  footprint[0].x = 0.3;
+  footprint[0].y = 0.2;
+  footprint[1].x = 0.3;
+  footprint[1].y = -0.2;
+  footprint[2].x = -0.3;
+  footprint[2].y = -0.2;
+  footprint[3].x = -0.3;
+  footprint[3].y = 0.2;
+
+  // the plain selection, the longitudinal product with the footprint check on worker threads, the
+  // search with branch and bound, and the defaults of the node, which follow the last plan on between replans
+  double changed_bounds[4] = {0.0, 0.0, 1.0, 1.0};
+  for (int variant = 0; variant < 4; ++variant)
+  {
+    LatticePlannerConfig config = defaultConfig();
+    config.use_warm_start = variant == 3;
+    if (variant == 1)
+    {
+      config.use_longitudinal_product = true;
+      config.use_footprint_check = true;
+      config.num_threads = 2;
+    }
+    else if (variant == 2)
+    {
+      config.search_depth = 3;
+      config.use_branch_and_bound = true;
+    }
+    else if (variant == 3)
+    {
+      config.use_footprint_check = true;
+    }
+    LatticePlanner planner;
+    planner.configure(config);
+    planner.setFootprint(footprint, map.getResolution());
+    straightPath(planner.getReferencePath());
+
+    // the first tick may still grow buffers that are kept from then on
+    double state[4] = {5.0, 19.0, 0.1, 4.0};
+    LatticePlan plan;
+    planner.plan(map, state, 0.0, NULL, 0.5, plan);
+    unsigned long before = num_allocations.load();
+    unsigned int num_warm_started = 0;
+    for (unsigned int tick = 1; tick < 20; ++tick)
+    {
+      state[0] += 0.4;
+      state[2] = 0.1 * sin(0.5 * tick);
+      planner.plan(map, state, 0.1 * tick, variant == 3 ? changed_bounds : NULL, 0.5, plan);
+      num_warm_started += plan.warm_started;
+    }
+    EXPECT_EQ(num_allocations.load(), before) << "variant " << variant;
+    if (variant == 3)
+    {
+      EXPECT_GT(num_warm_started, 0u);
+      EXPECT_LT(num_warm_started, 19u);
+    }
+  }
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,144 @@
+#include <gtest/gtest.h>
+#include <costmap_2d/lattice_search.h>
+#include <costmap_2d/cost_values.h>
+#include <cmath>
+#include <vector>
+
+using namespace costmap_2d;
+
+namespace
+{
+
+std::vector<double> defaultTargets()
+{
+  std::vector<double> targets;
+  for (int k = 0; k < 13; ++k)
+    targets.push_back((-15.0 + 2.5 * k) * M_PI / 180);
+  return targets;
+}
+
+// a straight reference line along y = 20
+void straightPath(ReferencePath& path)
+{
+  std::vector<double> x, y;
+  for (int k = 0; k <= 40; ++k)
+  {
+    x.push_back(k);
+    y.push_back(20.0);
+  }
+  path.setPoints(x, y, false);
+}
+
+}  // namespace
+
+TEST(LatticeSearch, bucket_queue_test)
+{
+  BucketQueue queue;
+  queue.reset(0.0, 0.5, 4);
+  queue.push(0, 3.2);
+  queue.push(1, 0.3);
+  queue.push(2, 0.1);
+  queue.push(3, 100.0);
+  queue.push(4, 1.7);
+  queue.push(5, 0.3);
+  EXPECT_EQ(queue.size(), 6u);
+
+  unsigned int expected[6] = {2, 1, 5, 4, 0, 3};
+  for (unsigned int k = 0; k < 6; ++k)
+  {
+    unsigned int element;
+    double priority;
+    ASSERT_TRUE(queue.pop(element, priority));
+    EXPECT_EQ(element, expected[k]);
+  }
+  EXPECT_TRUE(queue.empty());
+
+  // popped entries are reused, pushes between pops keep the order, ties leave in push order
+  queue.push(6, 0.8);
+  queue.push(7, 0.6);
+  unsigned int element;
+  double priority;
+  ASSERT_TRUE(queue.pop(element, priority));
+  EXPECT_EQ(element, 7u);
+  queue.push(8, 0.8);
+  queue.push(9, 0.2);
+  unsigned int expected_after[3] = {9, 6, 8};
+  for (unsigned int k = 0; k < 3; ++k)
+  {
+    ASSERT_TRUE(queue.pop(element, priority));
+    EXPECT_EQ(element, expected_after[k]);
+  }
+  EXPECT_FALSE(queue.pop(element, priority));
+}
+
+TEST(LatticeSearch, clear_road_test)
+{
+  Costmap2D map(80, 80, 0.5, 0.0, 0.0);
+  ReferencePath path;
+  straightPath(path);
+  FootprintChecker checker;
+
+  LatticeSearch search;
+  search.configure(defaultTargets(), 0.1, 1.0, 3, 500, 1.0);
+  double start[4] = {5.0, 20.0, 0.0, 5.0};
+  ASSERT_TRUE(search.search(map, checker, path, start, 0.0, 0.0, 25.0, 20.0));
+  EXPECT_TRUE(search.isComplete());
+  ASSERT_EQ(search.getChain().size(), 3u);
+
+  // nothing is in the way, so the chain stays on the line
+  for (unsigned int c = 0; c < 3; ++c)
+    EXPECT_EQ(search.getChain()[c], 6u);
+}
+
+TEST(LatticeSearch, swerve_test)
+{
+  // a block on the line that needs a swerve out and back in
+  Costmap2D map(80, 80, 0.5, 0.0, 0.0);
+  for (unsigned int i = 35; i < 37; ++i)
+  {
+    for (unsigned int j = 39; j < 41; ++j)
+      map.setCost(i, j, LETHAL_OBSTACLE);
+  }
+  ReferencePath path;
+  straightPath(path);
+  FootprintChecker checker;
+
+  LatticeSearch search;
+  search.configure(defaultTargets(), 0.1, 1.0, 3, 2000, 1.0);
+  double start[4] = {5.0, 20.0, 0.0, 5.0};
+  ASSERT_TRUE(search.search(map, checker, path, start, 0.0, 0.0, 25.0, 20.0));
+  EXPECT_TRUE(search.isComplete());
+  EXPECT_NE(search.getChain()[0], 6u);
+
+  std::vector<double> x, y;
+  search.getChainPath(x, y);
+  ASSERT_EQ(x.size(), 33u);
+  for (unsigned int i = 0; i < x.size(); ++i)
+  {
+    unsigned int mx, my;
+    ASSERT_TRUE(map.worldToMap(x[i], y[i], mx, my));
+    EXPECT_NE(map.getCost(mx, my), LETHAL_OBSTACLE);
+  }
+}
+
+TEST(LatticeSearch, node_budget_test)
+{
+  Costmap2D map(80, 80, 0.5, 0.0, 0.0);
+  ReferencePath path;
+  straightPath(path);
+  FootprintChecker checker;
+
+  LatticeSearch search;
+  search.configure(defaultTargets(), 0.1, 1.0, 3, 1, 1.0);
+  double start[4] = {5.0, 20.0, 0.0, 5.0};
+  ASSERT_TRUE(search.search(map, checker, path, start, 0.0, 0.0, 25.0, 20.0));
+  EXPECT_FALSE(search.isComplete());
+  EXPECT_EQ(search.getNumExpanded(), 1u);
+  EXPECT_EQ(search.getChain().size(), 1u);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
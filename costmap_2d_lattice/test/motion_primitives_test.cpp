@@ -0,0 +1,274 @@
+#include <gtest/gtest.h>
+#include <costmap_2d/motion_primitives.h>
+#include <costmap_2d/primitive_cache.h>
+#include <cmath>
+#include <vector>
+
+using namespace costmap_2d;
+
+namespace
+{
+
+std::vector<double> defaultTargets()
+{
+  std::vector<double> targets;
+  for (int k = 0; k < 13; ++k)
+    targets.push_back((-15.0 + 2.5 * k) * M_PI / 180);
+  return targets;
+}
+
+// straightforward integration of one primitive, as the planner did before the set existed
+void referenceRollout(const VehicleModel& model, const double* s0, const std::vector<double>& u_angle,
+                      double u_engine, double ts, std::vector<double>& xs, std::vector<double>& ys)
+{
+  double x = s0[0], y = s0[1], theta = s0[2], v = s0[3];
+  for (unsigned int i = 0; i < u_angle.size(); ++i)
+  {
+    double v_last = v, theta_last = theta;
+    double a_drag = -0.5 * model.front_area * model.drag_coefficient * model.air_density * pow(v_last, 2) / model.mass;
+    theta = theta_last + ts * (v_last / model.wheel_base) * tan(u_angle[i]);
+    v = v_last + ts * (u_engine + a_drag);
+    x = x + ts * v_last * cos(theta_last);
+    y = y + ts * v_last * sin(theta_last);
+    xs.push_back(x);
+    ys.push_back(y);
+  }
+}
+
+}  // namespace
+
+TEST(MotionPrimitives, configure_test)
+{
+  MotionPrimitiveSet set;
+  set.configure(defaultTargets(), 0.1, 2.5);
+
+  EXPECT_EQ(set.size(), 13u);
+  EXPECT_EQ(set.getNumSteps(), 26u);
+  EXPECT_EQ(set.getStraightPrimitive(), 6u);
+  EXPECT_EQ(set.getIndex(0, 1), 13u);
+}
+
+TEST(MotionPrimitives, steering_profile_test)
+{
+  MotionPrimitiveSet set;
+  set.configure(defaultTargets(), 0.1, 2.5);
+  double step = set.getVehicleModel().max_steering_rate * 0.1;
+
+  std::vector<double> profile(set.getNumSteps());
+  set.fillSteeringProfile(0.0, 0.1, &profile[0]);
+  EXPECT_DOUBLE_EQ(profile[0], 0.0);
+  EXPECT_DOUBLE_EQ(profile[1], step);
+  EXPECT_DOUBLE_EQ(profile[2], 2 * step);
+  EXPECT_DOUBLE_EQ(profile.back(), 0.1);
+
+  set.fillSteeringProfile(0.0, 0.0, &profile[0]);
+  for (unsigned int i = 0; i < profile.size(); ++i)
+    EXPECT_DOUBLE_EQ(profile[i], 0.0);
+}
+
+TEST(MotionPrimitives, rollout_matches_reference_test)
+{
+  MotionPrimitiveSet set;
+  std::vector<double> targets = defaultTargets();
+  set.configure(targets, 0.1, 2.5);
+
+  double s0[4] = {1.0, -2.0, 0.3, 4.5};
+  double steering_current = 0.05;
+  std::vector<double> u_engine(set.getNumSteps(), 0.27), u_break(set.getNumSteps(), 0.0);
+  set.rollout(s0, steering_current, &u_engine[0], &u_break[0]);
+
+  for (unsigned int p = 0; p < set.size(); ++p)
+  {
+    std::vector<double> u_angle(set.getNumSteps());
+    set.fillSteeringProfile(steering_current, targets[p], &u_angle[0]);
+    std::vector<double> xs, ys;
+    referenceRollout(set.getVehicleModel(), s0, u_angle, 0.27, 0.1, xs, ys);
+
+    for (unsigned int i = 0; i < set.getNumSteps(); ++i)
+    {
+      EXPECT_NEAR(set.x(p, i), xs[i], 1e-9);
+      EXPECT_NEAR(set.y(p, i), ys[i], 1e-9);
+      EXPECT_DOUBLE_EQ(set.u(p, i), u_angle[i]);
+    }
+  }
+}
+
+TEST(MotionPrimitives, rollout_at_race_speed_test)
+{
+  // many bins and a high speed give the largest heading change per step
+  std::vector<double> targets;
+  for (int k = 0; k < 61; ++k)
+    targets.push_back((-15.0 + 0.5 * k) * M_PI / 180);
+  MotionPrimitiveSet set;
+  set.configure(targets, 0.1, 2.5);
+
+  double s0[4] = {0.0, 0.0, -2.8, 15.0};
+  std::vector<double> u_engine(set.getNumSteps(), 0.0), u_break(set.getNumSteps(), 0.0);
+  set.rollout(s0, -0.2, &u_engine[0], &u_break[0]);
+
+  for (unsigned int p = 0; p < set.size(); p += 5)
+  {
+    std::vector<double> u_angle(set.getNumSteps());
+    set.fillSteeringProfile(-0.2, targets[p], &u_angle[0]);
+    std::vector<double> xs, ys;
+    referenceRollout(set.getVehicleModel(), s0, u_angle, 0.0, 0.1, xs, ys);
+
+    EXPECT_NEAR(set.x(p, set.getNumSteps() - 1), xs.back(), 1e-9);
+    EXPECT_NEAR(set.y(p, set.getNumSteps() - 1), ys.back(), 1e-9);
+  }
+}
+
+TEST(MotionPrimitives, acceleration_product_test)
+{
+  std::vector<double> targets = defaultTargets();
+  std::vector<double> accelerations;
+  accelerations.push_back(0.54);
+  accelerations.push_back(-1.5);
+  accelerations.push_back(-4.0);
+  MotionPrimitiveSet set;
+  set.configure(targets, accelerations, 0.1, 2.5);
+  EXPECT_EQ(set.size(), 39u);
+  EXPECT_EQ(set.getPrimitive(4, 2), 30u);
+  EXPECT_EQ(set.getSteeringIndex(30), 4u);
+  EXPECT_EQ(set.getAccelerationIndex(30), 2u);
+  EXPECT_DOUBLE_EQ(set.getSteeringTarget(30), targets[4]);
+  EXPECT_DOUBLE_EQ(set.getAcceleration(30), -4.0);
+
+  double s0[4] = {1.0, -2.0, 0.3, 4.5};
+  std::vector<double> u_engine(set.getNumSteps(), 0.27), u_break(set.getNumSteps(), 0.0);
+  set.rollout(s0, 0.05, &u_engine[0], &u_break[0]);
+
+  for (unsigned int p = 0; p < set.size(); ++p)
+  {
+    std::vector<double> u_angle(set.getNumSteps());
+    set.fillSteeringProfile(0.05, set.getSteeringTarget(p), &u_angle[0]);
+    std::vector<double> xs, ys;
+    referenceRollout(set.getVehicleModel(), s0, u_angle, 0.27 + set.getAcceleration(p), 0.1, xs, ys);
+
+    // the hardest braking stops the car within the horizon, the reference would reverse
+    unsigned int num_checked = set.getAccelerationIndex(p) == 2 ? 10 : set.getNumSteps();
+    for (unsigned int i = 0; i < num_checked; ++i)
+    {
+      EXPECT_NEAR(set.x(p, i), xs[i], 1e-9);
+      EXPECT_NEAR(set.y(p, i), ys[i], 1e-9);
+      EXPECT_DOUBLE_EQ(set.u(p, i), u_angle[i]);
+    }
+    EXPECT_GE(set.v(p, set.getNumSteps() - 1), 0.0);
+  }
+  EXPECT_DOUBLE_EQ(set.v(set.getPrimitive(0, 2), set.getNumSteps() - 1), 0.0);
+}
+
+TEST(MotionPrimitives, cache_matches_rollout_on_bucket_test)
+{
+  MotionPrimitiveSet set, cached;
+  set.configure(defaultTargets(), 0.1, 2.5);
+  cached.configure(defaultTargets(), 0.1, 2.5);
+
+  std::vector<double> engine_levels(1, 0.0);
+  engine_levels.push_back(0.27);
+  PrimitiveCache cache;
+  cache.build(set, engine_levels, 10.0, 0.5, 0.5 * M_PI / 180);
+  ASSERT_TRUE(cache.isBuilt());
+
+  // start speed and steering angle on a bucket, so only float rounding is left
+  double s0[4] = {3.0, 7.0, 2.1, 4.5};
+  double steering_current = 2.5 * M_PI / 180;
+  std::vector<double> u_engine(set.getNumSteps(), 0.27), u_break(set.getNumSteps(), 0.0);
+  set.rollout(s0, steering_current, &u_engine[0], &u_break[0]);
+  ASSERT_TRUE(cache.transform(s0, steering_current, 0.27, cached));
+
+  for (unsigned int p = 0; p < set.size(); ++p)
+  {
+    for (unsigned int i = 0; i < set.getNumSteps(); ++i)
+    {
+      EXPECT_NEAR(cached.x(p, i), set.x(p, i), 1e-4);
+      EXPECT_NEAR(cached.y(p, i), set.y(p, i), 1e-4);
+      EXPECT_NEAR(cached.theta(p, i), set.theta(p, i), 1e-5);
+      EXPECT_NEAR(cached.v(p, i), set.v(p, i), 1e-12);
+      EXPECT_DOUBLE_EQ(cached.u(p, i), set.u(p, i));
+    }
+  }
+}
+
+TEST(MotionPrimitives, cache_size_cap_test)
+{
+  MotionPrimitiveSet set;
+  set.configure(defaultTargets(), 0.1, 2.5);
+  std::vector<double> engine_levels(1, 0.0);
+  PrimitiveCache cache;
+  EXPECT_TRUE(cache.build(set, engine_levels, 10.0, 0.5, 0.5 * M_PI / 180));
+  EXPECT_TRUE(cache.isBuilt());
+
+  // resolutions whose buckets would not fit, or not even fit an unsigned int, leave the cache empty
+  EXPECT_FALSE(cache.build(set, engine_levels, 10.0, 1e-4, 0.5 * M_PI / 180));
+  EXPECT_FALSE(cache.isBuilt());
+  EXPECT_FALSE(cache.build(set, engine_levels, 10.0, 1e-12, 1e-12));
+  EXPECT_FALSE(cache.isBuilt());
+  EXPECT_FALSE(cache.build(set, engine_levels, 10.0, 0.0, 0.5 * M_PI / 180));
+
+  double s0[4] = {0.0, 0.0, 0.0, 1.0};
+  MotionPrimitiveSet cached = set;
+  EXPECT_FALSE(cache.transform(s0, 0.0, 0.0, cached));
+}
+
+TEST(MotionPrimitives, cache_with_accelerations_test)
+{
+  std::vector<double> accelerations(1, 0.0);
+  accelerations.push_back(-0.5);
+  MotionPrimitiveSet set, cached;
+  set.configure(defaultTargets(), accelerations, 0.1, 2.5);
+  cached.configure(defaultTargets(), accelerations, 0.1, 2.5);
+
+  PrimitiveCache cache;
+  cache.build(set, std::vector<double>(1, 0.27), 10.0, 0.5, 0.5 * M_PI / 180);
+
+  double s0[4] = {3.0, 7.0, 2.1, 4.0};
+  std::vector<double> u_engine(set.getNumSteps(), 0.27), u_break(set.getNumSteps(), 0.0);
+  set.rollout(s0, 0.0, &u_engine[0], &u_break[0]);
+  ASSERT_TRUE(cache.transform(s0, 0.0, 0.27, cached));
+
+  for (unsigned int p = 0; p < set.size(); ++p)
+  {
+    for (unsigned int i = 0; i < set.getNumSteps(); ++i)
+    {
+      EXPECT_NEAR(cached.x(p, i), set.x(p, i), 1e-4);
+      EXPECT_NEAR(cached.y(p, i), set.y(p, i), 1e-4);
+      EXPECT_NEAR(cached.v(p, i), set.v(p, i), 1e-12);
+    }
+  }
+}
+
+TEST(MotionPrimitives, cache_between_buckets_test)
+{
+  MotionPrimitiveSet set, cached;
+  set.configure(defaultTargets(), 0.1, 2.5);
+  cached.configure(defaultTargets(), 0.1, 2.5);
+
+  PrimitiveCache cache;
+  cache.build(set, std::vector<double>(1, 0.0), 10.0, 0.5, 0.5 * M_PI / 180);
+
+  double s0[4] = {-4.0, 1.0, -0.7, 6.3};
+  double steering_current = 0.033;
+  std::vector<double> u_engine(set.getNumSteps(), 0.0), u_break(set.getNumSteps(), 0.0);
+  set.rollout(s0, steering_current, &u_engine[0], &u_break[0]);
+  ASSERT_TRUE(cache.transform(s0, steering_current, 0.0, cached));
+
+  // off-bucket error stays well below a costmap cell
+  unsigned int last = set.getNumSteps() - 1;
+  for (unsigned int p = 0; p < set.size(); ++p)
+  {
+    EXPECT_NEAR(cached.x(p, last), set.x(p, last), 0.1);
+    EXPECT_NEAR(cached.y(p, last), set.y(p, last), 0.1);
+  }
+
+  // inputs the cache was not built for are refused
+  EXPECT_FALSE(cache.transform(s0, steering_current, 0.27, cached));
+  s0[3] = 12.0;
+  EXPECT_FALSE(cache.transform(s0, steering_current, 0.0, cached));
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
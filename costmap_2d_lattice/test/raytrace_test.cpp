@@ -0,0 +1,147 @@
+#include <gtest/gtest.h>
+#include <costmap_2d/costmap_2d.h>
+#include <costmap_2d/cost_values.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <climits>
+
+using namespace costmap_2d;
+
+namespace
+{
+
+// opens the raytracing of Costmap2D to the tests
+class TracingCostmap : public Costmap2D
+{
+public:
+  TracingCostmap(unsigned int size_x, unsigned int size_y) :
+      Costmap2D(size_x, size_y, 0.1, 0.0, 0.0)
+  {
+  }
+
+  void mark(unsigned char value, unsigned int x0, unsigned int y0, unsigned int x1, unsigned int y1,
+            unsigned int max_length)
+  {
+    markLine(value, x0, y0, x1, y1, max_length);
+  }
+
+  // the trace markLine() runs for any other value
+  void traceRamp(unsigned char value, unsigned int x0, unsigned int y0, unsigned int x1, unsigned int y1)
+  {
+    MarkCell marker(costmap_, value);
+    raytraceLine(marker, x0, y0, x1, y1);
+  }
+};
+
+// the cells of a line and the ramp of MarkCell, with a division per step
+void referenceMark(Costmap2D& map, unsigned char value, int x0, int y0, int x1, int y1, unsigned int max_length)
+{
+  int dx = x1 - x0, dy = y1 - y0;
+  unsigned int abs_da = std::max(abs(dx), abs(dy)), abs_db = std::min(abs(dx), abs(dy));
+  int step_a = abs(dx) >= abs(dy) ? 0 : 1;
+  double dist = hypot(dx, dy);
+  double scale = dist == 0.0 ? 1.0 : std::min(1.0, max_length / dist);
+  unsigned int end = std::min((unsigned int)(scale * abs_da), abs_da);
+  int x = x0, y = y0, error_b = abs_da / 2;
+  unsigned char ramp = 0;
+  for (unsigned int i = 0; i <= end; ++i)
+  {
+    if (i < end)
+      ramp = value * i / end;
+    map.setCost(x, y, std::max(map.getCost(x, y), ramp));
+    if (i == end)
+      break;
+    if (step_a == 0)
+      x += dx > 0 ? 1 : -1;
+    else
+      y += dy > 0 ? 1 : -1;
+    error_b += abs_db;
+    if ((unsigned int)error_b >= abs_da)
+    {
+      if (step_a == 0)
+        y += dy > 0 ? 1 : -1;
+      else
+        x += dx > 0 ? 1 : -1;
+      error_b -= abs_da;
+    }
+  }
+}
+
+}  // namespace
+
+TEST(Raytrace, mark_ramp_test)
+{
+  srand(9);
+  TracingCostmap map(60, 50);
+  Costmap2D expected(60, 50, 0.1, 0.0, 0.0);
+  for (int k = 0; k < 2000; ++k)
+  {
+    unsigned int x0 = rand() % 60, y0 = rand() % 50, x1 = rand() % 60, y1 = rand() % 50;
+    unsigned char value = rand() % 256;
+    unsigned int max_length = rand() % 3 == 0 ? rand() % 40 : UINT_MAX;
+    map.mark(value, x0, y0, x1, y1, max_length);
+    referenceMark(expected, value, x0, y0, x1, y1, max_length);
+  }
+  for (unsigned int my = 0; my < 50; ++my)
+  {
+    for (unsigned int mx = 0; mx < 60; ++mx)
+      ASSERT_EQ(map.getCost(mx, my), expected.getCost(mx, my)) << "cell " << mx << ", " << my;
+  }
+}
+
+TEST(Raytrace, ramp_end_test)
+{
+  // 10 steps to 200: 0, 20, ..., 180 and the last cell repeats 180
+  TracingCostmap map(20, 5);
+  map.mark(200, 0, 2, 10, 2, UINT_MAX);
+  for (unsigned int mx = 0; mx < 10; ++mx)
+    EXPECT_EQ(map.getCost(mx, 2), mx * 20);
+  EXPECT_EQ(map.getCost(10, 2), 180);
+  EXPECT_EQ(map.getCost(11, 2), FREE_SPACE);
+
+  // cut off after 4 steps of the 10
+  TracingCostmap short_map(20, 5);
+  short_map.mark(200, 0, 2, 10, 2, 4);
+  EXPECT_EQ(short_map.getCost(3, 2), 150);
+  EXPECT_EQ(short_map.getCost(4, 2), 150);
+  EXPECT_EQ(short_map.getCost(5, 2), FREE_SPACE);
+
+  // a line of a single cell
+  TracingCostmap point(5, 5);
+  point.mark(200, 2, 2, 2, 2, UINT_MAX);
+  EXPECT_EQ(point.getCost(2, 2), FREE_SPACE);
+}
+
+TEST(Raytrace, free_space_mark_test)
+{
+  // marking FREE_SPACE skips the trace, which would not have changed a cell either
+  srand(4);
+  TracingCostmap map(30, 30), traced(30, 30);
+  for (unsigned int my = 0; my < 30; ++my)
+  {
+    for (unsigned int mx = 0; mx < 30; ++mx)
+    {
+      unsigned char cost = rand() % 256;
+      map.setCost(mx, my, cost);
+      traced.setCost(mx, my, cost);
+    }
+  }
+  for (int k = 0; k < 200; ++k)
+  {
+    unsigned int x0 = rand() % 30, y0 = rand() % 30, x1 = rand() % 30, y1 = rand() % 30;
+    map.mark(FREE_SPACE, x0, y0, x1, y1, UINT_MAX);
+    traced.traceRamp(FREE_SPACE, x0, y0, x1, y1);
+  }
+  for (unsigned int my = 0; my < 30; ++my)
+  {
+    for (unsigned int mx = 0; mx < 30; ++mx)
+      ASSERT_EQ(map.getCost(mx, my), traced.getCost(mx, my)) << "cell " << mx << ", " << my;
+  }
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
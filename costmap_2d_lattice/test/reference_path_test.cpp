@@ -0,0 +1,140 @@
+#include <gtest/gtest.h>
+#include <costmap_2d/reference_path.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using namespace costmap_2d;
+
+namespace
+{
+
+// a circle of radius 50 m sampled every degree, without repeating the first point
+void circle(std::vector<double>& x, std::vector<double>& y)
+{
+  for (int k = 0; k < 360; ++k)
+  {
+    x.push_back(50.0 * cos(k * M_PI / 180));
+    y.push_back(50.0 * sin(k * M_PI / 180));
+  }
+}
+
+}  // namespace
+
+TEST(ReferencePath, project_test)
+{
+  std::vector<double> x, y;
+  circle(x, y);
+  ReferencePath path;
+  path.setPoints(x, y, true);
+  ASSERT_TRUE(path.isClosed());
+
+  double s, distance;
+  ASSERT_TRUE(path.project(55.0, 0.1, s, distance));
+  EXPECT_NEAR(distance, 5.0, 0.01);
+  EXPECT_NEAR(s, 0.1, 0.05);
+
+  // the center is far from every cell holding a segment
+  ASSERT_TRUE(path.project(0.0, 0.0, s, distance));
+  EXPECT_NEAR(distance, 50.0, 0.05);
+
+  // far outside of the grid
+  ASSERT_TRUE(path.project(0.0, -500.0, s, distance));
+  EXPECT_NEAR(distance, 450.0, 0.05);
+  EXPECT_NEAR(s, path.getLength() * 0.75, 0.5);
+
+  // against a linear scan over all points
+  for (int q = 0; q < 50; ++q)
+  {
+    double qx = -70.0 + 2.9 * q, qy = 40.0 - 1.7 * q;
+    double best = 1e9;
+    for (unsigned int i = 0; i < x.size(); ++i)
+    {
+      unsigned int j = (i + 1) % x.size();
+      double dx = x[j] - x[i], dy = y[j] - y[i];
+      double t = std::min(std::max(((qx - x[i]) * dx + (qy - y[i]) * dy) / (dx * dx + dy * dy), 0.0), 1.0);
+      best = std::min(best, hypot(x[i] + t * dx - qx, y[i] + t * dy - qy));
+    }
+    ASSERT_TRUE(path.project(qx, qy, s, distance));
+    EXPECT_NEAR(distance, best, 1e-9);
+  }
+}
+
+TEST(ReferencePath, point_at_test)
+{
+  std::vector<double> x, y;
+  circle(x, y);
+  ReferencePath path;
+  path.setPoints(x, y, true);
+  EXPECT_NEAR(path.getLength(), 2 * M_PI * 50.0, 0.05);
+
+  double px, py;
+  ASSERT_TRUE(path.pointAt(path.getLength() / 4, px, py));
+  EXPECT_NEAR(px, 0.0, 0.05);
+  EXPECT_NEAR(py, 50.0, 0.05);
+
+  // lookahead past the end of a lap wraps around on a loop
+  ASSERT_TRUE(path.pointAt(3 * path.getLength() + path.getLength() / 4, px, py));
+  EXPECT_NEAR(px, 0.0, 0.05);
+  EXPECT_NEAR(py, 50.0, 0.05);
+  ASSERT_TRUE(path.pointAt(path.getLength() - 0.5, px, py));
+  EXPECT_NEAR(hypot(px - 50.0, py), 0.5, 0.01);
+
+  // and is clamped to the ends of an open path
+  ReferencePath open_path;
+  open_path.setPoints(x, y, false);
+  ASSERT_TRUE(open_path.pointAt(1e4, px, py));
+  EXPECT_DOUBLE_EQ(px, x.back());
+  EXPECT_DOUBLE_EQ(py, y.back());
+  ASSERT_TRUE(open_path.pointAt(-3.0, px, py));
+  EXPECT_DOUBLE_EQ(px, x.front());
+}
+
+TEST(ReferencePath, project_from_test)
+{
+  std::vector<double> x, y;
+  circle(x, y);
+  ReferencePath path;
+  path.setPoints(x, y, true);
+
+  // walking along the loop from the arc length of the previous point finds as close a point as the full search,
+  // also across the end of a lap in both directions
+  double s_walk = 0.0;
+  for (int q = 0; q < 800; ++q)
+  {
+    double angle = (q < 400 ? q : 800 - q) * 0.02 - 1.0;
+    double qx = (50.0 + 3.0 * sin(q * 0.1)) * cos(angle), qy = (50.0 + 3.0 * sin(q * 0.1)) * sin(angle);
+    double s, distance, walk_distance;
+    ASSERT_TRUE(path.project(qx, qy, s, distance));
+    ASSERT_TRUE(path.projectFrom(s_walk, qx, qy, s_walk, walk_distance));
+    EXPECT_NEAR(walk_distance, distance, 1e-9);
+    double px, py;
+    ASSERT_TRUE(path.pointAt(s_walk, px, py));
+    EXPECT_NEAR(hypot(px - qx, py - qy), walk_distance, 1e-6);
+  }
+
+  // an open path stops walking at its ends instead of crossing the gap between them
+  ReferencePath open_path;
+  open_path.setPoints(x, y, false);
+  double s, distance;
+  ASSERT_TRUE(open_path.projectFrom(10.0, 60.0, -10.0, s, distance));
+  EXPECT_DOUBLE_EQ(s, 0.0);
+  ASSERT_TRUE(open_path.projectFrom(open_path.getLength() - 10.0, 60.0, 10.0, s, distance));
+  EXPECT_DOUBLE_EQ(s, open_path.getLength());
+}
+
+TEST(ReferencePath, empty_test)
+{
+  ReferencePath path;
+  double s, distance, px, py;
+  EXPECT_FALSE(path.project(0.0, 0.0, s, distance));
+  EXPECT_FALSE(path.pointAt(0.0, px, py));
+  EXPECT_FALSE(path.projectFrom(0.0, 0.0, 0.0, s, distance));
+  EXPECT_FALSE(path.load("/nonexistent/traj_opt.csv", 3.0));
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,53 @@
+#include <gtest/gtest.h>
+#include <costmap_2d/worker_pool.h>
+#include <boost/bind.hpp>
+#include <vector>
+
+using namespace costmap_2d;
+
+namespace
+{
+
+void square(std::vector<int>* results, std::vector<int>* calls, unsigned int index)
+{
+  (*results)[index] = index * index;
+  ++(*calls)[index];
+}
+
+}  // namespace
+
+TEST(WorkerPool, runs_every_task_once_test)
+{
+  WorkerPool pool(3);
+  EXPECT_EQ(pool.getNumThreads(), 3u);
+
+  // many short batches in a row, like the planner ticks
+  for (unsigned int batch = 0; batch < 200; ++batch)
+  {
+    unsigned int num_tasks = 1 + batch % 17;
+    std::vector<int> results(num_tasks, -1), calls(num_tasks, 0);
+    pool.run(num_tasks, boost::bind(square, &results, &calls, _1));
+    for (unsigned int i = 0; i < num_tasks; ++i)
+    {
+      EXPECT_EQ(results[i], (int)(i * i));
+      EXPECT_EQ(calls[i], 1);
+    }
+  }
+}
+
+TEST(WorkerPool, runs_on_caller_without_threads_test)
+{
+  WorkerPool pool(0);
+  std::vector<int> results(5, -1), calls(5, 0);
+  pool.run(5, boost::bind(square, &results, &calls, _1));
+  for (unsigned int i = 0; i < 5; ++i)
+    EXPECT_EQ(results[i], (int)(i * i));
+
+  pool.run(0, boost::bind(square, &results, &calls, _1));
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}